@@ -17,6 +17,7 @@ ExternalProject_Add(minilzo
     BUILD_COMMAND ${CMAKE_COMMAND} --build . --target minilzo
     COMMAND ${CMAKE_COMMAND} -E make_directory ${TARGET_LIBS}
     COMMAND ${CMAKE_COMMAND} -E copy ${TARGET_PREFIX}/src/minilzo/libminilzo${CMAKE_STATIC_LIBRARY_SUFFIX} ${TARGET_LIBS}/libminilzo${CMAKE_STATIC_LIBRARY_SUFFIX}
+    COMMAND ${CMAKE_COMMAND} -E copy ${TARGET_PREFIX}/src/minilzo/libminilzo${CMAKE_STATIC_LIBRARY_SUFFIX} ${TARGET_LIBS}/libmdictminilzo${CMAKE_STATIC_LIBRARY_SUFFIX}
 )
 
 # define imported library libminilzo
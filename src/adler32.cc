@@ -129,9 +129,9 @@ void Adler32::TruncatedFinal(byte *hash, size_t size) {
   Reset();
 }
 
-uint32_t adler32checksum(const unsigned char *data, uint32_t len) {
+uint32_t adler32checksum(const unsigned char *data, uint64_t len) {
   Adler32 adler32Hasher;
-  adler32Hasher.Update(data, len);
+  adler32Hasher.Update(data, static_cast<size_t>(len));
   char *hash = (char *)calloc(4, sizeof(char));
   adler32Hasher.Final(reinterpret_cast<byte *>(hash));
   uint32_t chksum = Adler32::be_bin_to_u32((unsigned char *)hash);
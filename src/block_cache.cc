@@ -0,0 +1,505 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#include "include/block_cache.h"
+
+#include <algorithm>
+
+#include "include/lzo_wrapper.h"
+
+namespace mdict {
+
+// ------------------------------------------
+// frequency_sketch
+// ------------------------------------------
+
+frequency_sketch::frequency_sketch(uint64_t expected_entries) {
+  // one 64 bit word (16 counters) per expected entry, power of two
+  uint64_t words = 16;
+  while (words < expected_entries && words < (1ULL << 24)) {
+    words <<= 1;
+  }
+  table.assign(words, 0);
+  counter_mask = words * 16 - 1;
+  sample_size = 10 * words * 16;
+}
+
+size_t frequency_sketch::index_of(uint64_t hash, int row) const {
+  static const uint64_t seeds[depth] = {
+      0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL,
+      0xcbf29ce484222325ULL};
+  uint64_t h = (hash ^ seeds[row]) * 0x9e3779b97f4a7c15ULL;
+  h ^= h >> 32;
+  return static_cast<size_t>(h & counter_mask);
+}
+
+void frequency_sketch::increment(uint64_t hash) {
+  bool added = false;
+  for (int i = 0; i < depth; i++) {
+    size_t c = index_of(hash, i);
+    uint64_t &word = table[c >> 4];
+    int shift = static_cast<int>(c & 15) << 2;
+    if (((word >> shift) & 0xf) != 0xf) {
+      word += 1ULL << shift;
+      added = true;
+    }
+  }
+  if (added && ++additions >= sample_size) {
+    reset();
+  }
+}
+
+int frequency_sketch::estimate(uint64_t hash) const {
+  int freq = 15;
+  for (int i = 0; i < depth; i++) {
+    size_t c = index_of(hash, i);
+    int shift = static_cast<int>(c & 15) << 2;
+    freq = std::min(freq, static_cast<int>((table[c >> 4] >> shift) & 0xf));
+  }
+  return freq;
+}
+
+void frequency_sketch::reset() {
+  // halve every counter
+  for (auto &word : table) {
+    word = (word >> 1) & 0x7777777777777777ULL;
+  }
+  additions /= 2;
+}
+
+// ------------------------------------------
+// block_cache
+// ------------------------------------------
+
+block_cache::block_cache(uint64_t capacity_bytes, mdict_cache_policy_t policy,
+                         uint64_t warm_capacity_bytes)
+    : capacity_bytes(capacity_bytes),
+      cache_policy(policy),
+      // record blocks are typically 16..64KB
+      sketch(std::max<uint64_t>(capacity_bytes / 16384, 64)),
+      warm_capacity(warm_capacity_bytes) {
+  if (cache_policy == MDICT_CACHE_TINYLFU) {
+    window_capacity = std::max<uint64_t>(capacity_bytes / 100, 1);
+    protected_capacity = (capacity_bytes - window_capacity) * 8 / 10;
+  } else {
+    window_capacity = capacity_bytes;
+    protected_capacity = 0;
+  }
+  clock_hand = window_lru.end();
+}
+
+block_cache::node_list &block_cache::list_of(segment s) {
+  switch (s) {
+    case PROBATION:
+      return probation_lru;
+    case PROTECTED:
+      return protected_lru;
+    default:
+      return window_lru;
+  }
+}
+
+block_ptr block_cache::get(const block_key &key, bool scan) {
+  std::shared_ptr<const std::vector<uint8_t>> packed;
+  uint64_t raw_size = 0;
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!scan && cache_policy == MDICT_CACHE_TINYLFU) {
+      sketch.increment(block_key_hash64(key));
+    }
+    // counters live as long as the dictionary has blocks or a reservation,
+    // a miss must not bring back an entry erase_dict() removed
+    auto u = usage.find(key.dict_id);
+    auto it = index.find(key);
+    if (it != index.end()) {
+      hits++;
+      if (u != usage.end()) {
+        u->second.hits++;
+      }
+      if (!scan) {
+        on_hit(it->second);
+      }
+      return it->second->block;
+    }
+    auto w = warm_index.find(key);
+    if (w == warm_index.end()) {
+      misses++;
+      if (u != usage.end()) {
+        u->second.misses++;
+      }
+      return nullptr;
+    }
+    packed = w->second->packed;
+    raw_size = w->second->raw_size;
+  }
+
+  // decompress outside the lock, then offer the block to the hot tier
+  auto block = std::make_shared<std::vector<uint8_t>>(raw_size);
+  bool decoded = lzo_mem_uncompress(block->data(), raw_size, packed->data(),
+                                    packed->size());
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto u = usage.find(key.dict_id);
+    auto w = warm_index.find(key);
+    // the entry may have been evicted or replaced meanwhile
+    bool same = w != warm_index.end() && w->second->packed == packed;
+    if (!decoded) {
+      // a bad entry would fail again, drop it
+      if (same) {
+        warm_used -= w->second->charge;
+        warm_lru.erase(w->second);
+        warm_index.erase(w);
+      }
+      misses++;
+      if (u != usage.end()) {
+        u->second.misses++;
+      }
+      return nullptr;
+    }
+    warm_hits++;
+    if (u != usage.end()) {
+      u->second.warm_hits++;
+    }
+    if (same && !scan) {
+      warm_lru.splice(warm_lru.begin(), warm_lru, w->second);
+    }
+  }
+  this->put(key, block, scan);
+  return block;
+}
+
+void block_cache::on_hit(node_list::iterator it) {
+  switch (cache_policy) {
+    case MDICT_CACHE_CLOCK:
+      it->referenced = true;
+      break;
+    case MDICT_CACHE_TINYLFU:
+      if (it->seg == PROBATION) {
+        // promote, demote the protected tail if it overflows
+        protected_lru.splice(protected_lru.begin(), probation_lru, it);
+        it->seg = PROTECTED;
+        segment_bytes[PROBATION] -= it->charge;
+        segment_bytes[PROTECTED] += it->charge;
+        while (segment_bytes[PROTECTED] > protected_capacity &&
+               protected_lru.size() > 1) {
+          auto last = std::prev(protected_lru.end());
+          probation_lru.splice(probation_lru.begin(), protected_lru, last);
+          last->seg = PROBATION;
+          segment_bytes[PROTECTED] -= last->charge;
+          segment_bytes[PROBATION] += last->charge;
+        }
+      } else {
+        node_list &l = list_of(it->seg);
+        l.splice(l.begin(), l, it);
+      }
+      break;
+    default:
+      window_lru.splice(window_lru.begin(), window_lru, it);
+      break;
+  }
+}
+
+bool block_cache::contains(const block_key &key) {
+  std::lock_guard<std::mutex> lock(mtx);
+  return index.count(key) != 0;
+}
+
+void block_cache::put(const block_key &key, block_ptr block, bool scan) {
+  if (scan || !block) {
+    return;
+  }
+  uint64_t charge = charge_of(block);
+  std::vector<std::pair<block_key, block_ptr>> victims;
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (charge > capacity_bytes) {
+      return;
+    }
+    auto found = index.find(key);
+    if (found != index.end()) {
+      // same block decoded twice by concurrent readers, keep the cached copy
+      return;
+    }
+
+    node_list::iterator pos;
+    if (cache_policy == MDICT_CACHE_CLOCK) {
+      // behind the hand, the last to be swept
+      pos = window_lru.insert(
+          clock_hand, node{key, std::move(block), charge, WINDOW, false});
+    } else {
+      pos = window_lru.insert(
+          window_lru.begin(),
+          node{key, std::move(block), charge, WINDOW, false});
+    }
+    segment_bytes[WINDOW] += charge;
+    index.emplace(key, pos);
+    dict_usage &u = usage[key.dict_id];
+    u.bytes += charge;
+    u.entries++;
+    maintain();
+    victims.swap(pending_demote);
+  }
+  demote(victims);
+}
+
+void block_cache::demote(
+    std::vector<std::pair<block_key, block_ptr>> &victims) {
+  for (auto &victim : victims) {
+    const block_ptr &raw = victim.second;
+    auto packed = std::make_shared<const std::vector<uint8_t>>(
+        lzo_mem_compress(raw->data(), raw->size()));
+    if (packed->empty() || packed->size() >= raw->size()) {
+      // incompressible, the warm tier would not save anything
+      continue;
+    }
+    uint64_t charge = packed->size() + 96;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (charge > warm_capacity || warm_index.count(victim.first) != 0) {
+      continue;
+    }
+    warm_lru.push_front(warm_node{victim.first, packed, raw->size(), charge});
+    warm_index.emplace(victim.first, warm_lru.begin());
+    warm_used += charge;
+    while (warm_used > warm_capacity) {
+      auto last = std::prev(warm_lru.end());
+      warm_used -= last->charge;
+      warm_index.erase(last->key);
+      warm_lru.erase(last);
+    }
+  }
+}
+
+void block_cache::remove(node_list::iterator it) {
+  if (warm_capacity > 0 && warm_index.count(it->key) == 0) {
+    pending_demote.emplace_back(it->key, it->block);
+  }
+  segment_bytes[it->seg] -= it->charge;
+  dict_usage &u = usage[it->key.dict_id];
+  u.bytes -= it->charge;
+  u.entries--;
+  if (u.entries == 0 && u.reserved == 0) {
+    usage.erase(it->key.dict_id);
+  }
+  index.erase(it->key);
+  if (it == clock_hand) {
+    ++clock_hand;
+  }
+  list_of(it->seg).erase(it);
+}
+
+void block_cache::evict(node_list::iterator it) {
+  usage[it->key.dict_id].evictions++;
+  evictions++;
+  remove(it);
+}
+
+bool block_cache::is_reserved(const node &n) {
+  auto u = usage.find(n.key.dict_id);
+  return u != usage.end() && u->second.reserved > 0 &&
+         u->second.bytes <= u->second.reserved;
+}
+
+block_cache::node_list::iterator block_cache::victim_of(node_list &l) {
+  for (auto it = l.end(); it != l.begin();) {
+    --it;
+    if (!is_reserved(*it)) {
+      return it;
+    }
+  }
+  return l.end();
+}
+
+block_cache::node_list::iterator block_cache::main_victim() {
+  auto victim = victim_of(probation_lru);
+  if (victim != probation_lru.end()) {
+    return victim;
+  }
+  victim = victim_of(protected_lru);
+  if (victim != protected_lru.end()) {
+    return victim;
+  }
+  // everything is reserved, fall back to plain LRU order
+  return probation_lru.empty() ? std::prev(protected_lru.end())
+                               : std::prev(probation_lru.end());
+}
+
+void block_cache::maintain() {
+  if (cache_policy == MDICT_CACHE_LRU) {
+    while (segment_bytes[WINDOW] > capacity_bytes) {
+      auto victim = victim_of(window_lru);
+      evict(victim != window_lru.end() ? victim : std::prev(window_lru.end()));
+    }
+    return;
+  }
+
+  if (cache_policy == MDICT_CACHE_CLOCK) {
+    size_t passed = 0;
+    while (segment_bytes[WINDOW] > capacity_bytes) {
+      if (clock_hand == window_lru.end()) {
+        clock_hand = window_lru.begin();
+      }
+      // reserved blocks get a second chance too, unless nothing else is left
+      if (clock_hand->referenced ||
+          (is_reserved(*clock_hand) && passed++ < 2 * window_lru.size())) {
+        clock_hand->referenced = false;
+        ++clock_hand;
+        continue;
+      }
+      evict(clock_hand);
+    }
+    return;
+  }
+
+  // W-TinyLFU, blocks overflowing the window compete for the main segment
+  uint64_t main_capacity = capacity_bytes - window_capacity;
+  while (segment_bytes[WINDOW] > window_capacity) {
+    auto candidate = std::prev(window_lru.end());
+    uint64_t main_used = segment_bytes[PROBATION] + segment_bytes[PROTECTED];
+
+    if (candidate->charge > main_capacity) {
+      evict(candidate);
+      continue;
+    }
+    if (main_used + candidate->charge > main_capacity) {
+      // the candidate has to beat the block it would replace, unless its
+      // dictionary is below its reservation
+      auto victim = main_victim();
+      if (!is_reserved(*candidate) &&
+          sketch.estimate(block_key_hash64(candidate->key)) <=
+              sketch.estimate(block_key_hash64(victim->key))) {
+        evict(candidate);
+        continue;
+      }
+      while (main_used + candidate->charge > main_capacity) {
+        victim = main_victim();
+        main_used -= victim->charge;
+        evict(victim);
+      }
+    }
+
+    probation_lru.splice(probation_lru.begin(), window_lru, candidate);
+    candidate->seg = PROBATION;
+    segment_bytes[WINDOW] -= candidate->charge;
+    segment_bytes[PROBATION] += candidate->charge;
+  }
+}
+
+void block_cache::erase_dict(uint64_t dict_id) {
+  std::lock_guard<std::mutex> lock(mtx);
+  for (node_list *l : {&window_lru, &probation_lru, &protected_lru}) {
+    for (auto it = l->begin(); it != l->end();) {
+      auto cur = it++;
+      if (cur->key.dict_id == dict_id) {
+        remove(cur);
+      }
+    }
+  }
+  pending_demote.clear();
+  for (auto it = warm_lru.begin(); it != warm_lru.end();) {
+    auto cur = it++;
+    if (cur->key.dict_id == dict_id) {
+      warm_used -= cur->charge;
+      warm_index.erase(cur->key);
+      warm_lru.erase(cur);
+    }
+  }
+  auto u = usage.find(dict_id);
+  if (u == usage.end()) {
+    return;
+  }
+  if (u->second.reserved == 0) {
+    usage.erase(u);
+    return;
+  }
+  // the reservation is a setting, only the counters restart
+  uint64_t reserved = u->second.reserved;
+  u->second = dict_usage{};
+  u->second.reserved = reserved;
+}
+
+mdict_cache_stats_t block_cache::stats() {
+  std::lock_guard<std::mutex> lock(mtx);
+  mdict_cache_stats_t s{};
+  s.hits = hits;
+  s.misses = misses;
+  s.evictions = evictions;
+  s.entries = index.size();
+  s.bytes = segment_bytes[WINDOW] + segment_bytes[PROBATION] +
+            segment_bytes[PROTECTED];
+  s.capacity = capacity_bytes;
+  s.warm_hits = warm_hits;
+  s.warm_entries = warm_index.size();
+  s.warm_bytes = warm_used;
+  s.warm_capacity = warm_capacity;
+  return s;
+}
+
+void block_cache::reserve(uint64_t dict_id, uint64_t bytes) {
+  std::lock_guard<std::mutex> lock(mtx);
+  if (bytes > 0) {
+    usage[dict_id].reserved = bytes;
+    return;
+  }
+  auto it = usage.find(dict_id);
+  if (it != usage.end()) {
+    it->second.reserved = 0;
+    if (it->second.entries == 0) {
+      usage.erase(it);
+    }
+  }
+}
+
+mdict_cache_stats_t block_cache::dict_stats(uint64_t dict_id) {
+  std::lock_guard<std::mutex> lock(mtx);
+  mdict_cache_stats_t s{};
+  auto it = usage.find(dict_id);
+  if (it == usage.end()) {
+    return s;
+  }
+  const dict_usage &u = it->second;
+  s.hits = u.hits;
+  s.misses = u.misses;
+  s.evictions = u.evictions;
+  s.entries = u.entries;
+  s.bytes = u.bytes;
+  s.capacity = u.reserved;
+  s.warm_hits = u.warm_hits;
+  return s;
+}
+
+static std::mutex shared_mtx;
+static std::shared_ptr<block_cache> shared_cache;
+
+std::shared_ptr<block_cache> block_cache::with_budget(
+    uint64_t budget_bytes, mdict_cache_policy_t policy,
+    unsigned int warm_percent) {
+  uint64_t warm = budget_bytes / 100 *
+                  std::min<unsigned int>(warm_percent,
+                                         MDICT_MAX_WARM_CACHE_PERCENT);
+  return std::make_shared<block_cache>(budget_bytes - warm, policy, warm);
+}
+
+std::shared_ptr<block_cache> block_cache::shared() {
+  std::lock_guard<std::mutex> lock(shared_mtx);
+  if (!shared_cache) {
+    shared_cache = with_budget(MDICT_DEFAULT_SHARED_BLOCK_CACHE_BYTES,
+                               MDICT_CACHE_TINYLFU,
+                               MDICT_DEFAULT_WARM_CACHE_PERCENT);
+  }
+  return shared_cache;
+}
+
+void block_cache::configure_shared(uint64_t budget_bytes,
+                                   mdict_cache_policy_t policy,
+                                   unsigned int warm_percent) {
+  std::lock_guard<std::mutex> lock(shared_mtx);
+  shared_cache = with_budget(budget_bytes, policy, warm_percent);
+}
+
+}  // namespace mdict
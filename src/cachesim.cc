@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+/**
+ * mdict_cachesim: block cache sizing by query log replay
+ *
+ * every query of the log is resolved to the key block and record block a
+ * lookup would read (Mdict::resolve_blocks, index only, nothing is
+ * decompressed), then the resulting block trace is replayed against the
+ * block_cache of the library for each policy and capacity. the output is a
+ * CSV miss-ratio curve:
+ *
+ *   policy,capacity_bytes,requests,hits,misses,miss_ratio,requested_bytes,
+ *   missed_bytes,byte_miss_ratio
+ *
+ * missed_bytes is the amount of data that had to be decompressed again, the
+ * cost the cache budget is meant to save.
+ */
+
+#include <unistd.h>  // for getopt
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "include/block_cache.h"
+#include "include/mdict.h"
+
+struct sim_result {
+  uint64_t requests = 0;
+  uint64_t hits = 0;
+  uint64_t requested_bytes = 0;
+  uint64_t missed_bytes = 0;
+};
+
+void print_usage(const char *program_name) {
+  std::cout
+      << "Usage: " << program_name
+      << " [options] <dictionary_file> <query_log>\n"
+      << "Options:\n"
+      << "  -p <policies>  Comma separated policies: lru,clock,tinylfu\n"
+      << "                 (default: all)\n"
+      << "  -s <sizes>     Comma separated capacities in KB\n"
+      << "                 (default: 256 doubling up to 262144)\n"
+      << "  -h             Display this help message\n"
+      << "\n"
+      << "The query log holds one query per line. Output is CSV on stdout.\n";
+}
+
+std::vector<std::string> split(const std::string &s, char sep) {
+  std::vector<std::string> parts;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, sep)) {
+    if (!item.empty()) {
+      parts.push_back(item);
+    }
+  }
+  return parts;
+}
+
+bool parse_policy(const std::string &name, mdict_cache_policy_t &policy) {
+  if (name == "lru") {
+    policy = MDICT_CACHE_LRU;
+  } else if (name == "clock") {
+    policy = MDICT_CACHE_CLOCK;
+  } else if (name == "tinylfu") {
+    policy = MDICT_CACHE_TINYLFU;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * replay the trace, block contents are never materialized: blocks of the
+ * same size share one buffer, the cache only looks at their size
+ */
+sim_result replay(const std::vector<mdict::block_ref> &trace,
+                  mdict_cache_policy_t policy, uint64_t capacity) {
+  std::map<uint64_t, mdict::block_ptr> buffers;
+  mdict::block_cache cache(capacity, policy);
+  sim_result r;
+  for (const auto &ref : trace) {
+    mdict::block_key key{0, static_cast<uint8_t>(ref.kind), ref.block_id};
+    r.requests++;
+    r.requested_bytes += ref.decompressed_size;
+    if (cache.get(key)) {
+      r.hits++;
+      continue;
+    }
+    r.missed_bytes += ref.decompressed_size;
+    mdict::block_ptr &buf = buffers[ref.decompressed_size];
+    if (!buf) {
+      buf = std::make_shared<const std::vector<uint8_t>>(ref.decompressed_size);
+    }
+    cache.put(key, buf);
+  }
+  return r;
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::string> policy_names = {"lru", "clock", "tinylfu"};
+  std::vector<uint64_t> sizes;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "p:s:h")) != -1) {
+    switch (opt) {
+      case 'p':
+        policy_names = split(optarg, ',');
+        break;
+      case 's':
+        for (const auto &kb : split(optarg, ',')) {
+          sizes.push_back(std::stoull(kb) << 10);
+        }
+        break;
+      case 'h':
+        print_usage(argv[0]);
+        return 0;
+      default:
+        print_usage(argv[0]);
+        return 1;
+    }
+  }
+
+  if (optind + 2 > argc) {
+    std::cerr << "Error: Dictionary file and query log are required\n";
+    print_usage(argv[0]);
+    return 1;
+  }
+  if (sizes.empty()) {
+    for (uint64_t kb = 256; kb <= 262144; kb <<= 1) {
+      sizes.push_back(kb << 10);
+    }
+  }
+
+  std::vector<mdict_cache_policy_t> policies;
+  for (const auto &name : policy_names) {
+    mdict_cache_policy_t p;
+    if (!parse_policy(name, p)) {
+      std::cerr << "Error: unknown policy " << name << "\n";
+      return 1;
+    }
+    policies.push_back(p);
+  }
+
+  mdict::Mdict dict(argv[optind]);
+  try {
+    dict.init();
+  } catch (std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return 1;
+  }
+
+  std::ifstream log(argv[optind + 1]);
+  if (!log) {
+    std::cerr << "Error: cannot open " << argv[optind + 1] << "\n";
+    return 1;
+  }
+
+  // resolve every query once
+  std::vector<mdict::block_ref> trace;
+  uint64_t queries = 0;
+  uint64_t not_found = 0;
+  std::string line;
+  while (std::getline(log, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty()) {
+      continue;
+    }
+    queries++;
+    auto refs = dict.resolve_blocks(line);
+    if (refs.size() < 2) {
+      not_found++;
+    }
+    trace.insert(trace.end(), refs.begin(), refs.end());
+  }
+  std::cerr << "queries: " << queries << ", not found: " << not_found
+            << ", block requests: " << trace.size() << "\n";
+
+  std::cout << "policy,capacity_bytes,requests,hits,misses,miss_ratio,"
+               "requested_bytes,missed_bytes,byte_miss_ratio\n";
+  for (size_t i = 0; i < policies.size(); i++) {
+    for (uint64_t capacity : sizes) {
+      sim_result r = replay(trace, policies[i], capacity);
+      uint64_t misses = r.requests - r.hits;
+      std::cout << policy_names[i] << "," << capacity << "," << r.requests
+                << "," << r.hits << "," << misses << ","
+                << (r.requests ? double(misses) / r.requests : 0.0) << ","
+                << r.requested_bytes << "," << r.missed_bytes << ","
+                << (r.requested_bytes
+                        ? double(r.missed_bytes) / r.requested_bytes
+                        : 0.0)
+                << "\n";
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#include "include/content_store.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace mdict {
+
+std::string content_hash_hex(const content_hash &hash) {
+  static const char digits[] = "0123456789abcdef";
+  std::string hex(32, '0');
+  for (size_t i = 0; i < hash.size(); i++) {
+    hex[2 * i] = digits[hash[i] >> 4];
+    hex[2 * i + 1] = digits[hash[i] & 0xf];
+  }
+  return hex;
+}
+
+// ------------------------------------------
+// content_hasher
+// ------------------------------------------
+
+content_hasher::content_hasher() { ripemd128Init(this->digest); }
+
+void content_hasher::compress(const uint8_t *block) {
+  dword32 X[16];
+  for (int i = 0; i < 16; i++) {
+    X[i] = BYTES_TO_DWORD(block + 4 * i);
+  }
+  ripemd128compress(this->digest, X);
+}
+
+void content_hasher::update(const uint8_t *data, size_t len) {
+  this->total += len;
+  if (this->buffered > 0) {
+    size_t n = std::min(len, sizeof(this->buffer) - this->buffered);
+    memcpy(this->buffer + this->buffered, data, n);
+    this->buffered += n;
+    data += n;
+    len -= n;
+    if (this->buffered < sizeof(this->buffer)) {
+      return;
+    }
+    this->compress(this->buffer);
+    this->buffered = 0;
+  }
+  for (; len >= 64; data += 64, len -= 64) {
+    this->compress(data);
+  }
+  memcpy(this->buffer, data, len);
+  this->buffered = len;
+}
+
+content_hash content_hasher::finish() {
+  // 0x80, zeros, then the message length in bits, little endian
+  uint64_t bits = this->total * 8;
+  uint8_t pad[72] = {0x80};
+  size_t pad_len = (this->buffered < 56 ? 56 : 120) - this->buffered;
+  for (int i = 0; i < 8; i++) {
+    pad[pad_len + i] = static_cast<uint8_t>(bits >> (8 * i));
+  }
+  this->update(pad, pad_len + 8);
+
+  content_hash hash;
+  for (int i = 0; i < 16; i++) {
+    hash[i] = static_cast<uint8_t>(this->digest[i >> 2] >> (8 * (i & 3)));
+  }
+  return hash;
+}
+
+// ------------------------------------------
+// content_store
+// ------------------------------------------
+
+content_store::content_store(uint64_t capacity_bytes)
+    : capacity_bytes(capacity_bytes) {}
+
+content_store &content_store::global() {
+  static content_store store(MDICT_DEFAULT_CONTENT_STORE_BYTES);
+  return store;
+}
+
+block_ptr content_store::get(const content_hash &hash) {
+  std::lock_guard<std::mutex> lock(mtx);
+  auto it = index.find(hash);
+  if (it == index.end()) {
+    misses++;
+    return nullptr;
+  }
+  hits++;
+  lru.splice(lru.begin(), lru, it->second);
+  return it->second->data;
+}
+
+void content_store::put(const content_hash &hash, block_ptr data) {
+  if (!data) {
+    return;
+  }
+  uint64_t charge = data->size() + 64;
+  std::lock_guard<std::mutex> lock(mtx);
+  if (charge > capacity_bytes || index.count(hash) != 0) {
+    return;
+  }
+  lru.push_front(item{hash, std::move(data), charge});
+  index.emplace(hash, lru.begin());
+  used_bytes += charge;
+  evict_to(capacity_bytes);
+}
+
+void content_store::evict_to(uint64_t bytes) {
+  while (used_bytes > bytes && !lru.empty()) {
+    auto last = std::prev(lru.end());
+    used_bytes -= last->charge;
+    index.erase(last->hash);
+    lru.erase(last);
+    evictions++;
+  }
+}
+
+void content_store::set_capacity(uint64_t capacity_bytes) {
+  std::lock_guard<std::mutex> lock(mtx);
+  this->capacity_bytes = capacity_bytes;
+  evict_to(capacity_bytes);
+}
+
+uint64_t content_store::capacity() {
+  std::lock_guard<std::mutex> lock(mtx);
+  return capacity_bytes;
+}
+
+mdict_cache_stats_t content_store::stats() {
+  std::lock_guard<std::mutex> lock(mtx);
+  mdict_cache_stats_t s{};
+  s.hits = hits;
+  s.misses = misses;
+  s.evictions = evictions;
+  s.entries = index.size();
+  s.bytes = used_bytes;
+  s.capacity = capacity_bytes;
+  return s;
+}
+
+}  // namespace mdict
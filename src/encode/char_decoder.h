@@ -12,6 +12,8 @@
 #include <stdint.h>
 #pragma once
 
+#include "include/mdict_log.h"
+
 // In Windows ssize_t is not standard.
 #ifdef _WIN32
 #include <BaseTsd.h>
@@ -37,19 +39,19 @@ static int hex_char_to_int(char c) {
  * Return is The number of bytes written on success, or -1 on any error. */
 inline ssize_t hex_to_bytes(const char *hex_str, unsigned char *byte_buf, size_t buf_len) {
     if (!hex_str || !byte_buf) {
-        fprintf(stderr, "Error: Null pointer passed to hex_to_bytes.\n");
+        mdict::log_printf(MDICT_LOG_DEBUG, "Null pointer passed to hex_to_bytes.");
         return -1;
     }
 
     size_t hex_len = strlen(hex_str);
     if (hex_len % 2 != 0) {
-        fprintf(stderr, "Error: Hex string must have an even number of characters.\n");
+        mdict::log_printf(MDICT_LOG_DEBUG, "Hex string must have an even number of characters.");
         return -1;
     }
 
     size_t bytes_to_write = hex_len / 2;
     if (bytes_to_write > buf_len) {
-        fprintf(stderr, "Error: Output buffer (size %zu) too small for hex conversion (%zu bytes needed).\n", buf_len, bytes_to_write);
+        mdict::log_printf(MDICT_LOG_DEBUG, "Output buffer (size %zu) too small for hex conversion (%zu bytes needed).", buf_len, bytes_to_write);
         return -1;
     }
 
@@ -58,7 +60,7 @@ inline ssize_t hex_to_bytes(const char *hex_str, unsigned char *byte_buf, size_t
         int low_nibble = hex_char_to_int(hex_str[i * 2 + 1]);
 
         if (high_nibble == -1 || low_nibble == -1) {
-            fprintf(stderr, "Error: Invalid hex character '%c' or '%c' found in input string.\n",
+            mdict::log_printf(MDICT_LOG_DEBUG, "Invalid hex character '%c' or '%c' found in input string.",
                     hex_str[i * 2], hex_str[i * 2 + 1]);
             return -1;
         }
@@ -77,13 +79,13 @@ inline ssize_t utf16le_to_utf8(const unsigned char *utf16le_data, size_t utf16le
                         unsigned char *utf8_buf, size_t utf8_buf_len)
 {
     if (!utf16le_data || !utf8_buf) {
-         fprintf(stderr, "Error: Null pointer passed to utf16le_to_utf8.\n");
+         mdict::log_printf(MDICT_LOG_DEBUG, "Null pointer passed to utf16le_to_utf8.");
          return -1;
     }
 
     // UTF-16 must consist of 16-bit (2-byte) units
     if (utf16le_len_bytes % 2 != 0) {
-        fprintf(stderr, "Error: UTF-16LE data length (%zu bytes) must be even.\n", utf16le_len_bytes);
+        mdict::log_printf(MDICT_LOG_DEBUG, "UTF-16LE data length (%zu bytes) must be even.", utf16le_len_bytes);
         return -1;
     }
 
@@ -106,15 +108,15 @@ inline ssize_t utf16le_to_utf8(const unsigned char *utf16le_data, size_t utf16le
                     codepoint = 0x10000 + (((uint32_t)u16_char - 0xD800) << 10) + ((uint32_t)next_u16_char - 0xDC00);
                     utf16_idx += 2; // We need to consume the low surrogate as well. 16+16 = 32
                 } else {
-                    fprintf(stderr, "Error: Invalid UTF-16 sequence: High surrogate U+%04X not followed by low surrogate.\n", u16_char);
+                    mdict::log_printf(MDICT_LOG_DEBUG, "Invalid UTF-16 sequence: High surrogate U+%04X not followed by low surrogate.", u16_char);
                     return -1; // Invalid sequence
                 }
             } else {
-                fprintf(stderr, "Error: Invalid UTF-16 sequence: Dangling high surrogate U+%04X at end of input.\n", u16_char);
+                mdict::log_printf(MDICT_LOG_DEBUG, "Invalid UTF-16 sequence: Dangling high surrogate U+%04X at end of input.", u16_char);
                 return -1; // Dangling surrogate
             }
         } else if (u16_char >= 0xDC00 && u16_char <= 0xDFFF) {
-             fprintf(stderr, "Error: Invalid UTF-16 sequence: Lone low surrogate U+%04X found.\n", u16_char);
+             mdict::log_printf(MDICT_LOG_DEBUG, "Invalid UTF-16 sequence: Lone low surrogate U+%04X found.", u16_char);
              return -1; // Lone low surrogate
         } else {
             // Basic Multilingual Plane (BMP) character
@@ -128,7 +130,7 @@ inline ssize_t utf16le_to_utf8(const unsigned char *utf16le_data, size_t utf16le
         else if (codepoint <= 0xFFFF) bytes_needed = 3;
         else if (codepoint <= 0x10FFFF) bytes_needed = 4;
         else {
-            fprintf(stderr, "Error: Invalid Unicode code point U+%X generated.\n", codepoint);
+            mdict::log_printf(MDICT_LOG_DEBUG, "Invalid Unicode code point U+%X generated.", codepoint);
              return -1; // Invalid codepoint (e.g., > U+10FFFF)
         }
 
@@ -138,7 +140,7 @@ inline ssize_t utf16le_to_utf8(const unsigned char *utf16le_data, size_t utf16le
             size_t new_len = (utf8_idx + bytes_needed) * 2; // grow a bit more to reduce future reallocs
              char* new_buf = (char*)realloc(utf8_buf, new_len);
            if (!new_buf) {
-             fprintf(stderr, "Error: Failed to allocate memory for UTF-8 buffer\n");
+             mdict::log_printf(MDICT_LOG_ERROR, "Failed to allocate memory for UTF-8 buffer");
              return -1;
           }
              utf8_buf = reinterpret_cast<unsigned char*>(new_buf);
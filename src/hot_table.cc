@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#include "include/hot_table.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+namespace mdict {
+
+void hot_table::reserve(size_t entries, uint64_t arena_bytes) {
+  this->index.reserve(entries);
+  this->arena.reserve(static_cast<size_t>(arena_bytes));
+}
+
+bool hot_table::add(const std::string &normalized,
+                    const std::string &definition) {
+  uint64_t cost = charge(normalized, definition.size());
+  if (this->used + cost > this->capacity ||
+      this->index.count(normalized) != 0) {
+    return false;
+  }
+  this->index.emplace(normalized,
+                      std::make_pair(static_cast<uint64_t>(this->arena.size()),
+                                     static_cast<uint64_t>(definition.size())));
+  this->arena.append(definition);
+  this->used += cost;
+  return true;
+}
+
+bool hot_table::get(const std::string &normalized, std::string &out) const {
+  const char *data = nullptr;
+  uint64_t size = 0;
+  if (!this->get(normalized, data, size)) {
+    return false;
+  }
+  out.assign(data, static_cast<size_t>(size));
+  return true;
+}
+
+bool hot_table::get(const std::string &normalized, const char *&data,
+                    uint64_t &size) const {
+  auto it = this->index.find(normalized);
+  if (it == this->index.end()) {
+    this->misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  this->hits.fetch_add(1, std::memory_order_relaxed);
+  data = this->arena.data() + it->second.first;
+  size = it->second.second;
+  return true;
+}
+
+mdict_cache_stats_t hot_table::stats() const {
+  mdict_cache_stats_t s{};
+  s.hits = this->hits.load(std::memory_order_relaxed);
+  s.misses = this->misses.load(std::memory_order_relaxed);
+  s.entries = this->index.size();
+  s.bytes = this->used;
+  s.capacity = this->capacity;
+  return s;
+}
+
+mdict_error_t hot_table::read_list(const std::string &path,
+                                   std::vector<std::string> &words) {
+  std::ifstream in(path);
+  if (!in) {
+    return MDICT_ERR_IO;
+  }
+  std::vector<std::pair<std::string, uint64_t>> counted;
+  bool has_counts = false;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    uint64_t count = 0;
+    size_t tab = line.rfind('\t');
+    if (tab != std::string::npos) {
+      count = std::strtoull(line.c_str() + tab + 1, nullptr, 10);
+      line.resize(tab);
+      has_counts = true;
+    }
+    if (!line.empty()) {
+      counted.emplace_back(std::move(line), count);
+    }
+  }
+  if (has_counts) {
+    std::stable_sort(counted.begin(), counted.end(),
+                     [](const std::pair<std::string, uint64_t> &a,
+                        const std::pair<std::string, uint64_t> &b) {
+                       return a.second > b.second;
+                     });
+  }
+  words.clear();
+  words.reserve(counted.size());
+  for (auto &c : counted) {
+    words.push_back(std::move(c.first));
+  }
+  return MDICT_OK;
+}
+
+}  // namespace mdict
@@ -25,4 +25,4 @@ typedef unsigned short word16;
  * @param len Length of the data buffer in bytes
  * @return uint32_t The calculated Adler-32 checksum value
  */
-uint32_t adler32checksum(const unsigned char *data, uint32_t len);
+uint32_t adler32checksum(const unsigned char *data, uint64_t len);
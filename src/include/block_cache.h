@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mdict_extern.h"
+
+// default budget of the process wide block cache, see block_cache::shared()
+#define MDICT_DEFAULT_SHARED_BLOCK_CACHE_BYTES (128ULL << 20)
+// share of a block cache budget spent on the warm tier, in percent
+#define MDICT_DEFAULT_WARM_CACHE_PERCENT 25
+// the hot tier keeps at least the rest
+#define MDICT_MAX_WARM_CACHE_PERCENT 90
+
+namespace mdict {
+
+/**
+ * kind of a cached block
+ */
+enum block_kind : uint8_t {
+  KEY_BLOCK = 0,    // decompressed key block
+  RECORD_BLOCK = 1  // decompressed record block
+};
+
+/**
+ * cache key of a block: (dictionary handle, block kind, block id)
+ */
+struct block_key {
+  uint64_t dict_id;
+  uint8_t kind;
+  uint64_t block_id;
+
+  bool operator==(const block_key &o) const {
+    return dict_id == o.dict_id && kind == o.kind && block_id == o.block_id;
+  }
+};
+
+/**
+ * 64 bit mix of a block key (splitmix64 finalizer)
+ */
+inline uint64_t block_key_hash64(const block_key &k) {
+  uint64_t x = k.dict_id ^ (k.block_id * 0x9e3779b97f4a7c15ULL) ^
+               (static_cast<uint64_t>(k.kind) << 56);
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+struct block_key_hasher {
+  size_t operator()(const block_key &k) const {
+    return static_cast<size_t>(block_key_hash64(k));
+  }
+};
+
+/**
+ * decompressed block bytes, shared between the cache and its readers so an
+ * evicted block stays valid while it is being used
+ */
+using block_ptr = std::shared_ptr<const std::vector<uint8_t>>;
+
+/**
+ * count-min sketch with 4 bit counters, estimates how often a block was
+ * requested recently. counters are halved every 10 * width increments so
+ * the history ages out.
+ */
+class frequency_sketch {
+ public:
+  /**
+   * @param expected_entries number of distinct blocks the cache can hold
+   */
+  explicit frequency_sketch(uint64_t expected_entries);
+
+  void increment(uint64_t hash);
+
+  /**
+   * @return the estimated frequency, 0..15
+   */
+  int estimate(uint64_t hash) const;
+
+ private:
+  static constexpr int depth = 4;
+
+  size_t index_of(uint64_t hash, int row) const;
+  void reset();
+
+  // 16 counters of 4 bits per word
+  std::vector<uint64_t> table;
+  uint64_t counter_mask;
+  uint64_t additions = 0;
+  uint64_t sample_size;
+};
+
+/**
+ * block_cache holds decompressed key and record blocks within a byte budget
+ *
+ * MDICT_CACHE_TINYLFU (default) is a W-TinyLFU cache: new blocks enter a
+ * small LRU window (1% of the budget), blocks leaving the window are only
+ * admitted into the main segmented LRU (probation + 80% protected) if the
+ * frequency sketch says they are requested more often than the block they
+ * would evict. one pass over every record block (exports, verify runs, batch
+ * jobs) therefore cannot flush the hot set.
+ *
+ * MDICT_CACHE_LRU and MDICT_CACHE_CLOCK are plain single segment caches.
+ *
+ * an optional warm tier keeps blocks evicted from (or not admitted to) the
+ * decompressed hot tier re-compressed with LZO1X-1. decompressed blocks are
+ * 5-10x their compressed size, so the warm tier holds many more blocks per
+ * byte, and a warm hit only costs an LZO decompression instead of a file
+ * read plus inflate. warm hits are offered to the hot tier again.
+ *
+ * accesses flagged as scan neither update frequencies nor insert blocks, a
+ * scan only profits from blocks that are already cached.
+ *
+ * blocks are keyed by dictionary, so one cache can serve every dictionary of
+ * the process under a single budget (see shared()): it then holds the hot
+ * blocks of whichever dictionaries are in use. a dictionary may reserve a
+ * minimum number of bytes; while it holds less, its blocks are passed over
+ * by eviction and admitted without the frequency test.
+ */
+class block_cache {
+ public:
+  /**
+   * constructor
+   * @param capacity_bytes byte budget of the decompressed (hot) blocks
+   * @param policy eviction policy of the hot tier
+   * @param warm_capacity_bytes byte budget of the re-compressed (warm) blocks,
+   * 0 disables the warm tier
+   */
+  block_cache(uint64_t capacity_bytes,
+              mdict_cache_policy_t policy = MDICT_CACHE_TINYLFU,
+              uint64_t warm_capacity_bytes = 0);
+
+  /**
+   * @param key block key
+   * @param scan true if the access is part of a sequential scan
+   * @return the cached block (decompressed from the warm tier if needed) or
+   * nullptr
+   */
+  block_ptr get(const block_key &key, bool scan = false);
+
+  /**
+   * true if the block is in the decompressed tier. a probe, it neither
+   * counts as an access nor changes the eviction order
+   */
+  bool contains(const block_key &key);
+
+  /**
+   * offer a block to the cache, the admission policy decides whether it is
+   * kept. scans never insert.
+   */
+  void put(const block_key &key, block_ptr block, bool scan = false);
+
+  /**
+   * drop every block and the counters of a dictionary, called when it is
+   * closed, moves to another cache or its file changed. a reservation stays
+   * until it is removed with reserve(dict_id, 0).
+   */
+  void erase_dict(uint64_t dict_id);
+
+  mdict_cache_stats_t stats();
+
+  /**
+   * keep at least bytes of a dictionary's blocks cached. reservations are
+   * meant to be small next to the capacity, if they add up to more the
+   * least recently used reserved blocks are evicted regardless.
+   * @param dict_id dictionary key, see Mdict::block_cache_id()
+   * @param bytes minimum share, 0 removes the reservation
+   */
+  void reserve(uint64_t dict_id, uint64_t bytes);
+
+  /**
+   * counters of one dictionary; capacity is its reservation, warm_entries
+   * and warm_bytes are not tracked per dictionary. the counters restart
+   * once a dictionary has neither blocks nor a reservation left, misses
+   * while it has neither are not counted.
+   */
+  mdict_cache_stats_t dict_stats(uint64_t dict_id);
+
+  /**
+   * a cache splitting one byte budget between the tiers
+   * @param budget_bytes byte budget of both tiers together
+   * @param policy eviction policy of the hot tier
+   * @param warm_percent share of the budget given to the warm tier, at most
+   * MDICT_MAX_WARM_CACHE_PERCENT; 0 disables the warm tier
+   */
+  static std::shared_ptr<block_cache> with_budget(
+      uint64_t budget_bytes, mdict_cache_policy_t policy = MDICT_CACHE_TINYLFU,
+      unsigned int warm_percent = MDICT_DEFAULT_WARM_CACHE_PERCENT);
+
+  /**
+   * the process wide cache, created on first use with
+   * MDICT_DEFAULT_SHARED_BLOCK_CACHE_BYTES (TinyLFU), split like
+   * with_budget()
+   */
+  static std::shared_ptr<block_cache> shared();
+
+  /**
+   * replace the process wide cache, dictionaries attached before keep using
+   * the previous one. see with_budget()
+   */
+  static void configure_shared(
+      uint64_t budget_bytes, mdict_cache_policy_t policy,
+      unsigned int warm_percent = MDICT_DEFAULT_WARM_CACHE_PERCENT);
+
+  uint64_t capacity() const { return capacity_bytes; }
+
+  mdict_cache_policy_t policy() const { return cache_policy; }
+
+ private:
+  enum segment : uint8_t { WINDOW = 0, PROBATION = 1, PROTECTED = 2 };
+
+  struct node {
+    block_key key;
+    block_ptr block;
+    uint64_t charge;
+    segment seg;
+    bool referenced;
+  };
+  using node_list = std::list<node>;
+
+  struct warm_node {
+    block_key key;
+    std::shared_ptr<const std::vector<uint8_t>> packed;
+    uint64_t raw_size;
+    uint64_t charge;
+  };
+  using warm_list = std::list<warm_node>;
+
+  static uint64_t charge_of(const block_ptr &b) { return b->size() + 128; }
+
+  // compress blocks removed from the hot tier into the warm tier, called
+  // without holding mtx
+  void demote(std::vector<std::pair<block_key, block_ptr>> &victims);
+  void on_hit(node_list::iterator it);
+  void maintain();
+  // removes a hot block, queueing it for the warm tier
+  void remove(node_list::iterator it);
+  // remove() and count an eviction
+  void evict(node_list::iterator it);
+  // true while the dictionary of a block holds no more than its reservation
+  bool is_reserved(const node &n);
+  // the least recently used block of a list not protected by a reservation,
+  // l.end() if there is none
+  node_list::iterator victim_of(node_list &l);
+  // TinyLFU victim in the main segment
+  node_list::iterator main_victim();
+  node_list &list_of(segment s);
+
+  std::mutex mtx;
+  const uint64_t capacity_bytes;
+  const mdict_cache_policy_t cache_policy;
+  uint64_t window_capacity;
+  uint64_t protected_capacity;
+
+  // LRU / CLOCK keep every block in the window segment
+  node_list window_lru;
+  node_list probation_lru;
+  node_list protected_lru;
+  uint64_t segment_bytes[3] = {0, 0, 0};
+  node_list::iterator clock_hand;
+
+  std::unordered_map<block_key, node_list::iterator, block_key_hasher> index;
+  frequency_sketch sketch;
+
+  // warm tier, LRU over compressed blocks
+  const uint64_t warm_capacity;
+  uint64_t warm_used = 0;
+  warm_list warm_lru;
+  std::unordered_map<block_key, warm_list::iterator, block_key_hasher>
+      warm_index;
+  // hot blocks removed under the lock, compressed after it is released
+  std::vector<std::pair<block_key, block_ptr>> pending_demote;
+
+  uint64_t hits = 0;
+  uint64_t warm_hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+
+  struct dict_usage {
+    uint64_t bytes = 0;
+    uint64_t entries = 0;
+    uint64_t reserved = 0;
+    uint64_t hits = 0;
+    uint64_t warm_hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+  };
+  std::unordered_map<uint64_t, dict_usage> usage;
+};
+
+}  // namespace mdict
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "block_cache.h"
+#include "mdict_extern.h"
+#include "ripemd128.h"
+
+// default budget of the process wide content store
+#define MDICT_DEFAULT_CONTENT_STORE_BYTES (16ULL << 20)
+// larger resources are streamed, never stored whole
+#define MDICT_CONTENT_STORE_MAX_ITEM_BYTES (1ULL << 20)
+
+namespace mdict {
+
+/**
+ * RIPEMD-128 digest of the raw bytes of a resource
+ */
+using content_hash = std::array<uint8_t, 16>;
+
+/**
+ * @return the digest as 32 lower case hex characters
+ */
+std::string content_hash_hex(const content_hash &hash);
+
+struct content_hash_hasher {
+  size_t operator()(const content_hash &h) const {
+    size_t v;
+    memcpy(&v, h.data(), sizeof(v));
+    return v;
+  }
+};
+
+/**
+ * incremental RIPEMD-128 (standard padding, unlike ripemd128bytes() which
+ * implements the key derivation of encrypted dictionaries)
+ */
+class content_hasher {
+ public:
+  content_hasher();
+  void update(const uint8_t *data, size_t len);
+  content_hash finish();
+
+ private:
+  dword32 digest[4];
+  uint8_t buffer[64];
+  size_t buffered = 0;
+  uint64_t total = 0;
+
+  void compress(const uint8_t *block);
+};
+
+/**
+ * process wide cache of small resources keyed by content hash. identical
+ * fonts, style sheets and icons shipped by many MDD files are kept once,
+ * whichever dictionary decoded them first.
+ */
+class content_store {
+ public:
+  explicit content_store(uint64_t capacity_bytes);
+
+  /**
+   * the store shared by every dictionary of the process
+   */
+  static content_store &global();
+
+  /**
+   * @return the resource bytes, nullptr if not stored
+   */
+  block_ptr get(const content_hash &hash);
+
+  /**
+   * store a resource, least recently used ones are evicted to fit the budget
+   */
+  void put(const content_hash &hash, block_ptr data);
+
+  /**
+   * change the byte budget, 0 disables the store
+   */
+  void set_capacity(uint64_t capacity_bytes);
+
+  uint64_t capacity();
+
+  mdict_cache_stats_t stats();
+
+ private:
+  struct item {
+    content_hash hash;
+    block_ptr data;
+    uint64_t charge;
+  };
+
+  uint64_t capacity_bytes;
+  uint64_t used_bytes = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  std::list<item> lru;
+  std::unordered_map<content_hash, std::list<item>::iterator,
+                     content_hash_hasher>
+      index;
+  std::mutex mtx;
+
+  void evict_to(uint64_t bytes);
+};
+
+}  // namespace mdict
@@ -8,21 +8,20 @@
 
 #pragma once
 
-#include <cstdio>
+#include <cstdint>
+#include <filesystem>
+#include <system_error>
 
 /**
- * Gets the size of a binary file in bytes
- * Opens the file in binary read mode, seeks to the end to determine size,
- * then closes the file
+ * Gets the size of a binary file in bytes, 64-bit clean (files larger than
+ * 4GB are measured correctly)
  *
  * @param fpath Path to the file to measure
- * @return int The size of the file in bytes, or -1 if the file cannot be opened
+ * @return int64_t The size of the file in bytes, or -1 if the file cannot be
+ * measured
  */
-inline static int fsizeof(const char* fpath) {
-  FILE* f = std::fopen(fpath, "rb");
-  std::fseek(f, 0, SEEK_END);  // seek to end of file
-  auto size = std::ftell(f);   // get current file pointer
-  std::fseek(f, 0, SEEK_SET);  // seek back to beginning of file
-  std::fclose(f);
-  return size;
+inline static int64_t fsizeof(const char* fpath) {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(fpath, ec);
+  return ec ? -1 : static_cast<int64_t>(size);
 }
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mdict_extern.h"
+
+namespace mdict {
+
+/**
+ * pinned definitions of the most requested headwords
+ *
+ * the table is filled once, when the hot set is loaded, and only read
+ * afterwards. definitions sit back to back in one arena, the index maps a
+ * normalized key to its slice. a hit costs one hash probe and a copy, no
+ * block cache, read or inflate is involved, and entries are never evicted:
+ * the hot set is chosen up front, from a frequency list, instead of being
+ * learned by the caches.
+ *
+ * the byte budget covers the arena, the keys and the index overhead; words
+ * which don't fit are left to the regular lookup path.
+ */
+class hot_table {
+ public:
+  explicit hot_table(uint64_t capacity_bytes) : capacity(capacity_bytes) {}
+
+  /**
+   * bytes charged for an entry
+   */
+  static uint64_t charge(const std::string &normalized, uint64_t def_size) {
+    // approximate the hash node and bucket overhead as well
+    return normalized.size() + def_size + 64;
+  }
+
+  uint64_t capacity_bytes() const { return this->capacity; }
+
+  /**
+   * size the arena before adding, add() never moves it afterwards
+   */
+  void reserve(size_t entries, uint64_t arena_bytes);
+
+  /**
+   * pin a definition, ignored if the key is already pinned or the budget
+   * is spent
+   * @return true if the entry was added
+   */
+  bool add(const std::string &normalized, const std::string &definition);
+
+  /**
+   * @param normalized the normalized key, see _s()
+   * @param out receives the definition on hit
+   * @return true on hit
+   */
+  bool get(const std::string &normalized, std::string &out) const;
+
+  /**
+   * get() without the copy, the slice stays valid as long as the table
+   * @param data receives the start of the definition on hit
+   * @param size receives its size on hit
+   */
+  bool get(const std::string &normalized, const char *&data,
+           uint64_t &size) const;
+
+  bool empty() const { return this->index.empty(); }
+
+  /**
+   * counters, the table neither misses into anything nor evicts: misses
+   * are lookups which went on to the regular path
+   */
+  mdict_cache_stats_t stats() const;
+
+  /**
+   * read a frequency list, one word per line, optionally followed by a tab
+   * and its count. with counts the words are ordered by descending count,
+   * without them the file order is kept
+   * @return MDICT_OK or MDICT_ERR_IO
+   */
+  static mdict_error_t read_list(const std::string &path,
+                                 std::vector<std::string> &words);
+
+ private:
+  const uint64_t capacity;
+  uint64_t used = 0;
+  // definitions back to back
+  std::string arena;
+  // normalized key -> (offset, size) in the arena
+  std::unordered_map<std::string, std::pair<uint64_t, uint64_t>> index;
+  mutable std::atomic<uint64_t> hits{0};
+  mutable std::atomic<uint64_t> misses{0};
+};
+
+}  // namespace mdict
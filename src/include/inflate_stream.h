@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "miniz/miniz.h"
+
+/**
+ * resumable inflate of zlib streams
+ *
+ * deflate can not seek: reaching byte N of a stream means decoding the N bytes
+ * in front of it. an inflate_checkpoint is everything tinfl needs to resume
+ * decoding in the middle of a stream (decompressor state, the 32KB window,
+ * input and output positions). checkpoints are taken every `interval` output
+ * bytes while a block is inflated, so a later read of [start, end) only
+ * decodes from the closest checkpoint before start, at most interval bytes
+ * more than requested.
+ */
+
+namespace mdict {
+
+/**
+ * reads len bytes of a compressed stream, starting at stream offset off,
+ * throws mdict_error (MDICT_ERR_IO) on a short read
+ */
+using stream_reader =
+    std::function<void(uint64_t off, uint64_t len, uint8_t *buf)>;
+
+/**
+ * receives decompressed bytes in order, returns false to stop
+ */
+using stream_sink = std::function<bool(const uint8_t *data, size_t len)>;
+
+struct inflate_checkpoint {
+  tinfl_decompressor decomp;
+  // circular output window, TINFL_LZ_DICT_SIZE bytes
+  std::vector<uint8_t> window;
+  size_t window_ofs = 0;
+  // compressed bytes consumed
+  uint64_t in_pos = 0;
+  // decompressed bytes produced
+  uint64_t out_pos = 0;
+};
+
+/**
+ * checkpoints of the large blocks of one dictionary, blocks are dropped in
+ * least recently used order once the byte budget is exceeded
+ */
+class inflate_checkpoints {
+ public:
+  /**
+   * @param interval_bytes decompressed bytes between two checkpoints
+   * @param capacity_bytes memory budget, 0 disables checkpoints
+   */
+  inflate_checkpoints(uint64_t interval_bytes, uint64_t capacity_bytes);
+
+  /**
+   * copy of the last checkpoint of a block at or before out_pos
+   * @return false if there is none, decoding starts at the stream begin
+   */
+  bool find(uint64_t block_id, uint64_t out_pos, inflate_checkpoint &cp);
+
+  /**
+   * store a checkpoint, ignored if the block has one for the same interval
+   */
+  void add(uint64_t block_id, const inflate_checkpoint &cp);
+
+  void clear();
+
+  uint64_t interval() const { return interval_bytes; }
+
+  /**
+   * number of checkpoints currently stored
+   */
+  size_t size();
+
+ private:
+  struct block_entry {
+    // by out_pos
+    std::map<uint64_t, inflate_checkpoint> points;
+    std::list<uint64_t>::iterator lru_pos;
+  };
+
+  uint64_t interval_bytes;
+  uint64_t capacity_bytes;
+  uint64_t used_bytes = 0;
+  std::unordered_map<uint64_t, block_entry> blocks;
+  std::list<uint64_t> lru;
+  std::mutex mtx;
+
+  static uint64_t charge() {
+    return sizeof(inflate_checkpoint) + TINFL_LZ_DICT_SIZE;
+  }
+};
+
+/**
+ * inflate bytes [start, end) of a zlib stream
+ *
+ * @param read reads the compressed stream
+ * @param comp_size compressed stream size
+ * @param start first decompressed byte to deliver
+ * @param end end of the range, decoding stops there
+ * @param sink receives the range in pieces of at most chunk_bytes
+ * @param chunk_bytes input read size and output piece size
+ * @param store checkpoints to resume from and to fill, may be nullptr
+ * @param block_id key of the stream in store
+ * throws mdict_error: MDICT_ERR_DECOMPRESS / MDICT_ERR_CORRUPT on bad or short
+ * data, MDICT_ERR_IO if the sink stopped the transfer
+ */
+void inflate_range(const stream_reader &read, uint64_t comp_size,
+                   uint64_t start, uint64_t end, const stream_sink &sink,
+                   size_t chunk_bytes, inflate_checkpoints *store,
+                   uint64_t block_id);
+
+}  // namespace mdict
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sidecar.h"
+
+// default error bound of the learned key index, in keys
+#define MDICT_LEARNED_INDEX_EPSILON 32
+
+namespace mdict {
+
+/**
+ * piecewise linear model of the key order of a dictionary
+ *
+ * every key is mapped to a number by its first 8 (normalized) bytes, big
+ * endian, which preserves the key order. the model predicts the rank of
+ * the first key with a given number to within epsilon keys, so a lookup
+ * evaluates one segment and compares a handful of neighbouring keys
+ * instead of binary searching the block directory and then a key block.
+ *
+ * segments are built in one pass with the shrinking cone method: a segment
+ * grows while some slope through its first point keeps every point within
+ * epsilon. predictions are clamped to the segment's rank range, so a number
+ * between two segments still lands next to its position.
+ *
+ * keys sharing their first 8 bytes share a number and the model only knows
+ * the rank of the first of them, window() widens the error bound by the
+ * longest such run so the search range stays bounded.
+ */
+class learned_index {
+ public:
+  // sidecar section holding the model
+  static constexpr const char *sidecar_tag = "PLAI";
+
+  /**
+   * the number of a normalized key, see _s() in mdict.cc
+   */
+  static uint64_t pack(const std::string &normalized_key);
+
+  /**
+   * build the model
+   * @param keys pack() of every key, in key order (non decreasing)
+   * @param epsilon error bound in keys
+   */
+  void build(const std::vector<uint64_t> &keys, uint32_t epsilon);
+
+  /**
+   * the predicted rank of the first key whose number is >= key, within
+   * epsilon() of the real one for keys present in the model
+   */
+  size_t predict(uint64_t key) const;
+
+  /**
+   * the ranks [lo, hi) holding every key whose number is key, if the model
+   * has any
+   */
+  void window(uint64_t key, size_t &lo, size_t &hi) const;
+
+  uint32_t epsilon() const { return this->eps; }
+
+  /**
+   * longest run of keys with the same number
+   */
+  uint64_t max_ties() const { return this->ties; }
+
+  /**
+   * number of keys the model was built from
+   */
+  uint64_t size() const { return this->key_count; }
+
+  size_t segment_count() const { return this->segments.size(); }
+
+  size_t memory_bytes() const {
+    return this->segments.capacity() * sizeof(segment);
+  }
+
+  void serialize(section_writer &w) const;
+
+  /**
+   * @return false if the section is malformed
+   */
+  bool deserialize(section_reader &r);
+
+ private:
+  struct segment {
+    uint64_t key;   // number of the first key
+    uint64_t rank;  // rank of the first key
+    double slope;   // ranks per unit of number
+  };
+
+  std::vector<segment> segments;
+  uint32_t eps = 0;
+  uint64_t key_count = 0;
+  uint64_t ties = 0;
+};
+
+}  // namespace mdict
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sidecar.h"
+
+namespace mdict {
+
+/**
+ * cross references between the entries of a dictionary
+ *
+ * definitions point at other entries with entry://word links and
+ * @@@LINK=word redirects. the graph keeps, for every entry (by its index in
+ * the key list), the distinct entries it links to, in compressed sparse
+ * row form: one offset per entry into a single array of target indexes.
+ * links to words which are not in the dictionary are dropped.
+ */
+class link_graph {
+ public:
+  // sidecar section holding the graph
+  static constexpr const char *sidecar_tag = "LINK";
+
+  /**
+   * the words a definition links to, in order of appearance, duplicates
+   * included. fragments (#...) are dropped and %XX escapes decoded.
+   */
+  static void extract(const std::string &definition,
+                      std::vector<std::string> &words);
+
+  /**
+   * build the graph
+   * @param targets the target indexes of every entry, in key list order
+   */
+  void build(std::vector<std::vector<uint32_t>> targets);
+
+  /**
+   * the entries an entry links to, sorted by index
+   * @return [begin, end) of the targets, empty if entry is out of range
+   */
+  std::pair<const uint32_t *, const uint32_t *> links(uint64_t entry) const;
+
+  /**
+   * number of entries the graph was built from
+   */
+  uint64_t size() const {
+    return this->offsets.empty() ? 0 : this->offsets.size() - 1;
+  }
+
+  uint64_t edge_count() const { return this->targets.size(); }
+
+  size_t memory_bytes() const {
+    return this->offsets.capacity() * sizeof(uint64_t) +
+           this->targets.capacity() * sizeof(uint32_t);
+  }
+
+  void serialize(section_writer &w) const;
+
+  /**
+   * @return false if the section is malformed
+   */
+  bool deserialize(section_reader &r);
+
+ private:
+  // entry i links to targets[offsets[i] .. offsets[i + 1])
+  std::vector<uint64_t> offsets;
+  std::vector<uint32_t> targets;
+};
+
+}  // namespace mdict
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <string>
+
+#include "mdict_extern.h"
+
+// bytes of definition per expected link, sizes the rewrite output up front
+#define MDICT_REWRITE_LINK_SPACING 64
+
+namespace mdict {
+
+/**
+ * rewrites the links of definitions into a client's URL scheme
+ *
+ * each kind of link (see mdict_link_kind_t) can be given a prefix:
+ * entry://, sound:// and file:// are replaced by the prefix of their
+ * kind, wherever they appear, and relative src and href values get the
+ * resource prefix in front ("./" and a leading "/" are dropped). kinds
+ * without a prefix are left alone, as is every other URL.
+ *
+ * rewriting is one pass over the definition bytes, straight from the
+ * decompressed record block, which replaces the copy a lookup makes
+ * anyway. the output is reserved from the record size before the pass.
+ */
+class link_rewriter {
+ public:
+  /**
+   * rewrite links of a kind, the prefix may be empty (entry://cake becomes
+   * cake)
+   */
+  void set_prefix(mdict_link_kind_t kind, const std::string &prefix);
+
+  /**
+   * leave the links of a kind alone
+   */
+  void clear_prefix(mdict_link_kind_t kind);
+
+  /**
+   * @return the prefix of a kind, nullptr if its links are left alone
+   */
+  const std::string *prefix(mdict_link_kind_t kind) const;
+
+  /**
+   * true if no kind has a prefix
+   */
+  bool empty() const;
+
+  /**
+   * append the rewritten bytes [data, data + len) to out
+   */
+  void rewrite(const char *data, size_t len, std::string &out) const;
+
+  std::string rewrite(const std::string &definition) const {
+    std::string out;
+    this->rewrite(definition.data(), definition.size(), out);
+    return out;
+  }
+
+ private:
+  std::array<std::string, 4> prefixes;
+  std::array<bool, 4> enabled{};
+
+  // length of the value prefix to drop at data[value], or -1 if the value
+  // is not a relative resource reference
+  static long relative_value(const char *data, size_t len, size_t value);
+};
+
+}  // namespace mdict
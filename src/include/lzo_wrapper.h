@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "minilzo/minilzo.h"
+#include "mdict_log.h"
+
+/**
+ * one time lzo library initialization
+ * @return true if minilzo is usable
+ */
+inline bool lzo_ready() {
+  static const bool ok = lzo_init() == LZO_E_OK;
+  return ok;
+}
+
+/**
+ * Compresses data with LZO1X-1, a fast codec whose decompression is several
+ * times cheaper than inflate
+ *
+ * @param source Pointer to the data to compress
+ * @param sourceLen Length of the data in bytes
+ * @return std::vector<uint8_t> The compressed data, or empty vector if
+ * compression fails
+ */
+inline std::vector<uint8_t> lzo_mem_compress(const void *source,
+                                             size_t sourceLen) {
+  // work memory, one per thread
+  thread_local std::vector<lzo_align_t> wrkmem(
+      (LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t));
+  if (!lzo_ready()) {
+    return std::vector<uint8_t>();
+  }
+  // worst case expansion of incompressible input
+  std::vector<uint8_t> buffer(sourceLen + sourceLen / 16 + 64 + 3);
+  lzo_uint destLen = buffer.size();
+  int err = lzo1x_1_compress(reinterpret_cast<const lzo_bytep>(source),
+                             lzo_uint(sourceLen), buffer.data(), &destLen,
+                             wrkmem.data());
+  if (err != LZO_E_OK) {
+    mdict::log_printf(MDICT_LOG_DEBUG, "lzo compress error %d", err);
+    return std::vector<uint8_t>();
+  }
+  buffer.resize(destLen);
+  buffer.shrink_to_fit();
+  return buffer;
+}
+
+/**
+ * Decompresses LZO1X data into a pre-allocated buffer
+ *
+ * @param dest Pointer to the destination buffer
+ * @param destLen Size of the destination buffer, the decompressed data must
+ * fill it exactly
+ * @param source Pointer to the compressed data
+ * @param sourceLen Length of the compressed data in bytes
+ * @return true on success
+ */
+inline bool lzo_mem_uncompress(void *dest, size_t destLen, const void *source,
+                               size_t sourceLen) {
+  if (!lzo_ready()) {
+    return false;
+  }
+  lzo_uint len = destLen;
+  int err = lzo1x_decompress_safe(reinterpret_cast<const lzo_bytep>(source),
+                                  lzo_uint(sourceLen),
+                                  reinterpret_cast<lzo_bytep>(dest), &len,
+                                  nullptr);
+  if (err != LZO_E_OK || len != destLen) {
+    mdict::log_printf(MDICT_LOG_DEBUG, "lzo uncompress error %d", err);
+    return false;
+  }
+  return true;
+}
@@ -13,10 +13,27 @@
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>  // std::stof
+#include <unordered_map>
 #include <vector>
 
+#include "block_cache.h"
+#include "content_store.h"
+#include "hot_table.h"
+#include "inflate_stream.h"
+#include "learned_index.h"
+#include "link_graph.h"
+#include "link_rewriter.h"
 #include "mdict_extern.h"
+#include "mdict_log.h"
+#include "mdict_result.h"
+#include "overlay.h"
+#include "prefetcher.h"
+#include "result_cache.h"
 #include "ripemd128.h"
 
 /**
@@ -77,6 +94,7 @@
  *      | key_block_compressed = dict_file.read(header_bytes_size + 8 +
  *key_block_header_length + key_block_info_size, key_block_size)
  *      | key_list = decode_key_block(key_block_compressed, key_block_info_list)
+ *      | (read a window of key blocks at a time, see set_index_window)
  *      | note: record_block_offset = header_bytes_size + 8 +
  *key_block_header_length + key_block_info_size + key_block_size
  *
@@ -138,6 +156,53 @@ namespace mdict {
 #define MDXTYPE "MDX";
 #define MDDTYPE "MDD";
 
+// output chunk of the streaming resource functions
+#define MDICT_STREAM_CHUNK_BYTES (64 * 1024)
+
+// inflate checkpoints of large record blocks, see locate_range
+#define MDICT_INFLATE_CHECKPOINT_INTERVAL (1ULL << 20)
+#define MDICT_INFLATE_CHECKPOINT_BYTES (4ULL << 20)
+
+// reads of record blocks at most this far apart are merged by batch work
+#define MDICT_COALESCE_MAX_GAP_BYTES (64 * 1024)
+// upper bound of one merged read
+#define MDICT_COALESCE_MAX_READ_BYTES (4ULL << 20)
+
+// init() reads key blocks in windows of at most this many bytes
+#define MDICT_INDEX_WINDOW_BYTES (4ULL << 20)
+
+// bytes at the start (header and index headers) and at the end of the file
+// checksummed into identity()
+#define MDICT_IDENTITY_HEAD_BYTES (64ULL << 10)
+#define MDICT_IDENTITY_TAIL_BYTES (4ULL << 10)
+
+// default budget of the hot set, see load_hot_set
+#define MDICT_HOT_SET_BYTES (4ULL << 20)
+// default number of words written by save_hot_list
+#define MDICT_HOT_LIST_LIMIT 4096
+
+// default number of suggest() results
+#define MDICT_SUGGEST_LIMIT 50
+// record_start of overlay entries in merged_key_list()
+#define MDICT_OVERLAY_RECORD_START UINT64_MAX
+
+/**
+ * transform a word into the form keys are compared in: lower case, without
+ * white space and punctuation
+ */
+std::string _s(const std::string &word);
+
+/**
+ * exception carrying an mdict_error_t code, thrown by the decoding functions
+ * and translated into Mdict::last_error() by the public lookup functions
+ */
+class mdict_error : public std::runtime_error {
+ public:
+  mdict_error(mdict_error_t code, const std::string &what)
+      : std::runtime_error(what), code(code) {}
+  mdict_error_t code;
+};
+
 /**
  * key block info class definition
  */
@@ -148,13 +213,16 @@ class key_block_info {
   // last key of this key block
   std::string last_key;
   // key block start offset
-  unsigned long key_block_start_offset;
+  uint64_t key_block_start_offset;
   // key block compressed size
-  unsigned long key_block_comp_size;
-  unsigned long key_block_comp_accumulator;
+  uint64_t key_block_comp_size;
+  uint64_t key_block_comp_accumulator;
   // key block decompressed size
-  unsigned long key_block_decomp_size;
-  unsigned long key_block_decomp_accumulator;
+  uint64_t key_block_decomp_size;
+  uint64_t key_block_decomp_accumulator;
+  // index of the first key of this block in the key list, and key count
+  unsigned long key_list_offset = 0;
+  unsigned long key_list_entries = 0;
 
   /**
    * constructor
@@ -165,9 +233,9 @@ class key_block_info {
    * @param kb_decomp_size key block decompressed size
    */
   key_block_info(std::string first_key, std::string last_key,
-                 unsigned long kb_start_ofset, unsigned long kb_comp_size,
-                 unsigned long kb_decomp_size, unsigned long kb_comp_accu,
-                 unsigned long kb_decomp_accu) {
+                 uint64_t kb_start_ofset, uint64_t kb_comp_size,
+                 uint64_t kb_decomp_size, uint64_t kb_comp_accu,
+                 uint64_t kb_decomp_accu) {
     this->key_block_comp_size = kb_comp_size;
     this->key_block_decomp_size = kb_decomp_size;
     this->key_block_start_offset = kb_start_ofset;
@@ -180,45 +248,29 @@ class key_block_info {
 
 class key_list_item {
  public:
-  unsigned long record_start;
+  // offset of the record in the decompressed record data
+  uint64_t record_start;
   std::string key_word;
-  key_list_item(unsigned long kid, std::string kw)
+  key_list_item(uint64_t kid, std::string kw)
       : record_start(kid), key_word(std::move(kw)) {}
 };
 
-class record_header_item {
- public:
-  unsigned long block_id;
-  unsigned long compressed_size;
-  unsigned long decompressed_size;
-  unsigned long compressed_size_accumulator;
-  unsigned long decompressed_size_accumulator;
-  record_header_item(unsigned long bid, unsigned long comp_size,
-                     unsigned long uncomp_size, unsigned long comp_accu,
-                     unsigned long decomp_accu)
-      : block_id(bid),
-        compressed_size(comp_size),
-        decompressed_size(uncomp_size),
-        compressed_size_accumulator(comp_accu),
-        decompressed_size_accumulator(decomp_accu) {};
-};
-
 class record {
  public:
   std::string key_text;
   unsigned long key_idx;
   int encoding;
-  unsigned long record_start_offset;
-  unsigned int comp_size;
-  unsigned int uncomp_size;
+  uint64_t record_start_offset;
+  uint64_t comp_size;
+  uint64_t uncomp_size;
   unsigned int comp_type;
   bool record_encrypted;
-  unsigned long relative_record_start;
-  unsigned long relative_record_end;
+  uint64_t relative_record_start;
+  uint64_t relative_record_end;
   record(std::string ktext, unsigned long kidx, int encoding,
-         unsigned long r_start_ofset, unsigned int csize, unsigned int uncsize,
-         unsigned int comp_type, bool renc, unsigned long rela_stat,
-         unsigned long rela_end) {
+         uint64_t r_start_ofset, uint64_t csize, uint64_t uncsize,
+         unsigned int comp_type, bool renc, uint64_t rela_stat,
+         uint64_t rela_end) {
     this->key_text = ktext;
     this->key_idx = kidx;
     this->encoding = encoding;
@@ -232,6 +284,32 @@ class record {
   }
 };
 
+/**
+ * receives the bytes of a streamed resource in order, returns false to stop
+ * the transfer
+ */
+using resource_sink = std::function<bool(const uint8_t *data, size_t len)>;
+
+/**
+ * one resource of a batch fetch, see Mdict::locate_batch
+ */
+struct resource_payload {
+  std::string name;
+  // MDICT_OK, or why data is empty
+  mdict_error_t err = MDICT_ERR_NOT_FOUND;
+  // the raw bytes of the resource
+  std::string data;
+};
+
+/**
+ * a block a lookup reads, see Mdict::resolve_blocks
+ */
+struct block_ref {
+  block_kind kind;
+  unsigned long block_id;
+  uint64_t decompressed_size;
+};
+
 /**
  * Mdict class definition
  */
@@ -256,37 +334,375 @@ class Mdict {
    */
   ~Mdict();
 
+  /**
+   * open and index a dictionary without throwing
+   * @param fn dictionary file name
+   * @return the dictionary, or MDICT_ERR_IO if the file can't be read and
+   * the error of init() otherwise (MDICT_ERR_CORRUPT for malformed indexes)
+   */
+  static result<std::unique_ptr<Mdict>> open(const std::string &fn);
+
+  /**
+   * open() with options applied before the file is indexed
+   * @param options see mdict_open_options_t
+   */
+  static result<std::unique_ptr<Mdict>> open(
+      const std::string &fn, const mdict_open_options_t &options);
+
+  /**
+   * lookup() without exceptions: the record path (block read, decompression,
+   * record slicing) reports failures as codes, a failed search or corrupt
+   * block costs no unwinding
+   * @param word the word to search
+   * @param hint MDICT_ACCESS_SCAN keeps the lookup out of the caches
+   * @return the definition, or MDICT_ERR_NOT_FOUND, MDICT_ERR_IO,
+   * MDICT_ERR_DECOMPRESS, MDICT_ERR_CORRUPT, MDICT_ERR_UNSUPPORTED. also
+   * stored in last_error()
+   */
+  result<std::string> find(const std::string &word,
+                           mdict_access_t hint = MDICT_ACCESS_NORMAL);
+
+  /**
+   * locate() without exceptions, see find()
+   * @param resource_name the resource name, matched exactly
+   * @param encoding MDICT_ENCODING_BASE64 or MDICT_ENCODING_HEX
+   * @param hint MDICT_ACCESS_SCAN keeps the lookup out of the caches
+   */
+  result<std::string> find_resource(
+      const std::string &resource_name,
+      mdict_encoding_t encoding = MDICT_ENCODING_BASE64,
+      mdict_access_t hint = MDICT_ACCESS_NORMAL);
+
   /**
    * lookup the definition of a word
    * @param word the word wich we want to search
+   * @param hint MDICT_ACCESS_SCAN keeps the lookup out of the caches
    * @return
    */
-  std::string lookup(std::string word);
+  std::string lookup(std::string word,
+                     mdict_access_t hint = MDICT_ACCESS_NORMAL);
+
+  /**
+   * lookup the definitions of several words. the record blocks of all words
+   * are loaded together: blocks close to each other in the file are read
+   * with one merged read (see set_read_coalescing) and every block is
+   * decompressed once, however many of the words it holds. words in the hot
+   * set are answered from it.
+   * @param words the words
+   * @param hint MDICT_ACCESS_SCAN keeps the lookups out of the caches
+   * @return one definition per word, empty if the word is not found.
+   * last_error() is the error of the first failed word, or MDICT_OK
+   */
+  std::vector<std::string> lookup_batch(
+      const std::vector<std::string> &words,
+      mdict_access_t hint = MDICT_ACCESS_NORMAL);
+
+  /**
+   * lookup every entry of a headword. dictionaries often hold several
+   * entries under one headword (homographs, "arch" and "arch-"), lookup()
+   * returns one of them. the entries are adjacent in the key list and
+   * usually share a record block, each block is decompressed once. the hot
+   * set pins one entry per headword, so only headwords with a single entry
+   * are answered from it.
+   * @param word the headword, matched like lookup() matches it
+   * @param hint MDICT_ACCESS_SCAN keeps the lookup out of the caches
+   * @return (key, definition) pairs in dictionary order, empty if the word
+   * is not found
+   */
+  std::vector<std::pair<std::string, std::string>> lookup_all(
+      const std::string &word, mdict_access_t hint = MDICT_ACCESS_NORMAL);
+
+  /**
+   * number of entries, ordinals of key_at() and entry_at() run from 0 to
+   * entry_count() - 1 in dictionary order
+   */
+  uint64_t entry_count() const { return this->key_list.size(); }
+
+  /**
+   * the key at a position of the dictionary, for paging and sampling
+   * without copying keyList()
+   * @param ordinal position of the key
+   * @param key receives the key
+   * @return MDICT_OK or MDICT_ERR_INVALID_ARGUMENT if ordinal is out of
+   * range
+   */
+  mdict_error_t key_at(uint64_t ordinal, std::string &key);
+
+  /**
+   * the key and definition at a position of the dictionary. the record is
+   * read from its record block only, like lookup() after the key search
+   * @param ordinal position of the entry
+   * @param key receives the key
+   * @param definition receives the definition (for MDD files the resource,
+   * as lookup() returns it)
+   * @param hint MDICT_ACCESS_SCAN keeps the read out of the caches
+   * @return MDICT_OK, MDICT_ERR_INVALID_ARGUMENT or a decoding error
+   */
+  mdict_error_t entry_at(uint64_t ordinal, std::string &key,
+                         std::string &definition,
+                         mdict_access_t hint = MDICT_ACCESS_NORMAL);
 
   /**
    * lookup the definition of a word by system search finction from all keys list
    * @param word the word wich we want to search
+   * @param hint MDICT_ACCESS_SCAN keeps the lookup out of the caches
    * @return
    */
-  std::string lookup0(std::string word);
+  std::string lookup0(std::string word,
+                      mdict_access_t hint = MDICT_ACCESS_NORMAL);
 
   /**
    * Locate a resource in the dictionary
    * @param resource_name The name of the resource to locate
    * @param encoding The encoding type for the result (MDICT_ENCODING_BASE64 or
    * MDICT_ENCODING_HEX)
+   * @param hint MDICT_ACCESS_SCAN keeps the lookup out of the caches
    * @return The located resource content in the specified encoding
    */
   std::string locate(const std::string resource_name,
-                     mdict_encoding_t encoding = MDICT_ENCODING_BASE64);
+                     mdict_encoding_t encoding = MDICT_ENCODING_BASE64,
+                     mdict_access_t hint = MDICT_ACCESS_NORMAL);
 
   /**
-   * suggest simuler word which matches the prefix
-   * @param word the word's prefix
-   * @param prefix_len the word's length (optional)
-   * @return
+   * Stream the raw bytes of a resource into a sink. The record block is
+   * inflated incrementally and only the resource's byte range is delivered,
+   * so memory use does not depend on the resource size. Blocks already in
+   * the block cache are served from memory, streamed blocks are not cached.
+   * @param resource_name The name of the resource to locate
+   * @param sink Receives the bytes in chunks of at most chunk_bytes
+   * @param chunk_bytes Input and output chunk size
+   * @return MDICT_OK, MDICT_ERR_NOT_FOUND, or the error which stopped the
+   * transfer (MDICT_ERR_IO if the sink returned false)
+   */
+  mdict_error_t locate_stream(const std::string &resource_name,
+                              const resource_sink &sink,
+                              size_t chunk_bytes = MDICT_STREAM_CHUNK_BYTES);
+
+  /**
+   * Write the raw bytes of a resource to a file descriptor, see
+   * locate_stream
+   * @param resource_name The name of the resource to locate
+   * @param fd An open, writable file descriptor (file, pipe or socket)
+   * @return MDICT_OK or an error code
+   */
+  mdict_error_t locate_to(const std::string &resource_name, int fd);
+
+  /**
+   * Deliver a byte range of a resource (HTTP range requests, seeking in
+   * audio and video). Small record blocks are decompressed once and kept in
+   * the block cache; large ones are inflated from the closest inflate
+   * checkpoint before offset, so a read costs about length bytes plus at
+   * most MDICT_INFLATE_CHECKPOINT_INTERVAL, wherever it starts.
+   * @param resource_name The name of the resource to locate
+   * @param offset First byte of the range
+   * @param length Length of the range, clipped to the end of the resource
+   * (UINT64_MAX reads to the end)
+   * @param sink Receives the bytes in chunks of at most chunk_bytes
+   * @param resource_size If not nullptr, receives the size of the whole
+   * resource, also when offset is out of range
+   * @param chunk_bytes Input and output chunk size
+   * @return MDICT_OK, MDICT_ERR_NOT_FOUND, MDICT_ERR_INVALID_ARGUMENT if
+   * offset is past the end of the resource, or a transfer error
    */
-  std::vector<std::string> suggest(const std::string word);
+  mdict_error_t locate_range(const std::string &resource_name, uint64_t offset,
+                             uint64_t length, const resource_sink &sink,
+                             uint64_t *resource_size = nullptr,
+                             size_t chunk_bytes = MDICT_STREAM_CHUNK_BYTES);
+
+  /**
+   * RIPEMD-128 of the raw bytes of a resource, as 32 hex characters. equal
+   * resources of different dictionaries have equal hashes, usable as a
+   * strong HTTP ETag. computed on first use (or by index_resource_hashes())
+   * and kept for the lifetime of the dictionary.
+   * @param resource_name The name of the resource
+   * @param hex receives the hash
+   * @return MDICT_OK, MDICT_ERR_NOT_FOUND or a decoding error
+   */
+  mdict_error_t resource_hash(const std::string &resource_name,
+                              std::string &hex);
+  mdict_error_t resource_hash_at(size_t key_index, content_hash &hash);
+
+  /**
+   * the resources a definition references: the src and href values of its
+   * elements, as resource names ("img/a.png" and "sound://a.mp3" become
+   * "\\img\\a.png" and "\\a.mp3"). links to entries (entry://) and to the
+   * web are left out, each name is listed once, in order of appearance.
+   */
+  static std::vector<std::string> resource_names(const std::string &definition);
+
+  /**
+   * fetch the raw bytes of several resources at once, e.g. every image,
+   * sound and style sheet of a definition (see resource_names). the names
+   * are resolved through the key hash index, then the record blocks of all
+   * resources are loaded together: neighbouring blocks with merged reads
+   * (see set_read_coalescing) and every block decompressed once, however
+   * many of the resources it holds
+   * @param names the resource names
+   * @param out receives one payload per name, in the order of names
+   * @param hint MDICT_ACCESS_SCAN keeps the blocks out of the block cache
+   * @return MDICT_OK, or the error of the first resource which failed
+   */
+  mdict_error_t locate_batch(const std::vector<std::string> &names,
+                             std::vector<resource_payload> &out,
+                             mdict_access_t hint = MDICT_ACCESS_NORMAL);
+
+  /**
+   * hash every resource up front, decoding each record block once as a
+   * scan access. afterwards resources stored in the content store by any
+   * dictionary are served without decoding.
+   * @return MDICT_OK or the first decoding error
+   */
+  mdict_error_t index_resource_hashes();
+
+  /**
+   * index of a key in keyList() by exact name, one probe of a hash of the
+   * keys built on first use. safe to call from several threads.
+   * @return -1 if there is no such key (or before init())
+   */
+  long find_key_index(const std::string &name) const;
+
+  /**
+   * index of a word in keyList(), found like lookup() finds it: through the
+   * learned index if enabled, else the block directory and a binary search
+   * in the key block
+   * @return -1 if there is no such word
+   */
+  long lookup_key_index(const std::string &word);
+
+  /**
+   * use a learned model of the key order to find words (see
+   * learned_index): one model evaluation and a search among about
+   * 2 * epsilon neighbouring keys replace the directory and key block
+   * searches. the model is loaded from the sidecar file (sidecar::path_for)
+   * when it matches this dictionary, else built from the key list, which
+   * takes one pass over the keys.
+   * @param epsilon error bound of the model in keys
+   * @param persist write a newly built model to the sidecar file
+   * @return MDICT_OK, or MDICT_ERR_UNSUPPORTED if the keys are not sorted
+   * by their normalized form, in which case lookups keep the search path
+   */
+  mdict_error_t enable_learned_index(
+      uint32_t epsilon = MDICT_LEARNED_INDEX_EPSILON, bool persist = true);
+
+  void disable_learned_index() { this->key_model.reset(); }
+
+  /**
+   * the learned index in use, nullptr if disabled
+   */
+  const learned_index *learned_key_index() const {
+    return this->key_model.get();
+  }
+
+  /**
+   * extract the cross references of every entry (entry:// links and
+   * @@@LINK= redirects) into a link_graph. the graph is loaded from the
+   * sidecar file when it matches this dictionary, else built in one pass
+   * over the record blocks, which stays out of the caches.
+   * @param persist write a newly built graph to the sidecar file
+   * @return MDICT_OK, MDICT_ERR_UNSUPPORTED for resource files, or the error
+   * of a record block read
+   */
+  mdict_error_t build_link_graph(bool persist = true);
+
+  void drop_link_graph() {
+    this->link_prefetch = false;
+    this->graph.reset();
+  }
+
+  /**
+   * the link graph, nullptr if not built
+   */
+  const link_graph *links() const { return this->graph.get(); }
+
+  /**
+   * the keys of the entries a word links to, in key order
+   * @return MDICT_OK, MDICT_ERR_NOT_FOUND, or MDICT_ERR_UNSUPPORTED if the
+   * link graph is not built
+   */
+  mdict_error_t linked_keys(const std::string &word,
+                            std::vector<std::string> &keys);
+
+  /**
+   * after a lookup reads a definition, prefetch the record blocks of the
+   * entries it links to, so following a link usually hits the block cache.
+   * needs the link graph and the prefetcher (enable_prefetch)
+   * @return MDICT_OK or MDICT_ERR_UNSUPPORTED
+   */
+  mdict_error_t set_link_prefetch(bool enabled);
+
+  /**
+   * rewrite the links of the definitions lookups return (lookup, find,
+   * lookup_batch, lookup_all and entry_at) into the client's URL scheme,
+   * see link_rewriter. definitions are rewritten while they are copied out
+   * of the record block, instead of in a second pass over the result. the
+   * definition cache is cleared, it holds the old form.
+   * @param rewriter the prefixes, an empty rewriter turns rewriting off
+   * @return MDICT_OK, or MDICT_ERR_UNSUPPORTED for resource files
+   */
+  mdict_error_t set_link_rewriter(const link_rewriter &rewriter);
+
+  /**
+   * the link rewriter in use, nullptr if definitions are returned as stored
+   */
+  const link_rewriter *link_rewriting() const { return this->rewriter.get(); }
+
+  /**
+   * locate, locate_stream and locate_range for a key already resolved to
+   * its index in keyList(), e.g. by an external index (see resource_set).
+   * the result cache is not consulted.
+   */
+  std::string locate_at(size_t key_index,
+                        mdict_encoding_t encoding = MDICT_ENCODING_BASE64,
+                        mdict_access_t hint = MDICT_ACCESS_NORMAL);
+  mdict_error_t locate_stream_at(size_t key_index, const resource_sink &sink,
+                                 size_t chunk_bytes = MDICT_STREAM_CHUNK_BYTES);
+  mdict_error_t locate_range_at(size_t key_index, uint64_t offset,
+                                uint64_t length, const resource_sink &sink,
+                                uint64_t *resource_size = nullptr,
+                                size_t chunk_bytes = MDICT_STREAM_CHUNK_BYTES);
+  /**
+   * locate_batch for resolved keys, fills err and data of out[i] for
+   * key_indexes[i] and leaves the names alone
+   */
+  mdict_error_t locate_batch_at(const std::vector<size_t> &key_indexes,
+                                std::vector<resource_payload> &out,
+                                mdict_access_t hint = MDICT_ACCESS_NORMAL);
+
+  /**
+   * suggest simuler word which matches the prefix, merged with the overlay
+   * (added keys included, deleted keys left out)
+   * @param word the word's prefix, compared normalized
+   * @param limit maximum number of words
+   * @return the keys in dictionary order
+   */
+  std::vector<std::string> suggest(const std::string word,
+                                   size_t limit = MDICT_SUGGEST_LIMIT);
+
+  /**
+   * attach a writable overlay of user edits (see overlay_store), created
+   * if missing. lookups, suggest() and merged_key_list() consult it before
+   * the dictionary; an overlay miss costs one hash probe. entry_at(),
+   * key_at() and keyList() address the dictionary file only.
+   * @param path overlay file, empty for overlay_store::path_for(file name)
+   * @return MDICT_OK or the error of overlay_store::open()
+   */
+  mdict_error_t attach_overlay(const std::string &path = "");
+
+  void detach_overlay() { this->edits.reset(); }
+
+  /**
+   * the attached overlay, put() and remove() edit the dictionary. nullptr
+   * if none is attached
+   */
+  overlay_store *overlay() { return this->edits.get(); }
+
+  /**
+   * the keys of keyList() merged with the overlay, in dictionary order:
+   * deleted keys are left out, added keys carry record_start
+   * MDICT_OVERLAY_RECORD_START (parse_definition() returns their
+   * definition from the overlay)
+   */
+  std::vector<key_list_item> merged_key_list();
 
   /**
    *
@@ -304,7 +720,9 @@ class Mdict {
   bool contains(char *word, int word_len);
 
   /**
-   * Initialize the dictionary by reading its header and block information
+   * Initialize the dictionary by reading its header and block information.
+   * may be called again to re-read the file, the hot set and the link graph
+   * are dropped then and have to be loaded again
    */
   void init();
 
@@ -326,11 +744,20 @@ class Mdict {
   long reduce_key_info_block_items_vector(std::vector<key_list_item *> wordlist, std::string phrase);
 
   /**
-   * Reduce search range from a record start position
+   * Find the record block containing a record start position, one bucket
+   * table probe plus a binary search over the blocks of that bucket
    * @param record_start Starting position of the record
-   * @return The reduced range
+   * @return The record block id
+   */
+  long reduce_record_block_offset(uint64_t record_start);
+
+  /**
+   * offset of a record block in the decompressed record data
+   * @param rid record block id, the block count gives the total size
    */
-  long reduce_record_block_offset(unsigned long record_start);
+  uint64_t record_block_start(unsigned long rid) const {
+    return this->record_decomp_offsets[rid];
+  }
 
   /**
    *  search definiation from key_text:def pair vector
@@ -343,8 +770,26 @@ class Mdict {
 
   std::vector<key_list_item *> keyList();
 
+  /**
+   * the key block and record block lookup(word) would read, resolved from
+   * the in memory index only: nothing is read from disk or decompressed.
+   * used to replay query logs against a cache model
+   * @param word the word
+   * @return key block then record block. a missing word yields only the
+   * key block it was searched in, or nothing if no key block can hold it
+   */
+  std::vector<block_ref> resolve_blocks(const std::string &word);
+
+  /**
+   * parse the definition of a key list item. the item may be any of several
+   * entries of its headword, so the hot set is not consulted.
+   * @param word the key word
+   * @param record_start the record start of the key
+   * @param hint pass MDICT_ACCESS_SCAN when iterating over keyList()
+   */
   std::string parse_definition(const std::string word,
-                               unsigned long record_start);
+                               uint64_t record_start,
+                               mdict_access_t hint = MDICT_ACCESS_NORMAL);
 
   std::string filetype;
 
@@ -353,8 +798,9 @@ class Mdict {
    * @param offset Starting offset in the file
    * @param len Number of bytes to read
    * @param buf Buffer to store the read data
+   * @return false if the file is shorter or unreadable
    */
-  void readfile(uint64_t offset, uint64_t len, char *buf);
+  bool readfile(uint64_t offset, uint64_t len, char *buf);
 
   /**
    * Read and parse the dictionary header
@@ -380,20 +826,18 @@ class Mdict {
    * @return 0 on success, non-zero on failure
    */
   int decode_key_block_info(char *key_block_info_buffer,
-                            unsigned long kb_info_buff_len, int key_block_num,
-                            int entries_num);
+                            uint64_t kb_info_buff_len, uint64_t key_block_num,
+                            uint64_t entries_num);
 
   /**
-   * Decode a key block from a buffer
-   * @param key_block_buffer Buffer containing the key block
-   * @param kb_buff_len Length of the buffer
+   * Read and decode the key blocks into key_list, a window of
+   * index_window_bytes at a time. each block is released once split.
    * @return 0 on success, non-zero on failure
    */
-  int decode_key_block(unsigned char *key_block_buffer,
-                       unsigned long kb_buff_len);
+  int decode_key_block();
 
   std::vector<key_list_item *> decode_key_block_by_block_id(
-      unsigned long block_id);
+      unsigned long block_id, mdict_access_t hint = MDICT_ACCESS_NORMAL);
 
   /**
    * Read the record block header
@@ -408,7 +852,8 @@ class Mdict {
   int decode_record_block();
 
   std::vector<std::pair<std::string, std::string>> decode_record_block_by_rid(
-      unsigned long rid /* record id */);
+      unsigned long rid /* record id */,
+      mdict_access_t hint = MDICT_ACCESS_NORMAL);
 
   /**
    * Print the dictionary header information
@@ -435,6 +880,193 @@ class Mdict {
    */
   bool endsWith(const std::string &fullString, const std::string &ending);
 
+  /**
+   * error code of the last lookup/locate call
+   * @return MDICT_OK if the last call succeeded
+   */
+  mdict_error_t last_error() const { return this->last_err; }
+
+  /**
+   * use a dedicated logger for this dictionary instead of logger::global()
+   * @param lg the logger, nullptr restores the process wide logger
+   */
+  void set_logger(std::shared_ptr<logger> lg) { this->dict_logger = std::move(lg); }
+
+  /**
+   * the logger used by this dictionary
+   */
+  logger &log() { return dict_logger ? *dict_logger : logger::global(); }
+
+  /**
+   * enable the definition cache, lookup/locate results are cached by
+   * normalized query and dropped when the dictionary file changes
+   * @param capacity_bytes byte budget, 0 disables the cache
+   * @param policy MDICT_CACHE_LRU or MDICT_CACHE_CLOCK
+   */
+  void set_result_cache(uint64_t capacity_bytes,
+                        mdict_cache_policy_t policy = MDICT_CACHE_LRU);
+
+  /**
+   * counters of the definition cache (all zero if disabled)
+   */
+  mdict_cache_stats_t result_cache_stats();
+
+  /**
+   * pin the definitions of the most requested words (see hot_table):
+   * lookups of these words are answered from one arena without touching
+   * the block caches. words are taken in order until the budget is spent,
+   * unknown words are skipped. the record blocks are read once, in file
+   * order, and kept out of the caches. replaces the current hot set.
+   * @param words the hot words, most frequent first
+   * @param capacity_bytes byte budget of the hot set
+   * @return MDICT_OK or the error of a record block read
+   */
+  mdict_error_t load_hot_set(const std::vector<std::string> &words,
+                             uint64_t capacity_bytes = MDICT_HOT_SET_BYTES);
+
+  /**
+   * load_hot_set() from a frequency list, see hot_table::read_list
+   */
+  mdict_error_t load_hot_list(const std::string &path,
+                              uint64_t capacity_bytes = MDICT_HOT_SET_BYTES);
+
+  /**
+   * write the words of the definition cache, most recently used first, as
+   * a list for load_hot_list(). lets a long running process seed the hot
+   * set of the next one from its own traffic.
+   * @return MDICT_OK, MDICT_ERR_UNSUPPORTED if the definition cache is
+   * disabled, or MDICT_ERR_IO
+   */
+  mdict_error_t save_hot_list(const std::string &path,
+                              size_t limit = MDICT_HOT_LIST_LIMIT);
+
+  void drop_hot_set() { this->hot.reset(); }
+
+  /**
+   * counters of the hot set (all zero if none is loaded)
+   */
+  mdict_cache_stats_t hot_set_stats() const;
+
+  /**
+   * give this dictionary a block cache of its own for decompressed key and
+   * record blocks, by default it uses the process wide block_cache::shared().
+   * the budget is split between the decompressed (hot) and the LZO
+   * re-compressed (warm) tier, see block_cache::with_budget
+   * @param capacity_bytes byte budget of both tiers, 0 disables the cache
+   * @param policy MDICT_CACHE_TINYLFU, MDICT_CACHE_LRU or MDICT_CACHE_CLOCK
+   * @param warm_percent share of the budget for the warm tier, 0 disables it
+   */
+  void set_block_cache(
+      uint64_t capacity_bytes, mdict_cache_policy_t policy = MDICT_CACHE_TINYLFU,
+      unsigned int warm_percent = MDICT_DEFAULT_WARM_CACHE_PERCENT);
+
+  /**
+   * use a block cache shared with other dictionaries, entries are keyed by
+   * block_cache_id() so handles never see or drop each other's blocks, not
+   * even two handles on the same file
+   * @param cache the cache, nullptr disables block caching
+   */
+  void set_block_cache(std::shared_ptr<block_cache> cache);
+
+  /**
+   * counters of the block cache (all zero if disabled)
+   */
+  mdict_cache_stats_t block_cache_stats();
+
+  /**
+   * (re)attach this dictionary to the process wide block cache
+   * (block_cache::shared()), whose single budget is spent on the blocks of
+   * whichever dictionaries are in use. that is the default, call it to
+   * reserve a share or to come back from a private cache.
+   * @param reserved_bytes minimum share of the budget kept for this
+   * dictionary, 0 for none
+   */
+  void use_shared_block_cache(uint64_t reserved_bytes = 0);
+
+  /**
+   * counters of this dictionary's blocks in its block cache, the capacity
+   * field is the reservation (all zero if the cache is disabled)
+   */
+  mdict_cache_stats_t block_cache_dict_stats();
+
+  /**
+   * merge the reads of record blocks which are close in the file, used by
+   * lookup_batch and index_resource_hashes. on network storage one larger
+   * read is much cheaper than several small ones.
+   * @param max_gap_bytes blocks separated by at most this many bytes are
+   * read together, the gap is read and discarded
+   * @param max_read_bytes largest merged read, 0 reads every block
+   * separately
+   */
+  void set_read_coalescing(uint64_t max_gap_bytes, uint64_t max_read_bytes) {
+    this->coalesce_gap_bytes = max_gap_bytes;
+    this->coalesce_read_bytes = max_read_bytes;
+  }
+
+  /**
+   * bound the memory init() uses to read the key blocks. they are read a
+   * window at a time and each block is released once its keys are indexed,
+   * so the peak stays near the window plus one decompressed block instead
+   * of the whole key section. a block larger than the window is read alone.
+   * applies to the next init(); open() and mdict_init_with_options() take
+   * it as an option.
+   * @param window_bytes largest read of key blocks, 0 reads one block at a
+   * time
+   */
+  void set_index_window(uint64_t window_bytes) {
+    this->index_window_bytes = window_bytes;
+  }
+
+  /**
+   * number of reads issued to the dictionary file and bytes read
+   */
+  mdict_io_stats_t io_stats() const { return this->io; }
+
+  /**
+   * prefetch the neighbouring key or record block on a background thread
+   * once lookups move through the blocks in one direction (see prefetcher).
+   * prefetched blocks go into the block cache, scans are not watched.
+   * call after init(), the block cache must be enabled.
+   * @return MDICT_OK, MDICT_ERR_UNSUPPORTED without a block cache or
+   * MDICT_ERR_IO if the file can't be opened for the worker
+   */
+  mdict_error_t enable_prefetch(bool enabled = true);
+
+  /**
+   * wait for the queued prefetches to finish
+   */
+  void wait_prefetch() {
+    if (this->prefetch) {
+      this->prefetch->wait_idle();
+    }
+  }
+
+  /**
+   * counters of the prefetcher (all zero if disabled)
+   */
+  mdict_prefetch_stats_t prefetch_stats() {
+    return this->prefetch ? this->prefetch->stats() : mdict_prefetch_stats_t{};
+  }
+
+  /**
+   * default access hint of this dictionary, MDICT_ACCESS_SCAN turns every
+   * following call into a scan access (e.g. for the duration of an export)
+   */
+  void set_access_hint(mdict_access_t hint) { this->access_hint = hint; }
+
+  /**
+   * identity of the opened dictionary file, derived from its size,
+   * modification time and checksums of its first and last bytes (not from
+   * its path), available after init()
+   */
+  uint64_t identity() const { return this->dict_identity; }
+
+  /**
+   * key of this handle's blocks and reservation in the block cache, unique
+   * per Mdict instance
+   */
+  uint64_t block_cache_id() const { return this->cache_id; }
+
  private:
   /********************************
    *     general section           *
@@ -445,6 +1077,198 @@ class Mdict {
   // file input stream
   std::ifstream instream;
 
+  // per dictionary logger, nullptr means logger::global()
+  std::shared_ptr<logger> dict_logger;
+
+  // error code of the last lookup/locate call
+  mdict_error_t last_err = MDICT_OK;
+
+  // size + mtime + head and tail checksum hash, see identity()
+  uint64_t dict_identity = 0;
+  // per instance block cache key, see block_cache_id()
+  const uint64_t cache_id;
+
+  // final lookup results, nullptr if disabled
+  std::unique_ptr<result_cache> results;
+  // pinned definitions of hot words, nullptr if no hot set is loaded
+  std::unique_ptr<hot_table> hot;
+  // background reads of the next block, nullptr if disabled
+  std::unique_ptr<prefetcher> prefetch;
+  // cross references, nullptr if not built
+  std::unique_ptr<link_graph> graph;
+  // see set_link_prefetch()
+  bool link_prefetch = false;
+  // see set_link_rewriter(), nullptr if disabled
+  std::unique_ptr<link_rewriter> rewriter;
+
+  /**
+   * queue the record blocks linked from an entry, rid is its own block
+   */
+  void prefetch_links(uint64_t key_index, unsigned long rid);
+
+  /**
+   * report a block access to the prefetcher, queueing the next block of a
+   * directional run
+   */
+  void note_block_access(uint8_t kind, uint64_t block_id);
+
+  // decompressed key and record blocks, nullptr if disabled
+  std::shared_ptr<block_cache> blocks;
+  /**
+   * drop the reservation and the blocks of this dictionary from a cache
+   * other owners keep using
+   */
+  void release_block_cache();
+
+  // see set_access_hint()
+  mdict_access_t access_hint = MDICT_ACCESS_NORMAL;
+
+  /**
+   * free everything init() derives from the file: the key and record
+   * indexes and the tables built on them (hot set, link graph, learned
+   * index, content hashes). settings such as the caches, the overlay and
+   * the link rewriter stay.
+   */
+  void reset_index();
+
+  bool is_scan(mdict_access_t hint) const {
+    return hint == MDICT_ACCESS_SCAN || this->access_hint == MDICT_ACCESS_SCAN;
+  }
+
+  /**
+   * read and decompress a key block, through the block cache
+   */
+  block_ptr load_key_block(unsigned long block_id, mdict_access_t hint);
+
+  /**
+   * read and decompress a record block, through the block cache
+   */
+  block_ptr load_record_block(unsigned long rid, mdict_access_t hint);
+
+  /**
+   * load_record_block() reporting errors as codes
+   * @param out receives the block if MDICT_OK is returned
+   */
+  mdict_error_t fetch_record_block(unsigned long rid, mdict_access_t hint,
+                                   block_ptr &out);
+
+  /**
+   * load several record blocks, through the block cache. the missing blocks
+   * are read in file order, neighbours merged into one read
+   * @param errs if not nullptr, a block which cannot be read or decoded is
+   * reported in errs (same order as rids) instead of thrown
+   * @return the blocks, in the order of rids
+   */
+  std::vector<block_ptr> load_record_blocks(
+      const std::vector<unsigned long> &rids, mdict_access_t hint,
+      std::vector<mdict_error_t> *errs = nullptr);
+
+  /**
+   * decrypt and decompress a record block read from the file
+   * @param data the comp_size bytes of the block
+   * @param out receives the block if MDICT_OK is returned
+   */
+  mdict_error_t decode_record_data(unsigned long rid, const char *data,
+                                   block_ptr &out) const;
+
+  /**
+   * bytes [start, end) of a decompressed record block as lookup() returns
+   * them: the text of MDX definitions, hex for MDD resources
+   */
+  std::string record_text(const block_ptr &block, uint64_t start,
+                          uint64_t end) const;
+
+  /**
+   * a definition as lookups return it, rewritten by the link rewriter if
+   * one is set
+   */
+  std::string definition_text(const block_ptr &block, uint64_t start,
+                              uint64_t end) const;
+  std::string definition_text(const char *data, size_t len) const;
+
+  // user edits, nullptr if no overlay is attached
+  std::unique_ptr<overlay_store> edits;
+
+  /**
+   * probe the overlay for a word
+   * @return true if the overlay decides the lookup: def holds the edited
+   * definition as lookups return it, rewritten by the link rewriter
+   * (last_err MDICT_OK), or the word is deleted (last_err
+   * MDICT_ERR_NOT_FOUND)
+   */
+  bool overlay_decides(const std::string &word, std::string &def);
+
+  /**
+   * probe the hot set for a normalized word
+   * @return true on hit, def holds the definition as lookups return it
+   */
+  bool pinned_definition(const std::string &normalized, std::string &def);
+
+  // learned model of the key order, nullptr if disabled
+  std::unique_ptr<learned_index> key_model;
+
+  /**
+   * search a normalized key around the rank predicted by key_model
+   * @return index of its first key in key_list, -1 if absent
+   */
+  long learned_find(const std::string &normalized) const;
+
+  // see set_read_coalescing()
+  uint64_t coalesce_gap_bytes = MDICT_COALESCE_MAX_GAP_BYTES;
+  uint64_t coalesce_read_bytes = MDICT_COALESCE_MAX_READ_BYTES;
+  // see set_index_window()
+  uint64_t index_window_bytes = MDICT_INDEX_WINDOW_BYTES;
+
+  // see io_stats()
+  mdict_io_stats_t io{};
+
+  /**
+   * the record of a key
+   * @param key_index index of the key in keyList()
+   * @param rid receives the record block id
+   * @param start receives the record start, relative to the block
+   * @param end receives the record end, relative to the block
+   */
+  void record_range_at(size_t key_index, unsigned long &rid, uint64_t &start,
+                       uint64_t &end);
+
+  /**
+   * record_range_at() reporting errors as codes, MDICT_ERR_INVALID_ARGUMENT
+   * or MDICT_ERR_CORRUPT
+   */
+  mdict_error_t record_range(size_t key_index, unsigned long &rid,
+                             uint64_t &start, uint64_t &end);
+
+  /**
+   * decode and encode the resource of a key, throws mdict_error
+   */
+  std::string locate_record(size_t key_index, mdict_encoding_t encoding,
+                            mdict_access_t hint);
+
+  // content hashes of resources by key index, see resource_hash()
+  std::unordered_map<uint64_t, content_hash> content_hashes;
+
+  /**
+   * the bytes of a small resource, shared through content_store::global()
+   * with every dictionary holding the same resource. throws mdict_error
+   */
+  block_ptr shared_content(size_t key_index, unsigned long rid, uint64_t start,
+                           uint64_t end);
+
+  // inflate checkpoints of the record blocks larger than one interval
+  inflate_checkpoints checkpoints{MDICT_INFLATE_CHECKPOINT_INTERVAL,
+                                  MDICT_INFLATE_CHECKPOINT_BYTES};
+
+  /**
+   * deliver bytes [start, end) of a record block to a sink, inflating the
+   * block chunk by chunk, throws mdict_error
+   * @param fill_cache decompress blocks small enough for the block cache
+   * whole and cache them, instead of streaming them
+   */
+  void stream_record_range(unsigned long rid, uint64_t start, uint64_t end,
+                           const resource_sink &sink, size_t chunk_bytes,
+                           bool fill_cache = false);
+
   /********************************
    *     header section           *
    ********************************/
@@ -469,14 +1293,14 @@ class Mdict {
 
   // key block start offset
   // key_block_start_offset = header_bytes_size + 8;
-  uint32_t key_block_start_offset = 0;
+  uint64_t key_block_start_offset = 0;
 
   // key_block_info_start_offset = key_block_start_offset + info_size (>=2.0:
   // 40+4, <2.0: 16)
-  uint32_t key_block_info_start_offset = 0;
+  uint64_t key_block_info_start_offset = 0;
   // key block compressed start offset = this->key_block_info_start_offset +
   // key_block_info_size
-  uint32_t key_block_compressed_start_offset = 0;
+  uint64_t key_block_compressed_start_offset = 0;
 
   // ---------------------
   //     block key info part
@@ -507,6 +1331,10 @@ class Mdict {
 
   // key list (key word list)
   std::vector<key_list_item *> key_list;
+  // exact key -> index in key_list, built once by the first
+  // find_key_index() after init(), which may run on several threads
+  mutable std::unordered_map<std::string, uint64_t> key_hash;
+  mutable std::unique_ptr<std::once_flag> key_hash_once;
 
   // -------------------
   // record block section
@@ -523,7 +1351,26 @@ class Mdict {
                                       // // TODO
   uint64_t record_block_size;         // [24:32/12:16] - record block size
 
-  std::vector<record_header_item *> record_header;
+  // record block prefix sums, entry i is the (compressed / decompressed)
+  // offset of block i, entry record_block_number the total size
+  std::vector<uint64_t> record_comp_offsets;
+  std::vector<uint64_t> record_decomp_offsets;
+
+  // record_buckets[start >> record_bucket_shift] is the first block that can
+  // contain start, see build_record_buckets()
+  std::vector<uint32_t> record_buckets;
+  int record_bucket_shift = 0;
+
+  void build_record_buckets();
+
+  uint64_t record_comp_size(unsigned long rid) const {
+    return this->record_comp_offsets[rid + 1] - this->record_comp_offsets[rid];
+  }
+
+  uint64_t record_decomp_size(unsigned long rid) const {
+    return this->record_decomp_offsets[rid + 1] -
+           this->record_decomp_offsets[rid];
+  }
 
   // record_block_offset = record_block_info_offset + record_info_size +
   // record_header_size
@@ -538,8 +1385,8 @@ class Mdict {
    */
   // # void split_key_block(unsigned char *key_block, unsigned long
   //  key_block_len);
-  std::vector<key_list_item *> split_key_block(unsigned char *key_block,
-                                               unsigned long key_block_len,
+  std::vector<key_list_item *> split_key_block(const unsigned char *key_block,
+                                               uint64_t key_block_len,
                                                unsigned long block_id);
 
   /********************************
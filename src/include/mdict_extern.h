@@ -31,6 +31,112 @@ typedef enum {
   MDICT_ENCODING_HEX = 1      // Returns raw hex string
 } mdict_encoding_t;
 
+/**
+ * Error codes reported by the library
+ */
+typedef enum {
+  MDICT_OK = 0,                    // Success
+  MDICT_ERR_NOT_FOUND = 1,         // The word/resource is not in the dictionary
+  MDICT_ERR_IO = 2,                // Reading the dictionary file failed
+  MDICT_ERR_DECOMPRESS = 3,        // A block could not be decompressed
+  MDICT_ERR_UNSUPPORTED = 4,       // Compression/encryption not supported
+  MDICT_ERR_CORRUPT = 5,           // Malformed dictionary data
+  MDICT_ERR_INVALID_ARGUMENT = 6,  // Bad argument passed by the caller
+  MDICT_ERR_INTERNAL = 7           // Any other failure
+} mdict_error_t;
+
+/**
+ * Log levels, messages below the configured level are dropped
+ */
+typedef enum {
+  MDICT_LOG_TRACE = 0,
+  MDICT_LOG_DEBUG = 1,
+  MDICT_LOG_INFO = 2,
+  MDICT_LOG_WARN = 3,
+  MDICT_LOG_ERROR = 4,
+  MDICT_LOG_OFF = 5  // Disable logging completely
+} mdict_log_level_t;
+
+/**
+ * Eviction policy of the library caches
+ */
+typedef enum {
+  MDICT_CACHE_LRU = 0,    // Least recently used
+  MDICT_CACHE_CLOCK = 1,  // Second chance, hits do not reorder entries
+  MDICT_CACHE_TINYLFU = 2 // Frequency based admission, scan resistant
+                          // (block cache only)
+} mdict_cache_policy_t;
+
+/**
+ * File I/O counters of a dictionary
+ */
+typedef struct {
+  uint64_t reads;  // positional reads issued to the file
+  uint64_t bytes;  // bytes read, gaps of coalesced reads included
+} mdict_io_stats_t;
+
+/**
+ * Access hint, scans bypass the caches so they do not evict hot entries
+ */
+typedef enum {
+  MDICT_ACCESS_NORMAL = 0,  // Interactive lookups
+  MDICT_ACCESS_SCAN = 1     // Sequential passes (exports, verification, ...)
+} mdict_access_t;
+
+/**
+ * Kinds of links in definitions, see mdict_set_link_prefix
+ */
+typedef enum {
+  MDICT_LINK_ENTRY = 0,    // entry://word, links to other entries
+  MDICT_LINK_SOUND = 1,    // sound://a.mp3
+  MDICT_LINK_FILE = 2,     // file://a.png
+  MDICT_LINK_RESOURCE = 3  // relative src and href values, "img/a.png"
+} mdict_link_kind_t;
+
+/**
+ * Cache counters
+ */
+typedef struct {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  uint64_t entries;   // entries currently cached
+  uint64_t bytes;     // bytes currently charged
+  uint64_t capacity;  // byte budget
+  // second tier of the block cache, zero for single tier caches
+  uint64_t warm_hits;      // hits served by decompressing a warm block
+  uint64_t warm_entries;   // blocks currently kept compressed
+  uint64_t warm_bytes;     // compressed bytes currently charged
+  uint64_t warm_capacity;  // warm tier byte budget
+} mdict_cache_stats_t;
+
+/**
+ * Prefetcher counters
+ */
+typedef struct {
+  uint64_t issued;     // blocks queued for prefetching
+  uint64_t completed;  // blocks read, inflated and offered to the cache
+  uint64_t skipped;    // queued blocks found cached already
+  uint64_t dropped;    // queued blocks dropped for newer ones
+  uint64_t failed;     // blocks which could not be read or decoded
+  uint64_t bytes;      // decompressed bytes of the completed blocks
+} mdict_prefetch_stats_t;
+
+/**
+ * Options applied while a dictionary is opened, see mdict_init_with_options.
+ * Fill with mdict_open_options_init before changing single fields.
+ */
+typedef struct {
+  // largest read of key blocks while indexing, 0 reads one block at a time
+  uint64_t index_window_bytes;
+} mdict_open_options_t;
+
+/**
+ * Log callback, message is only valid for the duration of the call
+ */
+typedef void (*mdict_log_callback_t)(mdict_log_level_t level,
+                                     const char *message, void *user_data);
+
 /**
  * Initialize a dictionary from a file
  * @param dictionary_path Path to the dictionary file (.mdx or .mdd)
@@ -48,6 +154,78 @@ void *mdict_init(const char *dictionary_path);
  */
 void mdict_lookup(void *dict, const char *word, char **result);
 
+/**
+ * Initialize a dictionary from a file, reporting why it failed
+ * @param dictionary_path Path to the dictionary file (.mdx or .mdd)
+ * @param dict Receives the dictionary object, or NULL on failure
+ * @return MDICT_OK, MDICT_ERR_IO if the file can't be read, or the error
+ * found while indexing it (MDICT_ERR_CORRUPT, MDICT_ERR_UNSUPPORTED, ...)
+ */
+mdict_error_t mdict_init_ex(const char *dictionary_path, void **dict);
+
+/**
+ * Set the default open options
+ * @param options Receives the defaults
+ */
+void mdict_open_options_init(mdict_open_options_t *options);
+
+/**
+ * mdict_init_ex() with options that must be known before the file is
+ * indexed
+ * @param dictionary_path Path to the dictionary file (.mdx or .mdd)
+ * @param options The options, NULL for the defaults
+ * @param dict Receives the dictionary object, or NULL on failure
+ * @return MDICT_OK, MDICT_ERR_INVALID_ARGUMENT, or the errors of
+ * mdict_init_ex()
+ */
+mdict_error_t mdict_init_with_options(const char *dictionary_path,
+                                      const mdict_open_options_t *options,
+                                      void **dict);
+
+/**
+ * mdict_lookup() with the error code
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param word The word to look up
+ * @param result Receives the definition (memory will be allocated), or NULL
+ * if the lookup fails
+ * @return MDICT_OK, MDICT_ERR_NOT_FOUND, or the error of the record block
+ * read (MDICT_ERR_IO, MDICT_ERR_DECOMPRESS, MDICT_ERR_CORRUPT, ...)
+ */
+mdict_error_t mdict_lookup_ex(void *dict, const char *word, char **result);
+
+/**
+ * Look up several words at once. The record blocks of all words are read
+ * together, reads of neighbouring blocks are merged (see
+ * mdict_set_read_coalescing), and each block is decompressed once.
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param words The words to look up
+ * @param count Number of words
+ * @param results Receives count definitions, results[i] is allocated for
+ * every word and empty if words[i] is not found
+ */
+void mdict_lookup_batch(void *dict, const char **words, size_t count,
+                        char **results);
+
+/**
+ * Look up every entry of a headword, in dictionary order. mdict_lookup()
+ * returns only one entry of a headword with several entries (homographs).
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param word The headword
+ * @param definitions Receives an array of count definitions (memory will
+ * be allocated, release it with mdict_free_strings), NULL if none
+ * @param count Receives the number of entries
+ * @return MDICT_OK, MDICT_ERR_NOT_FOUND or a decoding error
+ */
+mdict_error_t mdict_lookup_all(void *dict, const char *word,
+                               char ***definitions, uint64_t *count);
+
+/**
+ * Free an array of strings returned by the library
+ * @param strings The array, may be NULL
+ * @param count Number of strings in the array
+ */
+void mdict_free_strings(char **strings, uint64_t count);
+
 /**
  * Locate a word in the dictionary without getting its definition
  * @param dict Dictionary object pointer returned by mdict_init
@@ -59,6 +237,220 @@ void mdict_lookup(void *dict, const char *word, char **result);
 void mdict_locate(void *dict, const char *word, char **result,
                   mdict_encoding_t encoding);
 
+/**
+ * mdict_locate() with the error code
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param name The resource name, matched exactly
+ * @param result Receives the resource (memory will be allocated), or NULL if
+ * it can't be read
+ * @param encoding MDICT_ENCODING_BASE64 or MDICT_ENCODING_HEX
+ * @return MDICT_OK, MDICT_ERR_NOT_FOUND, or the error of the record block
+ * read
+ */
+mdict_error_t mdict_locate_ex(void *dict, const char *name, char **result,
+                              mdict_encoding_t encoding);
+
+/**
+ * Resource write callback, receives the resource bytes in order
+ * @return 0 to continue, non-zero to stop the transfer
+ */
+typedef int (*mdict_write_callback_t)(const void *data, size_t len,
+                                      void *user_data);
+
+/**
+ * Stream the raw bytes of a resource to a callback in fixed size chunks,
+ * without building the whole resource in memory
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param name The resource name (e.g. "\\img\\a.png")
+ * @param callback Receives the resource bytes
+ * @param user_data Opaque pointer passed to the callback
+ * @return MDICT_OK, MDICT_ERR_NOT_FOUND, or the error which stopped the
+ * transfer (MDICT_ERR_IO if the callback stopped it)
+ */
+mdict_error_t mdict_locate_stream(void *dict, const char *name,
+                                  mdict_write_callback_t callback,
+                                  void *user_data);
+
+/**
+ * Write the raw bytes of a resource to a file descriptor (file, pipe or
+ * socket), see mdict_locate_stream
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param name The resource name
+ * @param fd An open, writable file descriptor
+ * @return MDICT_OK or an error code
+ */
+mdict_error_t mdict_locate_to_fd(void *dict, const char *name, int fd);
+
+/**
+ * Stream a byte range of a resource to a callback, for HTTP range requests
+ * and seeking in audio/video. The cost is about the size of the range, not
+ * the offset: large record blocks are resumed from inflate checkpoints.
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param name The resource name
+ * @param offset First byte of the range
+ * @param length Length of the range, clipped to the resource end (UINT64_MAX
+ * reads to the end)
+ * @param callback Receives the bytes of the range
+ * @param user_data Opaque pointer passed to the callback
+ * @param resource_size If not NULL, receives the size of the whole resource
+ * @return MDICT_OK, MDICT_ERR_NOT_FOUND, MDICT_ERR_INVALID_ARGUMENT if offset
+ * is past the end of the resource, or a transfer error
+ */
+mdict_error_t mdict_locate_range(void *dict, const char *name, uint64_t offset,
+                                 uint64_t length,
+                                 mdict_write_callback_t callback,
+                                 void *user_data, uint64_t *resource_size);
+
+/**
+ * Get the content hash (RIPEMD-128, 32 hex characters) of a resource. Equal
+ * resources have equal hashes in every dictionary, suitable for
+ * deduplication and strong ETags.
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param name The resource name
+ * @param hex Receives the null terminated hash, at least 33 bytes
+ * @return MDICT_OK, MDICT_ERR_NOT_FOUND or a decoding error
+ */
+mdict_error_t mdict_resource_hash(void *dict, const char *name, char *hex);
+
+/**
+ * Hash every resource of a dictionary up front (one pass over the record
+ * blocks), so shared resources are served from the content store without
+ * decoding them again
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @return MDICT_OK or the first decoding error
+ */
+mdict_error_t mdict_index_resource_hashes(void *dict);
+
+/**
+ * Set the budget of the process wide content store, which keeps small
+ * resources (up to 1MB) once per distinct content, whichever dictionary
+ * they come from. 16MB by default.
+ * @param capacity_bytes Byte budget, 0 disables the store
+ */
+void mdict_set_content_store(uint64_t capacity_bytes);
+
+/**
+ * Get the counters of the process wide content store
+ * @param stats Receives the counters
+ */
+void mdict_content_store_stats(mdict_cache_stats_t *stats);
+
+/**
+ * One resource of a batch fetch
+ */
+typedef struct {
+  char *name;           // the requested name, null terminated
+  mdict_error_t error;  // MDICT_OK, or why data is NULL
+  uint8_t *data;        // the raw bytes of the resource
+  uint64_t size;        // number of bytes in data
+} mdict_resource_t;
+
+/**
+ * Get the names of the resources a definition references (src and href
+ * values: images, sounds, style sheets), e.g. "\\img\\a.png". Links to
+ * entries and to the web are left out, each name is listed once. Free the
+ * result with mdict_free_strings(names, count).
+ * @param definition The definition, as returned by mdict_lookup
+ * @param names Receives the names, NULL if there are none
+ * @param count Receives the number of names
+ * @return MDICT_OK or MDICT_ERR_INVALID_ARGUMENT
+ */
+mdict_error_t mdict_resource_names(const char *definition, char ***names,
+                                   uint64_t *count);
+
+/**
+ * Fetch the raw bytes of several resources at once. The names are resolved
+ * through a hash of the keys, the record blocks of all resources are read
+ * together (see mdict_set_read_coalescing) and each block is decompressed
+ * once. Free the result with mdict_free_resources(resources, count).
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param names The resource names
+ * @param count Number of names
+ * @param resources Receives count resources, in the order of names
+ * @return MDICT_OK, or the error of the first resource which failed
+ */
+mdict_error_t mdict_locate_batch(void *dict, const char **names, size_t count,
+                                 mdict_resource_t **resources);
+
+/**
+ * Free an array of resources returned by the library
+ * @param resources The array, may be NULL
+ * @param count Number of resources in the array
+ */
+void mdict_free_resources(mdict_resource_t *resources, uint64_t count);
+
+/**
+ * Open the resource volumes of a dictionary (foo.mdd, foo.1.mdd, foo.2.mdd,
+ * ... next to foo.mdx) as one store. Volumes are opened on demand and
+ * indexed together, so a resource is found with one hash probe instead of a
+ * mdict_locate call per volume.
+ * @param dictionary_path Path to the .mdx (or first .mdd) file
+ * @return A resource set handle, or NULL if there is no volume
+ */
+void *mdict_resource_set_open(const char *dictionary_path);
+
+/**
+ * Get the number of volumes of a resource set
+ * @param set Resource set handle returned by mdict_resource_set_open
+ * @param count Receives the number of volumes
+ * @return MDICT_OK or MDICT_ERR_INVALID_ARGUMENT
+ */
+mdict_error_t mdict_resource_set_volumes(void *set, int *count);
+
+/**
+ * mdict_locate on a resource set
+ * @param set Resource set handle returned by mdict_resource_set_open
+ * @param name The resource name
+ * @param result Pointer to store the result (memory will be allocated),
+ * an empty string if the resource is missing
+ * @param encoding MDICT_ENCODING_BASE64 or MDICT_ENCODING_HEX
+ * @return MDICT_OK, MDICT_ERR_INVALID_ARGUMENT or the error of the lookup
+ * (see mdict_resource_set_last_error)
+ */
+mdict_error_t mdict_resource_set_locate(void *set, const char *name,
+                                        char **result,
+                                        mdict_encoding_t encoding);
+
+/**
+ * mdict_locate_stream on a resource set
+ */
+mdict_error_t mdict_resource_set_locate_stream(void *set, const char *name,
+                                               mdict_write_callback_t callback,
+                                               void *user_data);
+
+/**
+ * mdict_locate_range on a resource set
+ */
+mdict_error_t mdict_resource_set_locate_range(void *set, const char *name,
+                                              uint64_t offset, uint64_t length,
+                                              mdict_write_callback_t callback,
+                                              void *user_data,
+                                              uint64_t *resource_size);
+
+/**
+ * mdict_resource_hash on a resource set
+ */
+mdict_error_t mdict_resource_set_hash(void *set, const char *name, char *hex);
+
+/**
+ * mdict_locate_batch on a resource set, each volume reads the blocks of its
+ * resources together
+ */
+mdict_error_t mdict_resource_set_locate_batch(void *set, const char **names,
+                                              size_t count,
+                                              mdict_resource_t **resources);
+
+/**
+ * Get the error code of the last locate call on a resource set
+ */
+mdict_error_t mdict_resource_set_last_error(void *set);
+
+/**
+ * Close a resource set and every volume it opened
+ * @param set Resource set handle returned by mdict_resource_set_open
+ */
+void mdict_resource_set_close(void *set);
+
 /**
  * Parse a word's definition from its record start position
  * @param dict Dictionary object pointer returned by mdict_init
@@ -68,7 +460,7 @@ void mdict_locate(void *dict, const char *word, char **result,
  * allocated)
  */
 void mdict_parse_definition(void *dict, const char *word,
-                            unsigned long record_start, char **result);
+                            uint64_t record_start, char **result);
 
 /**
  * Get a list of all keys in the dictionary
@@ -78,6 +470,35 @@ void mdict_parse_definition(void *dict, const char *word,
  */
 simple_key_item **mdict_keylist(void *dict, uint64_t *len);
 
+/**
+ * Get the number of entries in the dictionary
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @return The number of entries, ordinals run from 0 to count - 1
+ */
+uint64_t mdict_entry_count(void *dict);
+
+/**
+ * Get the key at a position of the dictionary, without copying the key list
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param ordinal Position of the key, in dictionary order
+ * @param key Receives the key (memory will be allocated), NULL on error
+ * @return MDICT_OK or MDICT_ERR_INVALID_ARGUMENT if ordinal is out of range
+ */
+mdict_error_t mdict_key_at(void *dict, uint64_t ordinal, char **key);
+
+/**
+ * Get the key and definition at a position of the dictionary, reading one
+ * record block
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param ordinal Position of the entry, in dictionary order
+ * @param key Receives the key (memory will be allocated), NULL on error
+ * @param definition Receives the definition (memory will be allocated),
+ * NULL on error
+ * @return MDICT_OK, MDICT_ERR_INVALID_ARGUMENT or a decoding error
+ */
+mdict_error_t mdict_entry_at(void *dict, uint64_t ordinal, char **key,
+                             char **definition);
+
 /**
  * Free the memory allocated for a key list
  * @param key_items The key list to free
@@ -94,14 +515,38 @@ int free_simple_key_list(simple_key_item **key_items, uint64_t len);
 int mdict_filetype(void *dict);
 
 /**
- * Get word suggestions based on input
+ * Get word suggestions based on input: the keys starting with the word, in
+ * dictionary order, merged with the overlay if one is attached
  * @param dict Dictionary object pointer returned by mdict_init
  * @param word The input word to get suggestions for
- * @param suggested_words Array to store suggested words
+ * @param suggested_words Array to store suggested words, each free() by the
+ * caller; slots past the last suggestion are set to NULL
  * @param length Maximum number of suggestions to return
  */
 void mdict_suggest(void *dict, char *word, char **suggested_words, int length);
 
+/**
+ * Attach a writable overlay of user edits, created if missing. Lookups,
+ * suggestions and mdict_keylist consult it before the dictionary file
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param path Overlay file, NULL for the dictionary path + ".overlay"
+ * @return MDICT_OK, MDICT_ERR_IO or MDICT_ERR_CORRUPT
+ */
+mdict_error_t mdict_overlay_attach(void *dict, const char *path);
+
+/**
+ * Add or correct an entry in the attached overlay
+ * @return MDICT_OK, or MDICT_ERR_UNSUPPORTED if no overlay is attached
+ */
+mdict_error_t mdict_overlay_put(void *dict, const char *key,
+                                const char *definition);
+
+/**
+ * Delete an entry in the attached overlay, hiding the dictionary's entry
+ * @return MDICT_OK, or MDICT_ERR_UNSUPPORTED if no overlay is attached
+ */
+mdict_error_t mdict_overlay_remove(void *dict, const char *key);
+
 /**
  * Get word stems based on input
  * @param dict Dictionary object pointer returned by mdict_init
@@ -118,6 +563,262 @@ void mdict_stem(void *dict, char *word, char **suggested_words, int length);
  */
 int mdict_destroy(void *dict);
 
+/**
+ * Enable the definition cache of a dictionary. Final lookup/locate results
+ * are cached by normalized query, so repeated queries skip block decoding.
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param capacity_bytes Byte budget of the cache, 0 disables the cache
+ * @param policy Eviction policy (MDICT_CACHE_LRU or MDICT_CACHE_CLOCK)
+ */
+void mdict_set_result_cache(void *dict, uint64_t capacity_bytes,
+                            mdict_cache_policy_t policy);
+
+/**
+ * Get the counters of the definition cache of a dictionary
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param stats Receives the counters (all zero if the cache is disabled)
+ */
+void mdict_result_cache_stats(void *dict, mdict_cache_stats_t *stats);
+
+/**
+ * Pin the definitions of the most requested words, read from a frequency
+ * list (one word per line, optionally followed by a tab and its count).
+ * Lookups of these words are served from memory without touching the block
+ * caches. Words are taken until the budget is spent.
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param path The frequency list
+ * @param capacity_bytes Byte budget of the hot set
+ * @return MDICT_OK, MDICT_ERR_IO, or the error of a record block read
+ */
+mdict_error_t mdict_load_hot_list(void *dict, const char *path,
+                                  uint64_t capacity_bytes);
+
+/**
+ * Write the words of the definition cache, most recently used first, as a
+ * list for mdict_load_hot_list
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param path The list to write
+ * @param limit Most words written
+ * @return MDICT_OK, MDICT_ERR_UNSUPPORTED if the definition cache is
+ * disabled, or MDICT_ERR_IO
+ */
+mdict_error_t mdict_save_hot_list(void *dict, const char *path, uint64_t limit);
+
+/**
+ * Get the counters of the hot set, all zero if none is loaded
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param stats Receives the counters
+ */
+void mdict_hot_set_stats(void *dict, mdict_cache_stats_t *stats);
+
+/**
+ * Give a dictionary a block cache of its own, which keeps decompressed key and
+ * record blocks (hot tier) and LZO re-compressed blocks evicted from it (warm
+ * tier). By default dictionaries use the process wide block cache.
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param capacity_bytes Byte budget of both tiers, 0 disables the cache
+ * @param policy Eviction policy, MDICT_CACHE_TINYLFU resists scans
+ * @param warm_percent Share of the budget for the warm tier (at most 90),
+ * 0 disables it
+ */
+void mdict_set_block_cache(void *dict, uint64_t capacity_bytes,
+                           mdict_cache_policy_t policy,
+                           unsigned int warm_percent);
+
+/**
+ * Get the counters of the block cache of a dictionary
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param stats Receives the counters (all zero if the cache is disabled)
+ */
+void mdict_block_cache_stats(void *dict, mdict_cache_stats_t *stats);
+
+/**
+ * Configure the process wide block cache, one budget shared by every
+ * dictionary without a cache of its own. Defaults to 128MB, a quarter of it
+ * warm, with MDICT_CACHE_TINYLFU. Dictionaries opened before the call keep
+ * the previous cache until mdict_use_shared_block_cache() is called.
+ * @param capacity_bytes Byte budget of both tiers
+ * @param policy Eviction policy
+ * @param warm_percent Share of the budget for the warm tier (at most 90),
+ * 0 disables it
+ */
+void mdict_set_shared_block_cache(uint64_t capacity_bytes,
+                                  mdict_cache_policy_t policy,
+                                  unsigned int warm_percent);
+
+/**
+ * Attach a dictionary to the process wide block cache (the default) and
+ * reserve a share of it
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param reserved_bytes Minimum share of the global budget kept for this
+ * dictionary (its blocks are not evicted while it holds less), 0 for none
+ */
+void mdict_use_shared_block_cache(void *dict, uint64_t reserved_bytes);
+
+/**
+ * Get the counters of one dictionary in its block cache, shared or not.
+ * capacity is the dictionary's reservation.
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param stats Receives the counters
+ */
+void mdict_block_cache_dict_stats(void *dict, mdict_cache_stats_t *stats);
+
+/**
+ * Get the counters of the process wide block cache
+ * @param stats Receives the counters
+ */
+void mdict_shared_block_cache_stats(mdict_cache_stats_t *stats);
+
+/**
+ * Configure how reads of record blocks which are close in the file are
+ * merged into one read by batch lookups and exports. Blocks separated by at
+ * most max_gap_bytes are read together, up to max_read_bytes per read.
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param max_gap_bytes Largest gap read and discarded between two blocks
+ * @param max_read_bytes Largest merged read, 0 reads every block separately
+ */
+void mdict_set_read_coalescing(void *dict, uint64_t max_gap_bytes,
+                               uint64_t max_read_bytes);
+
+/**
+ * Prefetch the next key or record block on a background thread while
+ * lookups move through neighbouring blocks in one direction, such as
+ * alphabetical browsing. Prefetched blocks go into the block cache.
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param enabled Non-zero to start the prefetcher, zero to stop it
+ * @return MDICT_OK, MDICT_ERR_UNSUPPORTED if the block cache is disabled,
+ * or MDICT_ERR_IO
+ */
+mdict_error_t mdict_set_prefetch(void *dict, int enabled);
+
+/**
+ * Get the counters of the prefetcher, all zero if it is disabled
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param stats Receives the counters
+ */
+void mdict_prefetch_stats(void *dict, mdict_prefetch_stats_t *stats);
+
+/**
+ * Extract the cross references of every entry (entry:// links and
+ * @@@LINK= redirects) into a link graph, loaded from or saved to the
+ * sidecar file next to the dictionary. Building it reads every record block
+ * once.
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @return MDICT_OK, MDICT_ERR_UNSUPPORTED for resource files, or the error
+ * of a record block read
+ */
+mdict_error_t mdict_build_link_graph(void *dict);
+
+/**
+ * Get the keys of the entries a word links to, in dictionary order. Free
+ * the result with mdict_free_strings(keys, count).
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param word The word
+ * @param keys Receives the keys, NULL if there are none
+ * @param count Receives the number of keys
+ * @return MDICT_OK, MDICT_ERR_NOT_FOUND, or MDICT_ERR_UNSUPPORTED if the
+ * link graph is not built
+ */
+mdict_error_t mdict_linked_keys(void *dict, const char *word, char ***keys,
+                                uint64_t *count);
+
+/**
+ * After each lookup, prefetch the record blocks of the entries the
+ * definition links to. Needs the link graph and the prefetcher.
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param enabled Non-zero to enable, zero to disable
+ * @return MDICT_OK or MDICT_ERR_UNSUPPORTED
+ */
+mdict_error_t mdict_set_link_prefetch(void *dict, int enabled);
+
+/**
+ * Rewrite the links of a kind in the definitions lookups return, e.g.
+ * entry:// to "/app/entry/" or relative image paths to "/app/res/". The
+ * definitions are rewritten while they are copied out of the record block,
+ * there is no second pass over the result.
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param kind The kind of link
+ * @param prefix The replacement of the scheme (entry://, sound://,
+ * file://), or the prefix put in front of relative src and href values;
+ * NULL leaves the links of the kind alone again
+ * @return MDICT_OK, MDICT_ERR_INVALID_ARGUMENT, or MDICT_ERR_UNSUPPORTED for
+ * resource files
+ */
+mdict_error_t mdict_set_link_prefix(void *dict, mdict_link_kind_t kind,
+                                    const char *prefix);
+
+/**
+ * Get the file I/O counters of a dictionary
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param stats Receives the counters
+ */
+void mdict_io_stats(void *dict, mdict_io_stats_t *stats);
+
+/**
+ * Find words through a learned model of the key order instead of the block
+ * directory and key block searches. The model is loaded from, or built and
+ * saved to, the sidecar file next to the dictionary (dictionary path +
+ * ".idx").
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param epsilon Error bound of the model in keys, 0 for the default (32)
+ * @return MDICT_OK, or MDICT_ERR_UNSUPPORTED if the keys of the dictionary
+ * are not sorted, in which case lookups are unchanged
+ */
+mdict_error_t mdict_enable_learned_index(void *dict, unsigned int epsilon);
+
+/**
+ * Set the access hint of a dictionary. While MDICT_ACCESS_SCAN is set, calls
+ * only read the caches and never insert into them, so a pass over every key
+ * (export, verification) does not evict the entries of interactive lookups.
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param hint MDICT_ACCESS_NORMAL or MDICT_ACCESS_SCAN
+ */
+void mdict_set_access_hint(void *dict, mdict_access_t hint);
+
+/**
+ * Get the error code of the last lookup/locate call on a dictionary
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @return MDICT_OK if the last call succeeded, an error code otherwise
+ */
+mdict_error_t mdict_last_error(void *dict);
+
+/**
+ * Get a static, human readable description of an error code
+ * @param err The error code
+ * @return A null terminated string, never NULL
+ */
+const char *mdict_strerror(mdict_error_t err);
+
+/**
+ * Set the process wide log handler, used by every dictionary without its own
+ * handler. Defaults to stderr with level MDICT_LOG_WARN.
+ * @param callback The log callback, NULL writes to stderr
+ * @param user_data Opaque pointer passed to the callback
+ * @param level Minimum level to deliver (MDICT_LOG_OFF disables logging)
+ */
+void mdict_set_log_handler(mdict_log_callback_t callback, void *user_data,
+                           mdict_log_level_t level);
+
+/**
+ * Limit the number of messages the process wide logger delivers per second
+ * @param per_second Maximum messages per second, 0 disables the limit
+ */
+void mdict_set_log_rate_limit(unsigned int per_second);
+
+/**
+ * Give a dictionary its own log handler instead of the process wide one
+ * @param dict Dictionary object pointer returned by mdict_init
+ * @param callback The log callback, NULL goes back to the process wide
+ * handler (user_data and level are then ignored)
+ * @param user_data Opaque pointer passed to the callback
+ * @param level Minimum level to deliver (MDICT_LOG_OFF disables logging)
+ * @return MDICT_OK or MDICT_ERR_INVALID_ARGUMENT
+ */
+mdict_error_t mdict_dict_set_log_handler(void *dict,
+                                         mdict_log_callback_t callback,
+                                         void *user_data,
+                                         mdict_log_level_t level);
+
 // C wrapper for mime_detect
 const char* c_mime_detect(const char* filename);
   
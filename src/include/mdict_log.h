@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "mdict_extern.h"
+
+/**
+ * Messages below this level are compiled out of the library entirely.
+ * Override with -DMDICT_LOG_COMPILE_LEVEL=<n> (0 = trace ... 5 = off).
+ */
+#ifndef MDICT_LOG_COMPILE_LEVEL
+#define MDICT_LOG_COMPILE_LEVEL 0
+#endif
+
+namespace mdict {
+
+/**
+ * logger routes library diagnostics to a user supplied handler
+ *
+ * the default (process wide) logger writes warnings and errors to stderr,
+ * a logger with level MDICT_LOG_OFF costs a single relaxed atomic load per
+ * call site and never formats its message.
+ *
+ * bursts are limited by a token bucket: at most `rate_limit` messages per
+ * second are delivered, the number of dropped messages is reported with the
+ * next delivered one.
+ */
+class logger {
+ public:
+  /**
+   * constructor
+   * @param handler callback receiving formatted messages (nullptr = stderr)
+   * @param user_data opaque pointer handed back to the callback
+   * @param level minimum level to deliver
+   */
+  explicit logger(mdict_log_callback_t handler = nullptr,
+                  void *user_data = nullptr,
+                  mdict_log_level_t level = MDICT_LOG_WARN);
+
+  /**
+   * the process wide logger, used by every dictionary without its own logger
+   */
+  static logger &global();
+
+  /**
+   * check whether a message of the given level would be delivered
+   */
+  inline bool enabled(mdict_log_level_t level) const {
+    return level >= MDICT_LOG_COMPILE_LEVEL &&
+           static_cast<int>(level) >= min_level.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * replace the handler and the minimum level
+   */
+  void set_handler(mdict_log_callback_t handler, void *user_data,
+                   mdict_log_level_t level);
+
+  void set_level(mdict_log_level_t level);
+
+  /**
+   * limit delivered messages per second, 0 disables rate limiting
+   */
+  void set_rate_limit(unsigned int per_second);
+
+  /**
+   * deliver a message, callers should check enabled() first (see MDICT_LOG)
+   */
+  void write(mdict_log_level_t level, const std::string &message);
+
+ private:
+  std::atomic<int> min_level;
+  std::mutex mtx;
+  mdict_log_callback_t handler;
+  void *user_data;
+
+  // token bucket state, guarded by mtx
+  unsigned int rate_limit = 0;
+  double tokens = 0;
+  std::chrono::steady_clock::time_point last_refill;
+  uint64_t suppressed = 0;
+};
+
+/**
+ * printf style logging through the global logger, meant for the C style
+ * helpers in src/encode which cannot use iostreams
+ */
+void log_printf(mdict_log_level_t level, const char *fmt, ...)
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+}  // namespace mdict
+
+/**
+ * log a stream expression, the expression is evaluated only if the level is
+ * enabled: MDICT_LOG(logger, MDICT_LOG_WARN, "bad block " << id);
+ */
+#define MDICT_LOG(lg, level, expr)                     \
+  do {                                                 \
+    ::mdict::logger &mdict_log_lg_ = (lg);             \
+    if (mdict_log_lg_.enabled(level)) {                \
+      std::ostringstream mdict_log_os_;                \
+      mdict_log_os_ << expr;                           \
+      mdict_log_lg_.write(level, mdict_log_os_.str()); \
+    }                                                  \
+  } while (0)
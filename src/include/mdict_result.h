@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+#include <utility>
+
+#include "mdict_extern.h"
+
+namespace mdict {
+
+/**
+ * the value of an operation or the error code it failed with
+ *
+ * returned by the exception free entry points (Mdict::find and friends).
+ * failures travel as a plain code, so a miss or a broken block costs the
+ * same as a hit, and callers across a language boundary need no try/catch:
+ *
+ *   auto def = dict.find("word");
+ *   if (def) {
+ *     use(*def);
+ *   } else {
+ *     report(def.error());
+ *   }
+ */
+template <typename T>
+class result {
+ public:
+  result(T value) : val(std::move(value)), err(MDICT_OK) {}
+
+  /**
+   * a failure, err is not MDICT_OK
+   */
+  result(mdict_error_t err) : err(err) {}
+
+  bool ok() const { return this->err == MDICT_OK; }
+  explicit operator bool() const { return this->ok(); }
+  mdict_error_t error() const { return this->err; }
+
+  /**
+   * the value, default constructed if the operation failed
+   */
+  const T &value() const & { return this->val; }
+  T &value() & { return this->val; }
+  T &&value() && { return std::move(this->val); }
+
+  const T &operator*() const & { return this->val; }
+  T &operator*() & { return this->val; }
+  const T *operator->() const { return &this->val; }
+
+  T value_or(T fallback) const & { return this->ok() ? this->val : fallback; }
+
+ private:
+  T val{};
+  mdict_error_t err;
+};
+
+}  // namespace mdict
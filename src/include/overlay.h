@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mdict_extern.h"
+
+namespace mdict {
+
+/**
+ * writable layer of user edits over a dictionary
+ *
+ * added, corrected and deleted entries are appended to a log file next to
+ * the dictionary (foo.mdx.overlay) instead of rebuilding the MDX. the log
+ * is replayed into memory when the overlay is opened, the last record of a
+ * key wins. deletions are tombstones, they hide the entries of the
+ * dictionary.
+ *
+ * entries are indexed by their normalized key (the form lookups compare),
+ * in a hash table probed by every lookup and a sorted map used to merge
+ * suggestions and key lists with the dictionary.
+ *
+ * log layout, numbers big endian:
+ *   "MDXOVLY1" | { op u8 | key length u32 | definition length u32 | key |
+ *   definition | adler32 of the record } ...
+ * a torn record at the end of the log (crash while appending) is dropped.
+ */
+class overlay_store {
+ public:
+  enum state {
+    ABSENT,   // the overlay does not know the key
+    PRESENT,  // added or corrected, the overlay holds the definition
+    DELETED   // tombstone, the key is hidden
+  };
+
+  explicit overlay_store(const std::string &path) : path(path) {}
+
+  /**
+   * overlay file of a dictionary
+   */
+  static std::string path_for(const std::string &dict_path) {
+    return dict_path + ".overlay";
+  }
+
+  /**
+   * replay the log, creating it if missing
+   * @return MDICT_OK, MDICT_ERR_IO or MDICT_ERR_CORRUPT if the file is not
+   * an overlay log
+   */
+  mdict_error_t open();
+
+  /**
+   * add or replace the entry of a key
+   */
+  mdict_error_t put(const std::string &key, const std::string &definition);
+
+  /**
+   * delete a key, hiding it in the dictionary as well
+   */
+  mdict_error_t remove(const std::string &key);
+
+  /**
+   * probe the overlay
+   * @param normalized the normalized key, see _s()
+   * @param definition receives the definition if PRESENT, may be nullptr
+   */
+  state get(const std::string &normalized, std::string *definition) const;
+
+  /**
+   * the live entries whose normalized key starts with a prefix, in
+   * normalized order
+   * @return (normalized key, key) pairs
+   */
+  std::vector<std::pair<std::string, std::string>> prefix(
+      const std::string &normalized_prefix) const;
+
+  /**
+   * number of live entries and of tombstones
+   */
+  size_t live_count() const { return this->live; }
+  size_t deleted_count() const { return this->sorted.size() - this->live; }
+
+ private:
+  struct entry {
+    std::string key;
+    std::string definition;
+    bool deleted;
+  };
+
+  enum : uint8_t { OP_PUT = 1, OP_DELETE = 2 };
+
+  std::string path;
+  std::ofstream log;
+  // normalized key -> entry
+  std::map<std::string, entry> sorted;
+  std::unordered_map<std::string, const entry *> hashed;
+  size_t live = 0;
+
+  void apply(uint8_t op, const std::string &key, std::string definition);
+  mdict_error_t append(uint8_t op, const std::string &key,
+                       const std::string &definition);
+};
+
+}  // namespace mdict
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "block_cache.h"
+#include "mdict_extern.h"
+
+// consecutive steps to the neighbouring block before prefetching starts
+#define MDICT_PREFETCH_MIN_RUN 2
+// pending prefetches, the oldest is dropped when a new one arrives
+#define MDICT_PREFETCH_QUEUE 4
+
+namespace mdict {
+
+/**
+ * speculative reads of the block after the current one
+ *
+ * the reader reports every key and record block it accesses. once it moved
+ * to the neighbouring block min_run times in a row, in either direction,
+ * the next block in that direction is read and inflated on a background
+ * thread and offered to the block cache, so browsing and alphabetical
+ * traversals find it decompressed when they get there. staying in the same
+ * block does not break a run, any other jump does.
+ *
+ * the worker reads through its own file stream and never touches the
+ * reader's state; the loader it is given must only use data which is
+ * immutable after init().
+ */
+class prefetcher {
+ public:
+  /**
+   * read and decode one block through the given stream
+   */
+  using loader = std::function<mdict_error_t(
+      std::ifstream &in, const block_key &key, block_ptr &out)>;
+
+  /**
+   * @param path dictionary file, opened again for the worker
+   * @param load reads and decodes a block
+   * @param min_run steps in one direction before prefetching
+   */
+  prefetcher(const std::string &path, loader load,
+             int min_run = MDICT_PREFETCH_MIN_RUN);
+
+  /**
+   * drops the pending prefetches and joins the worker
+   */
+  ~prefetcher();
+
+  prefetcher(const prefetcher &) = delete;
+  prefetcher &operator=(const prefetcher &) = delete;
+
+  /**
+   * false if the file could not be opened for the worker
+   */
+  bool ok() const { return this->in.is_open(); }
+
+  /**
+   * record an access by the reader
+   * @return the direction of the current run (1 forward, -1 backward) once
+   * it is long enough, 0 otherwise
+   */
+  int observe(uint8_t kind, uint64_t block_id);
+
+  /**
+   * queue a block, the worker puts it into cache unless it is there already
+   */
+  void submit(const block_key &key, std::shared_ptr<block_cache> cache);
+
+  /**
+   * block until the queue is empty and the worker idle
+   */
+  void wait_idle();
+
+  mdict_prefetch_stats_t stats();
+
+ private:
+  struct job {
+    block_key key;
+    std::shared_ptr<block_cache> cache;
+  };
+
+  // access history of one block kind
+  struct run {
+    bool seen = false;
+    uint64_t last = 0;
+    int direction = 0;
+    int length = 0;
+  };
+
+  void work();
+
+  std::ifstream in;
+  const loader load;
+  const int min_run;
+  run runs[2];
+
+  std::mutex mtx;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  std::deque<job> queue;
+  bool busy = false;
+  bool stopping = false;
+  mdict_prefetch_stats_t counters{};
+  // started last, after everything it uses
+  std::thread worker;
+};
+
+}  // namespace mdict
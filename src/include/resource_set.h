@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mdict.h"
+
+namespace mdict {
+
+/**
+ * the MDD volumes of a dictionary as one resource store
+ *
+ * large dictionaries split their resources over foo.mdd, foo.1.mdd,
+ * foo.2.mdd, ... next to foo.mdx. a resource_set finds the volumes and keeps
+ * one merged hash index, resource name -> (volume, key index), so a resource
+ * is resolved with a single probe however many volumes there are.
+ *
+ * volumes are opened lazily, in order: a name missing from the index opens
+ * the next volume and merges its keys, until the name is found or every
+ * volume is open. a name present in several volumes resolves to the first.
+ * the opened volumes and one block cache are shared by every call on the
+ * set. like Mdict, a resource_set is not thread safe.
+ */
+class resource_set {
+ public:
+  /**
+   * find the volumes of a dictionary, nothing is opened yet
+   * @param dict_path the .mdx (or first .mdd) file of the dictionary
+   */
+  explicit resource_set(const std::string &dict_path);
+
+  /**
+   * number of volumes found
+   */
+  size_t volume_count() const { return this->paths.size(); }
+
+  /**
+   * path of a volume, 0 is foo.mdd (if present)
+   */
+  const std::string &volume_path(size_t i) const { return this->paths.at(i); }
+
+  /**
+   * number of volumes opened so far
+   */
+  size_t opened_count() const { return this->volumes.size(); }
+
+  /**
+   * check whether a resource exists in any volume
+   */
+  bool contains(const std::string &resource_name);
+
+  /**
+   * see Mdict::locate
+   */
+  std::string locate(const std::string &resource_name,
+                     mdict_encoding_t encoding = MDICT_ENCODING_BASE64);
+
+  /**
+   * see Mdict::locate_stream
+   */
+  mdict_error_t locate_stream(const std::string &resource_name,
+                              const resource_sink &sink,
+                              size_t chunk_bytes = MDICT_STREAM_CHUNK_BYTES);
+
+  /**
+   * see Mdict::locate_range
+   */
+  mdict_error_t locate_range(const std::string &resource_name,
+                             uint64_t offset, uint64_t length,
+                             const resource_sink &sink,
+                             uint64_t *resource_size = nullptr,
+                             size_t chunk_bytes = MDICT_STREAM_CHUNK_BYTES);
+
+  /**
+   * see Mdict::locate_batch. the names are grouped by volume, each volume
+   * loads the record blocks of its resources together
+   */
+  mdict_error_t locate_batch(const std::vector<std::string> &names,
+                             std::vector<resource_payload> &out);
+
+  /**
+   * see Mdict::resource_hash
+   */
+  mdict_error_t resource_hash(const std::string &resource_name,
+                              std::string &hex);
+
+  /**
+   * replace the block cache shared by the volumes, see
+   * Mdict::set_block_cache
+   */
+  void set_block_cache(
+      uint64_t capacity_bytes, mdict_cache_policy_t policy = MDICT_CACHE_TINYLFU,
+      unsigned int warm_percent = MDICT_DEFAULT_WARM_CACHE_PERCENT);
+
+  /**
+   * counters of the shared block cache
+   */
+  mdict_cache_stats_t block_cache_stats();
+
+  /**
+   * error code of the last locate call
+   */
+  mdict_error_t last_error() const { return this->last_err; }
+
+ private:
+  struct entry {
+    uint32_t volume;
+    uint32_t key_index;
+  };
+
+  std::vector<std::string> paths;
+  // opened volumes, volumes[i] is paths[i]; nullptr if it failed to open
+  std::vector<std::unique_ptr<Mdict>> volumes;
+  std::unordered_map<std::string, entry> index;
+  std::shared_ptr<block_cache> blocks;
+  mdict_error_t last_err = MDICT_OK;
+
+  /**
+   * resolve a name, opening volumes until it is found
+   * @return nullptr if no volume has the resource
+   */
+  const entry *resolve(const std::string &resource_name);
+
+  /**
+   * open the next volume and merge its keys into the index
+   */
+  void open_next();
+};
+
+}  // namespace mdict
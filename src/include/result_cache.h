@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mdict_extern.h"
+
+namespace mdict {
+
+/**
+ * result_cache keeps final lookup results (definitions / located resources)
+ *
+ * entries are keyed by a lookup kind tag plus the normalized query, so a hit
+ * costs one hash probe and a copy of the cached string, no key block or
+ * record block is touched.
+ *
+ * the cache is bound to a dictionary identity (size, mtime and checksums of
+ * the first and last bytes of the file, not its path, see Mdict::identity),
+ * rebinding it to a different identity drops every entry.
+ *
+ * eviction is either LRU (hits move the entry to the front) or CLOCK (hits
+ * only set a reference bit, the hand gives referenced entries a second
+ * chance), both bounded by a byte budget covering keys and values.
+ */
+class result_cache {
+ public:
+  /**
+   * lookup kinds, part of the cache key because the same query resolves
+   * differently depending on the entry point
+   */
+  enum kind : char {
+    LOOKUP = 'l',        // Mdict::lookup, keyed by normalized word
+    LOOKUP_EXACT = 'x',  // Mdict::lookup0, keyed by exact word
+    LOCATE_BASE64 = 'b', // Mdict::locate, base64 output
+    LOCATE_HEX = 'h'     // Mdict::locate, hex output
+  };
+
+  /**
+   * constructor
+   * @param capacity_bytes byte budget (keys + values + bookkeeping)
+   * @param policy MDICT_CACHE_LRU or MDICT_CACHE_CLOCK
+   */
+  result_cache(uint64_t capacity_bytes, mdict_cache_policy_t policy);
+
+  /**
+   * build a cache key
+   * @param k lookup kind
+   * @param query normalized (or exact, depending on kind) query
+   */
+  static std::string make_key(kind k, const std::string &query) {
+    std::string key;
+    key.reserve(query.size() + 1);
+    key.push_back(static_cast<char>(k));
+    key.append(query);
+    return key;
+  }
+
+  /**
+   * bind the cache to a dictionary identity, drops all entries on change
+   */
+  void bind(uint64_t identity);
+
+  /**
+   * @param key cache key built by make_key
+   * @param out receives the cached value on hit
+   * @return true on hit
+   */
+  bool get(const std::string &key, std::string &out);
+
+  /**
+   * insert or replace an entry, values larger than the budget are ignored
+   */
+  void put(const std::string &key, const std::string &value);
+
+  void clear();
+
+  /**
+   * the cached queries of one kind, most recently used first under LRU
+   * @param limit most queries returned
+   */
+  std::vector<std::string> queries(kind k, size_t limit);
+
+  mdict_cache_stats_t stats();
+
+ private:
+  struct entry {
+    std::string key;
+    std::string value;
+    bool referenced;
+  };
+  using entry_list = std::list<entry>;
+
+  static uint64_t charge(const std::string &key, const std::string &value) {
+    // approximate the node and hash bucket overhead as well
+    return key.size() + value.size() + 96;
+  }
+
+  void evict();
+
+  std::mutex mtx;
+  const uint64_t capacity;
+  const mdict_cache_policy_t policy;
+  uint64_t identity = 0;
+  uint64_t used = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+
+  // LRU: front is most recent; CLOCK: circular order, hand sweeps forward
+  entry_list entries;
+  entry_list::iterator hand;
+  std::unordered_map<std::string, entry_list::iterator> index;
+};
+
+}  // namespace mdict
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace mdict {
+
+/**
+ * appends big endian numbers to a sidecar section
+ */
+class section_writer {
+ public:
+  void u32(uint32_t v);
+  void u64(uint64_t v);
+  void f64(double v);
+  void bytes(const void *data, size_t len);
+
+  std::string data;
+};
+
+/**
+ * reads the numbers written by section_writer, every read fails (returns
+ * false) once the section is exhausted
+ */
+class section_reader {
+ public:
+  explicit section_reader(const std::string &data) : data(data) {}
+  bool u32(uint32_t &v);
+  bool u64(uint64_t &v);
+  bool f64(double &v);
+  bool bytes(void *out, size_t len);
+  size_t remaining() const { return this->data.size() - this->pos; }
+
+ private:
+  const std::string &data;
+  size_t pos = 0;
+};
+
+/**
+ * index structures derived from a dictionary, stored next to it
+ * (foo.mdx.idx) so they are built once instead of at every open.
+ *
+ * the file is a list of tagged sections (e.g. "PLAI" for the learned key
+ * index) behind a header carrying the identity of the dictionary it was
+ * built from, see Mdict::identity(). a sidecar of another version of the
+ * dictionary, a truncated or a corrupt file fails to load and is rebuilt.
+ *
+ * layout, numbers big endian:
+ *   "MDXSIDE1" | identity u64 | section count u32 |
+ *   { tag u32 | length u64 | payload } ... | adler32 of all preceding bytes
+ */
+class sidecar {
+ public:
+  explicit sidecar(uint64_t identity) : identity(identity) {}
+
+  /**
+   * sidecar file of a dictionary
+   */
+  static std::string path_for(const std::string &dict_path) {
+    return dict_path + ".idx";
+  }
+
+  /**
+   * read a sidecar file
+   * @return false if it is missing, corrupt or built from another file
+   */
+  bool load(const std::string &path);
+
+  /**
+   * write the sidecar, through a temporary file renamed over path
+   * @return false if the file cannot be written
+   */
+  bool save(const std::string &path) const;
+
+  /**
+   * @return the payload of a section, nullptr if absent
+   */
+  const std::string *section(const std::string &tag) const;
+
+  /**
+   * add or replace a section, tags are four ASCII characters
+   */
+  void set_section(const std::string &tag, std::string payload);
+
+ private:
+  uint64_t identity;
+  std::map<std::string, std::string> sections;
+};
+
+}  // namespace mdict
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "miniz/miniz.h"
+#include "mdict_log.h"
 
 /**
  * Decompresses zlib-compressed data into a vector
@@ -43,7 +44,7 @@ inline std::vector<uint8_t> zlib_mem_uncompress(const void *source,
       continue;
     }
     // 其他错误抛出异常
-    printf("ZLIBERR %d\n", err);
+    mdict::log_printf(MDICT_LOG_DEBUG, "zlib uncompress error %d", err);
     return std::vector<uint8_t>();
   }
 }
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+/**
+ * mdict_indexbench: learned key index against the search path
+ *
+ * every word of the list is resolved to its key index
+ * (Mdict::lookup_key_index, index only, nothing is decompressed) first by
+ * the block directory and key block search, then through the learned
+ * index with each error bound. the output is CSV:
+ *
+ *   method,epsilon,segments,model_bytes,lookups,found,ns_per_lookup
+ *
+ * a word found by one method and not by the other is reported on stderr.
+ */
+
+#include <unistd.h>  // for getopt
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "include/mdict.h"
+
+void print_usage(const char *program_name) {
+  std::cout
+      << "Usage: " << program_name
+      << " [options] <dictionary_file> <word_list>\n"
+      << "Options:\n"
+      << "  -e <bounds>    Comma separated error bounds (default: 8,32,128)\n"
+      << "  -r <rounds>    Passes over the word list (default: 5)\n"
+      << "  -h             Display this help message\n"
+      << "\n"
+      << "The word list holds one word per line. Output is CSV on stdout.\n";
+}
+
+// resolve every word rounds times, returns the key indices of the last pass
+std::vector<long> run(mdict::Mdict &dict, const std::vector<std::string> &words,
+                      int rounds, double &ns_per_lookup) {
+  std::vector<long> found(words.size());
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (size_t i = 0; i < words.size(); i++) {
+      found[i] = dict.lookup_key_index(words[i]);
+    }
+  }
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+  ns_per_lookup =
+      words.empty() ? 0.0 : double(ns) / (double(words.size()) * rounds);
+  return found;
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<uint32_t> bounds{8, 32, 128};
+  int rounds = 5;
+  int opt;
+  while ((opt = getopt(argc, argv, "e:r:h")) != -1) {
+    switch (opt) {
+      case 'e': {
+        bounds.clear();
+        std::stringstream ss(optarg);
+        std::string part;
+        while (std::getline(ss, part, ',')) {
+          bounds.push_back(static_cast<uint32_t>(std::stoul(part)));
+        }
+        break;
+      }
+      case 'r':
+        rounds = std::max(1, std::atoi(optarg));
+        break;
+      case 'h':
+        print_usage(argv[0]);
+        return 0;
+      default:
+        print_usage(argv[0]);
+        return 1;
+    }
+  }
+  if (argc - optind != 2) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  mdict::Mdict dict(argv[optind]);
+  try {
+    dict.init();
+  } catch (std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return 1;
+  }
+
+  std::ifstream list(argv[optind + 1]);
+  if (!list) {
+    std::cerr << "Error: cannot open " << argv[optind + 1] << "\n";
+    return 1;
+  }
+  std::vector<std::string> words;
+  std::string line;
+  while (std::getline(list, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (!line.empty()) {
+      words.push_back(line);
+    }
+  }
+
+  auto count = [](const std::vector<long> &v) {
+    size_t n = 0;
+    for (long i : v) {
+      n += i >= 0;
+    }
+    return n;
+  };
+
+  std::cout << "method,epsilon,segments,model_bytes,lookups,found,"
+               "ns_per_lookup\n";
+  double ns = 0;
+  std::vector<long> baseline = run(dict, words, rounds, ns);
+  std::cout << "search,0,0,0," << words.size() << "," << count(baseline) << ","
+            << ns << "\n";
+
+  for (uint32_t eps : bounds) {
+    if (dict.enable_learned_index(eps, false) != MDICT_OK) {
+      std::cerr << "Error: keys are not sorted, no learned index\n";
+      return 1;
+    }
+    std::vector<long> learned = run(dict, words, rounds, ns);
+    for (size_t i = 0; i < words.size(); i++) {
+      if ((baseline[i] >= 0) != (learned[i] >= 0)) {
+        std::cerr << "mismatch (epsilon " << eps << "): " << words[i] << "\n";
+      }
+    }
+    const mdict::learned_index *model = dict.learned_key_index();
+    std::cout << "learned," << eps << "," << model->segment_count() << ","
+              << model->memory_bytes() << "," << words.size() << ","
+              << count(learned) << "," << ns << "\n";
+  }
+  return 0;
+}
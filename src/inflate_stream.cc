@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#include "include/inflate_stream.h"
+
+#include <algorithm>
+
+#include "include/mdict.h"
+
+namespace mdict {
+
+// ------------------------------------------
+// inflate_checkpoints
+// ------------------------------------------
+
+inflate_checkpoints::inflate_checkpoints(uint64_t interval_bytes,
+                                         uint64_t capacity_bytes)
+    : interval_bytes(std::max<uint64_t>(interval_bytes, TINFL_LZ_DICT_SIZE)),
+      capacity_bytes(capacity_bytes) {}
+
+bool inflate_checkpoints::find(uint64_t block_id, uint64_t out_pos,
+                               inflate_checkpoint &cp) {
+  std::lock_guard<std::mutex> lock(mtx);
+  auto b = blocks.find(block_id);
+  if (b == blocks.end()) {
+    return false;
+  }
+  auto it = b->second.points.upper_bound(out_pos);
+  if (it == b->second.points.begin()) {
+    return false;
+  }
+  lru.splice(lru.begin(), lru, b->second.lru_pos);
+  cp = std::prev(it)->second;
+  return true;
+}
+
+void inflate_checkpoints::add(uint64_t block_id, const inflate_checkpoint &cp) {
+  if (charge() > capacity_bytes) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mtx);
+  auto b = blocks.find(block_id);
+  if (b == blocks.end()) {
+    lru.push_front(block_id);
+    b = blocks.emplace(block_id, block_entry()).first;
+    b->second.lru_pos = lru.begin();
+  } else {
+    lru.splice(lru.begin(), lru, b->second.lru_pos);
+  }
+  auto &points = b->second.points;
+  // one checkpoint per interval
+  auto next = points.upper_bound(cp.out_pos);
+  if (next != points.begin() &&
+      std::prev(next)->first / interval_bytes == cp.out_pos / interval_bytes) {
+    return;
+  }
+  points.emplace(cp.out_pos, cp);
+  used_bytes += charge();
+
+  while (used_bytes > capacity_bytes && !lru.empty()) {
+    uint64_t victim = lru.back();
+    if (victim == block_id && lru.size() == 1) {
+      // the block being read does not fit, drop its earliest checkpoint
+      points.erase(points.begin());
+      used_bytes -= charge();
+      continue;
+    }
+    auto v = blocks.find(victim);
+    used_bytes -= v->second.points.size() * charge();
+    blocks.erase(v);
+    lru.pop_back();
+  }
+}
+
+void inflate_checkpoints::clear() {
+  std::lock_guard<std::mutex> lock(mtx);
+  blocks.clear();
+  lru.clear();
+  used_bytes = 0;
+}
+
+size_t inflate_checkpoints::size() {
+  std::lock_guard<std::mutex> lock(mtx);
+  size_t n = 0;
+  for (const auto &b : blocks) {
+    n += b.second.points.size();
+  }
+  return n;
+}
+
+// ------------------------------------------
+// inflate_range
+// ------------------------------------------
+
+void inflate_range(const stream_reader &read, uint64_t comp_size,
+                   uint64_t start, uint64_t end, const stream_sink &sink,
+                   size_t chunk_bytes, inflate_checkpoints *store,
+                   uint64_t block_id) {
+  inflate_checkpoint st;
+  if (!store || !store->find(block_id, start, st)) {
+    tinfl_init(&st.decomp);
+    st.window.assign(TINFL_LZ_DICT_SIZE, 0);
+  }
+  uint64_t next_checkpoint = UINT64_MAX;
+  if (store) {
+    next_checkpoint = (st.out_pos / store->interval() + 1) * store->interval();
+  }
+
+  std::vector<uint8_t> in(chunk_bytes);
+  size_t in_ofs = 0;
+  size_t in_len = 0;
+
+  while (st.out_pos < end) {
+    if (in_ofs == in_len && st.in_pos < comp_size) {
+      in_len = static_cast<size_t>(
+          std::min<uint64_t>(chunk_bytes, comp_size - st.in_pos));
+      read(st.in_pos, in_len, in.data());
+      in_ofs = 0;
+    }
+    size_t in_size = in_len - in_ofs;
+    size_t out_size = TINFL_LZ_DICT_SIZE - st.window_ofs;
+    mz_uint32 flags = TINFL_FLAG_PARSE_ZLIB_HEADER;
+    if (st.in_pos + in_size < comp_size) {
+      flags |= TINFL_FLAG_HAS_MORE_INPUT;
+    }
+    tinfl_status status =
+        tinfl_decompress(&st.decomp, in.data() + in_ofs, &in_size,
+                         st.window.data(), st.window.data() + st.window_ofs,
+                         &out_size, flags);
+    in_ofs += in_size;
+    st.in_pos += in_size;
+
+    // overlap of [out_pos, out_pos + out_size) with [start, end)
+    uint64_t from = std::max(st.out_pos, start);
+    uint64_t to = std::min(st.out_pos + out_size, end);
+    for (uint64_t pos = from; pos < to; pos += chunk_bytes) {
+      size_t n = static_cast<size_t>(std::min<uint64_t>(chunk_bytes, to - pos));
+      if (!sink(st.window.data() + st.window_ofs + (pos - st.out_pos), n)) {
+        throw mdict_error(MDICT_ERR_IO, "resource sink stopped the transfer");
+      }
+    }
+    st.out_pos += out_size;
+    st.window_ofs = (st.window_ofs + out_size) & (TINFL_LZ_DICT_SIZE - 1);
+
+    if (status == TINFL_STATUS_DONE) {
+      break;
+    }
+    if (status < 0) {
+      throw mdict_error(MDICT_ERR_DECOMPRESS, "record block inflate failed");
+    }
+    if (status == TINFL_STATUS_NEEDS_MORE_INPUT && st.in_pos >= comp_size) {
+      break;
+    }
+    if (st.out_pos >= next_checkpoint) {
+      store->add(block_id, st);
+      next_checkpoint = (st.out_pos / store->interval() + 1) * store->interval();
+    }
+  }
+  if (st.out_pos < end) {
+    throw mdict_error(MDICT_ERR_CORRUPT, "record block shorter than its header");
+  }
+}
+
+}  // namespace mdict
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#include "include/learned_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mdict {
+
+uint64_t learned_index::pack(const std::string &normalized_key) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < 8; i++) {
+    v <<= 8;
+    if (i < normalized_key.size()) {
+      v |= static_cast<unsigned char>(normalized_key[i]);
+    }
+  }
+  return v;
+}
+
+void learned_index::build(const std::vector<uint64_t> &keys,
+                          uint32_t epsilon) {
+  this->segments.clear();
+  this->eps = epsilon;
+  this->key_count = keys.size();
+  this->ties = keys.empty() ? 0 : 1;
+
+  const double inf = std::numeric_limits<double>::infinity();
+  segment cur{0, 0, 0.0};
+  double slope_lo = 0.0;
+  double slope_hi = inf;
+  auto close = [&]() {
+    cur.slope = slope_hi == inf ? 0.0 : (slope_lo + slope_hi) / 2;
+    this->segments.push_back(cur);
+  };
+
+  size_t run_start = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    // one point per distinct number, at the rank of its first key
+    if (i > 0 && keys[i] == keys[i - 1]) {
+      this->ties = std::max<uint64_t>(this->ties, i - run_start + 1);
+      continue;
+    }
+    run_start = i;
+    if (i == 0) {
+      cur = segment{keys[i], i, 0.0};
+      continue;
+    }
+    double dx = static_cast<double>(keys[i] - cur.key);
+    double dy = static_cast<double>(i) - static_cast<double>(cur.rank);
+    double lo = (dy - epsilon) / dx;
+    double hi = (dy + epsilon) / dx;
+    if (lo > slope_hi || hi < slope_lo) {
+      close();
+      cur = segment{keys[i], i, 0.0};
+      slope_lo = 0.0;
+      slope_hi = inf;
+      continue;
+    }
+    slope_lo = std::max(slope_lo, lo);
+    slope_hi = std::min(slope_hi, hi);
+  }
+  if (!keys.empty()) {
+    close();
+  }
+  this->segments.shrink_to_fit();
+}
+
+size_t learned_index::predict(uint64_t key) const {
+  auto it = std::upper_bound(
+      this->segments.begin(), this->segments.end(), key,
+      [](uint64_t k, const segment &s) { return k < s.key; });
+  if (it == this->segments.begin()) {
+    return 0;
+  }
+  uint64_t next_rank = it == this->segments.end() ? this->key_count : it->rank;
+  const segment &s = *std::prev(it);
+  double pred = static_cast<double>(s.rank) +
+                s.slope * static_cast<double>(key - s.key);
+  // stay within the ranks of the segment
+  pred = std::min(std::round(pred), static_cast<double>(next_rank));
+  return std::max<size_t>(static_cast<size_t>(pred), s.rank);
+}
+
+void learned_index::window(uint64_t key, size_t &lo, size_t &hi) const {
+  size_t p = this->predict(key);
+  // predict() rounds, so allow one more key on either side
+  size_t slack = static_cast<size_t>(this->eps) + 1;
+  lo = p > slack ? p - slack : 0;
+  hi = static_cast<size_t>(std::min<uint64_t>(
+      this->key_count, static_cast<uint64_t>(p) + slack + this->ties));
+}
+
+void learned_index::serialize(section_writer &w) const {
+  w.u32(this->eps);
+  w.u64(this->key_count);
+  w.u64(this->segments.size());
+  for (const auto &s : this->segments) {
+    w.u64(s.key);
+    w.u64(s.rank);
+    w.f64(s.slope);
+  }
+  w.u64(this->ties);
+}
+
+bool learned_index::deserialize(section_reader &r) {
+  uint32_t epsilon = 0;
+  uint64_t count = 0;
+  uint64_t n = 0;
+  if (!r.u32(epsilon) || !r.u64(count) || !r.u64(n) ||
+      n > r.remaining() / 24) {
+    return false;
+  }
+  std::vector<segment> loaded(static_cast<size_t>(n));
+  for (auto &s : loaded) {
+    if (!r.u64(s.key) || !r.u64(s.rank) || !r.f64(s.slope)) {
+      return false;
+    }
+  }
+  uint64_t max_run = 0;
+  if (!r.u64(max_run)) {
+    return false;
+  }
+  this->segments = std::move(loaded);
+  this->eps = epsilon;
+  this->key_count = count;
+  this->ties = max_run;
+  return true;
+}
+
+}  // namespace mdict
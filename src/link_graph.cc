@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#include "include/link_graph.h"
+
+#include <algorithm>
+
+namespace mdict {
+
+static const char entry_scheme[] = "entry://";
+static const char redirect_prefix[] = "@@@LINK=";
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// the link target between begin and end, without fragment and escapes
+static std::string link_target(const char *begin, const char *end) {
+  std::string word;
+  for (const char *p = begin; p < end; p++) {
+    if (*p == '#') {
+      break;
+    }
+    if (*p == '%' && end - p >= 3 && hex_value(p[1]) >= 0 &&
+        hex_value(p[2]) >= 0) {
+      word += static_cast<char>(hex_value(p[1]) * 16 + hex_value(p[2]));
+      p += 2;
+    } else {
+      word += *p;
+    }
+  }
+  // trailing blanks of a redirect line
+  while (!word.empty() && (word.back() == ' ' || word.back() == '\t')) {
+    word.pop_back();
+  }
+  return word;
+}
+
+void link_graph::extract(const std::string &definition,
+                         std::vector<std::string> &words) {
+  const char *data = definition.data();
+  const char *end = data + definition.size();
+
+  const size_t redirect_len = sizeof(redirect_prefix) - 1;
+  if (definition.compare(0, redirect_len, redirect_prefix) == 0) {
+    const char *start = data + redirect_len;
+    const char *stop = start;
+    while (stop < end && *stop != '\r' && *stop != '\n' && *stop != '\0') {
+      stop++;
+    }
+    std::string word = link_target(start, stop);
+    if (!word.empty()) {
+      words.push_back(std::move(word));
+    }
+  }
+
+  const size_t scheme_len = sizeof(entry_scheme) - 1;
+  for (size_t pos = definition.find(entry_scheme); pos != std::string::npos;
+       pos = definition.find(entry_scheme, pos)) {
+    const char *start = data + pos + scheme_len;
+    const char *stop = start;
+    // the link ends with its attribute value
+    while (stop < end && *stop != '"' && *stop != '\'' && *stop != '>' &&
+           *stop != '<' && *stop != '\0') {
+      stop++;
+    }
+    std::string word = link_target(start, stop);
+    if (!word.empty()) {
+      words.push_back(std::move(word));
+    }
+    pos = stop - data;
+  }
+}
+
+void link_graph::build(std::vector<std::vector<uint32_t>> targets) {
+  this->offsets.assign(1, 0);
+  this->offsets.reserve(targets.size() + 1);
+  this->targets.clear();
+  for (auto &t : targets) {
+    std::sort(t.begin(), t.end());
+    t.erase(std::unique(t.begin(), t.end()), t.end());
+    this->targets.insert(this->targets.end(), t.begin(), t.end());
+    this->offsets.push_back(this->targets.size());
+    // release as we go, the graph is built from a full dictionary pass
+    std::vector<uint32_t>().swap(t);
+  }
+  this->targets.shrink_to_fit();
+}
+
+std::pair<const uint32_t *, const uint32_t *> link_graph::links(
+    uint64_t entry) const {
+  if (entry >= this->size()) {
+    return {nullptr, nullptr};
+  }
+  const uint32_t *base = this->targets.data();
+  return {base + this->offsets[entry], base + this->offsets[entry + 1]};
+}
+
+void link_graph::serialize(section_writer &w) const {
+  w.u64(this->size());
+  w.u64(this->targets.size());
+  for (size_t i = 1; i < this->offsets.size(); i++) {
+    // per entry link counts, smaller than the offsets
+    w.u32(static_cast<uint32_t>(this->offsets[i] - this->offsets[i - 1]));
+  }
+  for (uint32_t t : this->targets) {
+    w.u32(t);
+  }
+}
+
+bool link_graph::deserialize(section_reader &r) {
+  uint64_t entries = 0;
+  uint64_t edges = 0;
+  if (!r.u64(entries) || !r.u64(edges) ||
+      entries > r.remaining() / 4 || edges > r.remaining() / 4 ||
+      (entries + edges) * 4 != r.remaining()) {
+    return false;
+  }
+  std::vector<uint64_t> loaded_offsets(static_cast<size_t>(entries) + 1, 0);
+  for (size_t i = 1; i <= entries; i++) {
+    uint32_t count = 0;
+    r.u32(count);
+    loaded_offsets[i] = loaded_offsets[i - 1] + count;
+  }
+  if (loaded_offsets.back() != edges) {
+    return false;
+  }
+  std::vector<uint32_t> loaded_targets(static_cast<size_t>(edges));
+  for (auto &t : loaded_targets) {
+    r.u32(t);
+    if (t >= entries) {
+      return false;
+    }
+  }
+  this->offsets = std::move(loaded_offsets);
+  this->targets = std::move(loaded_targets);
+  return true;
+}
+
+}  // namespace mdict
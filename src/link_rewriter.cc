@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#include "include/link_rewriter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace mdict {
+
+// schemes of MDICT_LINK_ENTRY, MDICT_LINK_SOUND and MDICT_LINK_FILE
+static const char *const scheme_names[] = {"entry", "sound", "file"};
+
+static bool equal_nocase(const char *data, const char *lower, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (std::tolower(static_cast<unsigned char>(data[i])) != lower[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// the end of an unquoted or quoted attribute value
+static bool value_ends(char c) {
+  return c == '"' || c == '\'' || c == '>' || c == '\0' ||
+         std::isspace(static_cast<unsigned char>(c));
+}
+
+void link_rewriter::set_prefix(mdict_link_kind_t kind,
+                               const std::string &prefix) {
+  this->prefixes.at(kind) = prefix;
+  this->enabled.at(kind) = true;
+}
+
+void link_rewriter::clear_prefix(mdict_link_kind_t kind) {
+  this->prefixes.at(kind).clear();
+  this->enabled.at(kind) = false;
+}
+
+const std::string *link_rewriter::prefix(mdict_link_kind_t kind) const {
+  return this->enabled.at(kind) ? &this->prefixes[kind] : nullptr;
+}
+
+bool link_rewriter::empty() const {
+  for (bool e : this->enabled) {
+    if (e) {
+      return false;
+    }
+  }
+  return true;
+}
+
+long link_rewriter::relative_value(const char *data, size_t len,
+                                   size_t value) {
+  if (value >= len || value_ends(data[value]) || data[value] == '#') {
+    return -1;
+  }
+  if (data[value] == '/' && value + 1 < len && data[value + 1] == '/') {
+    // network path, //host/...
+    return -1;
+  }
+  // letters, digits, '+', '-' and '.' up to a ':' are a scheme
+  for (size_t p = value; p < len && !value_ends(data[p]); p++) {
+    char c = data[p];
+    if (c == ':') {
+      return -1;
+    }
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '+' && c != '-' &&
+        c != '.') {
+      break;
+    }
+  }
+  if (data[value] == '.' && value + 1 < len && data[value + 1] == '/') {
+    return 2;
+  }
+  return data[value] == '/' ? 1 : 0;
+}
+
+void link_rewriter::rewrite(const char *data, size_t len,
+                            std::string &out) const {
+  // the growth of one link, at most
+  size_t growth = 0;
+  for (size_t k = 0; k < this->prefixes.size(); k++) {
+    if (!this->enabled[k]) {
+      continue;
+    }
+    size_t replaced = k < 3 ? strlen(scheme_names[k]) + 3 : 0;
+    if (this->prefixes[k].size() > replaced) {
+      growth = std::max(growth, this->prefixes[k].size() - replaced);
+    }
+  }
+  out.reserve(out.size() + len +
+              growth * (len / MDICT_REWRITE_LINK_SPACING + 1));
+
+  const bool resources = this->enabled[MDICT_LINK_RESOURCE];
+  size_t copied = 0;
+  for (size_t i = 0; i < len; i++) {
+    if (data[i] == ':') {
+      // scheme:// starting a word
+      if (i + 2 >= len || data[i + 1] != '/' || data[i + 2] != '/') {
+        continue;
+      }
+      for (size_t k = 0; k < 3; k++) {
+        size_t n = strlen(scheme_names[k]);
+        if (!this->enabled[k] || i < copied + n ||
+            !equal_nocase(data + i - n, scheme_names[k], n) ||
+            (i > n &&
+             std::isalnum(static_cast<unsigned char>(data[i - n - 1])))) {
+          continue;
+        }
+        out.append(data + copied, i - n - copied);
+        out += this->prefixes[k];
+        copied = i + 3;
+        i += 2;
+        break;
+      }
+    } else if (data[i] == '=' && resources) {
+      // src= or href= after a blank
+      size_t n = 0;
+      if (i >= 4 && equal_nocase(data + i - 3, "src", 3)) {
+        n = 3;
+      } else if (i >= 5 && equal_nocase(data + i - 4, "href", 4)) {
+        n = 4;
+      }
+      if (n == 0 || i < copied + n + 1 ||
+          !std::isspace(static_cast<unsigned char>(data[i - n - 1]))) {
+        continue;
+      }
+      size_t value = i + 1;
+      if (value < len && (data[value] == '"' || data[value] == '\'')) {
+        value++;
+      }
+      long skip = relative_value(data, len, value);
+      if (skip < 0) {
+        continue;
+      }
+      out.append(data + copied, value - copied);
+      out += this->prefixes[MDICT_LINK_RESOURCE];
+      copied = value + static_cast<size_t>(skip);
+      i = copied - 1;
+    }
+  }
+  out.append(data + copied, len - copied);
+}
+
+}  // namespace mdict
@@ -11,13 +11,19 @@
 #include <encode/api.h>
 #include <encode/base64.h>
 
+#include <unistd.h>
+
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <climits>
 #include <cstring>
 #include <filesystem>
-#include <iostream>
 #include <map>
-#include <regex>
 #include <stdexcept>
+#include <unordered_set>
 #include <utility>
 
 #include "encode/char_decoder.h"
@@ -25,15 +31,27 @@
 #include "include/adler32.h"
 #include "include/binutils.h"
 #include "include/mdict_extern.h"
+#include "include/lzo_wrapper.h"
 #include "include/xmlutils.h"
 #include "include/zlib_wrapper.h"
 
-const std::regex re_pattern("(\\s|:|\\.|,|-|_|'|\\(|\\)|#|<|>|!)");
-
 namespace mdict {
 
+namespace {
+
+// block cache keys, never reused within the process
+uint64_t next_cache_id() {
+  static std::atomic<uint64_t> next{1};
+  return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace
+
 // constructor
-Mdict::Mdict(std::string fn) noexcept : filename(std::move(fn)) {
+Mdict::Mdict(std::string fn) noexcept
+    : filename(std::move(fn)),
+      cache_id(next_cache_id()),
+      blocks(block_cache::shared()) {
   if (endsWith(filename, ".mdd")) {
     this->filetype = MDDTYPE;
   } else {
@@ -43,18 +61,72 @@ Mdict::Mdict(std::string fn) noexcept : filename(std::move(fn)) {
 
 // distructor
 Mdict::~Mdict() {
+  // the worker decodes through this dictionary, stop it first
+  this->prefetch.reset();
+  this->release_block_cache();
+  this->reset_index();
   // close instream
   instream.close();
 }
 
+void Mdict::reset_index() {
+  for (auto *item : this->key_list) {
+    delete item;
+  }
+  this->key_list.clear();
+  for (auto *info : this->key_block_info_list) {
+    delete info;
+  }
+  this->key_block_info_list.clear();
+  for (auto *r : this->key_data) {
+    delete r;
+  }
+  this->key_data.clear();
+  this->record_comp_offsets.clear();
+  this->record_decomp_offsets.clear();
+  this->record_buckets.clear();
+  this->record_bucket_shift = 0;
+  this->key_hash.clear();
+  this->key_hash_once.reset();
+  this->key_model.reset();
+  this->checkpoints.clear();
+  this->content_hashes.clear();
+  this->hot.reset();
+  this->graph.reset();
+}
+
+/**
+ * byte classes for _s: 0 = drop, otherwise the (lower cased) byte to keep
+ *
+ * drops whitespace and  : . , - _ ' ( ) # < > !  and lower cases ASCII,
+ * equivalent to regex_replace("(\\s|:|\\.|,|-|_|'|\\(|\\)|#|<|>|!)", "")
+ * followed by ::tolower, but without a regex engine on the lookup path
+ */
+static const std::array<unsigned char, 256> normalize_table = [] {
+  std::array<unsigned char, 256> t{};
+  for (int c = 0; c < 256; c++) {
+    t[c] = static_cast<unsigned char>((c >= 'A' && c <= 'Z') ? c + 32 : c);
+  }
+  for (unsigned char c : std::string(" \t\n\v\f\r:.,-_'()#<>!")) {
+    t[c] = 0;
+  }
+  return t;
+}();
+
 /**
  * transform word into comparable string
  * @param word
  * @return
  */
-std::string _s(std::string word) {
-  std::string s = std::regex_replace(word, re_pattern, "");
-  std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+std::string _s(const std::string &word) {
+  std::string s;
+  s.reserve(word.size());
+  for (unsigned char c : word) {
+    unsigned char n = normalize_table[c];
+    if (n != 0 || c == 0) {
+      s.push_back(static_cast<char>(n));
+    }
+  }
   return s;
 }
 
@@ -72,7 +144,10 @@ void Mdict::read_header() {
 
   // header size buffer
   char *head_size_buf = (char *)std::calloc(4, sizeof(char));
-  readfile(0, 4, head_size_buf);
+  if (!readfile(0, 4, head_size_buf)) {
+    std::free(head_size_buf);
+    throw mdict_error(MDICT_ERR_IO, "short read of header size");
+  }
 
   // header byte size convert
   uint32_t header_bytes_size =
@@ -90,7 +165,10 @@ void Mdict::read_header() {
   // header buffer
   unsigned char *head_buffer =
       (unsigned char *)std::calloc(header_bytes_size, sizeof(unsigned char));
-  readfile(4, header_bytes_size, (char *)head_buffer);
+  if (!readfile(4, header_bytes_size, (char *)head_buffer)) {
+    std::free(head_buffer);
+    throw mdict_error(MDICT_ERR_IO, "short read of header");
+  }
   /// passed
 
   // 3. alder32 checksum
@@ -99,7 +177,11 @@ void Mdict::read_header() {
   // TODO  version < 2.0 needs to checksum?
   // alder32 checksum buffer
   char *head_checksum_buffer = (char *)std::calloc(4, sizeof(char));
-  readfile(header_bytes_size + 4, 4, head_checksum_buffer);
+  if (!readfile(header_bytes_size + 4, 4, head_checksum_buffer)) {
+    std::free(head_checksum_buffer);
+    std::free(head_buffer);
+    throw mdict_error(MDICT_ERR_IO, "short read of header checksum");
+  }
   /// passed
 
   // TODO skip head checksum for now
@@ -113,7 +195,8 @@ void Mdict::read_header() {
 
   std::string utf8_temp;
   if (!utf16_to_utf8_header(head_buffer, header_bytes_size, utf8_temp)) {
-    std::cout << "this mdx file is invalid len:" << header_bytes_size << std::endl;
+    MDICT_LOG(log(), MDICT_LOG_ERROR,
+              "invalid dictionary header, len: " << header_bytes_size);
     return;
   }
 
@@ -264,19 +347,22 @@ void Mdict::read_key_block_header() {
   char *key_block_info_buffer = (char *)calloc(
       static_cast<size_t>(key_block_info_bytes_num), sizeof(char));
   // read buffer
-  this->readfile(this->key_block_start_offset,
-                 static_cast<uint64_t>(key_block_info_bytes_num),
-                 key_block_info_buffer);
+  if (!this->readfile(this->key_block_start_offset,
+                      static_cast<uint64_t>(key_block_info_bytes_num),
+                      key_block_info_buffer)) {
+    std::free(key_block_info_buffer);
+    throw mdict_error(MDICT_ERR_IO, "short read of key block header");
+  }
   //  putbytes(key_block_info_buffer,key_block_info_bytes_num, true);
   /// PASSED
 
   // TODO key block info encrypted file not support yet
   if (this->encrypt == ENCRYPT_RECORD_ENC) {
-    std::cout << "user identification is needed to read encrypted file"
-              << std::endl;
+    MDICT_LOG(log(), MDICT_LOG_ERROR,
+              "user identification is needed to read encrypted file");
     if (key_block_info_buffer)
       std::free(key_block_info_buffer);
-    throw std::invalid_argument("invalid encrypted file");
+    throw mdict_error(MDICT_ERR_UNSUPPORTED, "invalid encrypted file");
   }
 
   // key block header info struct:
@@ -300,8 +386,8 @@ void Mdict::read_key_block_header() {
       std::free(key_block_info_buffer);
     if (key_block_nums_bytes)
       std::free(key_block_nums_bytes);
-    std::cout << "eno: " << eno << std::endl;
-    throw std::logic_error("get key block bin slice failed");
+    throw mdict_error(MDICT_ERR_CORRUPT, "get key block bin slice failed, eno: " +
+                                             std::to_string(eno));
   }
   /// passed
 
@@ -332,7 +418,7 @@ void Mdict::read_key_block_header() {
   if (this->number_width == 8)
     entries_num = be_bin_to_u64((const unsigned char *)entries_num_bytes);
   else if (this->number_width == 4)
-    key_block_num = be_bin_to_u32((const unsigned char *)entries_num_bytes);
+    entries_num = be_bin_to_u32((const unsigned char *)entries_num_bytes);
   if (entries_num_bytes)
     std::free(entries_num_bytes);
   /// passed
@@ -460,8 +546,11 @@ void Mdict::read_key_block_info() {
   char *key_block_info_buffer = (char *)calloc(
       static_cast<size_t>(this->key_block_info_size), sizeof(char));
 
-  readfile(this->key_block_info_start_offset, this->key_block_info_size,
-           key_block_info_buffer);
+  if (!readfile(this->key_block_info_start_offset, this->key_block_info_size,
+                key_block_info_buffer)) {
+    std::free(key_block_info_buffer);
+    throw mdict_error(MDICT_ERR_IO, "short read of key block info");
+  }
 
   // ------------------------------------
   // decode key_block_info
@@ -471,33 +560,18 @@ void Mdict::read_key_block_info() {
 
   // key block compressed start offset = this->key_block_info_start_offset +
   // key_block_info_size
-  this->key_block_compressed_start_offset = static_cast<uint32_t>(
-      this->key_block_info_start_offset + this->key_block_info_size);
-
-  /// passed
-
-  char *key_block_compressed_buffer =
-      (char *)calloc(static_cast<size_t>(this->key_block_size), sizeof(char));
+  this->key_block_compressed_start_offset =
+      this->key_block_info_start_offset + this->key_block_info_size;
 
-  readfile(this->key_block_compressed_start_offset,
-           static_cast<int>(this->key_block_size), key_block_compressed_buffer);
+  std::free(key_block_info_buffer);
 
   // ------------------------------------
-  // decode key_block_compressed
+  // decode key_block_compressed, streamed
   // ------------------------------------
-  unsigned long kb_len = this->key_block_size;
-  //  putbytes(key_block_compressed_buffer,this->key_block_size, true);
-
-  int err =
-      decode_key_block((unsigned char *)key_block_compressed_buffer, kb_len);
+  int err = decode_key_block();
   if (err != 0) {
     throw std::runtime_error("decode key block error");
   }
-
-  if (key_block_info_buffer != nullptr)
-    std::free(key_block_info_buffer);
-  if (key_block_compressed_buffer != nullptr)
-    std::free(key_block_compressed_buffer);
 }
 
 /**
@@ -507,13 +581,14 @@ void Mdict::read_key_block_info() {
  * @param data_len data length
  * @param key_len key length
  */
-void fast_decrypt(byte *data, const byte *k, int data_len, int key_len) {
+void fast_decrypt(byte *data, const byte *k, uint64_t data_len,
+                  size_t key_len) {
   const byte *key = k;
   //      putbytes((char*)data, 16, true);
   byte *b = data;
   byte previous = 0x36;
 
-  for (int i = 0; i < data_len; ++i) {
+  for (uint64_t i = 0; i < data_len; ++i) {
     byte t = static_cast<byte>(((b[i] >> 4) | (b[i] << 4)) & 0xff);
     t = t ^ previous ^ ((byte)(i & 0xff)) ^ key[i % key_len];
     previous = b[i];
@@ -530,7 +605,11 @@ void fast_decrypt(byte *data, const byte *k, int data_len, int key_len) {
  * @param comp_block_len compressed block buffer size
  * @return the decrypted compressed block
  */
-byte *mdx_decrypt(byte *comp_block, const int comp_block_len) {
+byte *mdx_decrypt(byte *comp_block, const uint64_t comp_block_len) {
+  if (comp_block_len <= 8) {
+    // nothing but the header, which is not encrypted
+    return comp_block;
+  }
   byte *key_buffer = (byte *)calloc(8, sizeof(byte));
   memcpy(key_buffer, comp_block + 4 * sizeof(char), 4 * sizeof(char));
   key_buffer[4] = 0x95; // comp_block[4:8] + [0x95,0x36,0x00,0x00]
@@ -555,20 +634,20 @@ byte *mdx_decrypt(byte *comp_block, const int comp_block_len) {
  * @param key_block key block buffer
  * @param key_block_len key block length
  */
-std::vector<key_list_item *> Mdict::split_key_block(unsigned char *key_block,
-                                                    unsigned long key_block_len,
+std::vector<key_list_item *> Mdict::split_key_block(const unsigned char *key_block,
+                                                    uint64_t key_block_len,
                                                     unsigned long block_id) {
   // TODO assert checksum
   // uint32_t adlchk = adler32checksum(key_block, key_block_len);
   //  std::cout<<"adler32 chksum: "<<adlchk<<std::endl;
-  int key_start_idx = 0;
-  int key_end_idx = 0;
+  uint64_t key_start_idx = 0;
+  uint64_t key_end_idx = 0;
   std::vector<key_list_item *> inner_key_list;
 
   while (key_start_idx < key_block_len) {
     // # the corresponding record's offset in record block
-    unsigned long record_start = 0;
-    int width = 0;
+    uint64_t record_start = 0;
+    uint64_t width = 0;
     if (this->version >= 2.0) {
       record_start = be_bin_to_u64(key_block + key_start_idx);
     } else {
@@ -584,13 +663,17 @@ std::vector<key_list_item *> Mdict::split_key_block(unsigned char *key_block,
     // key text ends with '\x00'
     // version >= 2.0 delimiter == '0x0000'
     // else delimiter == '0x00'  (< 2.0)
-    int i = key_start_idx + number_width; // ver > 2.0, move 8, else move 4
+    // ver > 2.0, move 8, else move 4
+    uint64_t i = key_start_idx + number_width;
     if (i >= key_block_len) {
-      throw std::runtime_error("key start idx > key block length");
+      throw mdict_error(MDICT_ERR_CORRUPT, "key start idx > key block length");
     }
-    while (static_cast<size_t>(i) < key_block_len) {
+    // a key without delimiter runs to the end of the block
+    key_end_idx = key_block_len;
+    while (i < key_block_len) {
       if (encoding == 1 /*ENCODING_UTF16*/) {
-        if ((key_block[i] & 0x0f) == 0 &&        /* delimiter = '0000' */
+        if (i + 1 < key_block_len &&
+            (key_block[i] & 0x0f) == 0 &&        /* delimiter = '0000' */
             ((key_block[i] & 0xf0) >> 4) == 0 && /* delimiter = '0000' */
             ((key_block[i + 1] & 0x0f) == 0) &&
             (((key_block[i + 1] & 0xf0) >> 4) == 0)) {
@@ -613,8 +696,8 @@ std::vector<key_list_item *> Mdict::split_key_block(unsigned char *key_block,
     }
     /// passed
 
-    if (static_cast<size_t>(key_end_idx) >= key_block_len) {
-      key_end_idx = static_cast<int>(key_block_len);
+    if (key_end_idx >= key_block_len) {
+      key_end_idx = key_block_len;
     }
 
     std::string key_text = "";
@@ -629,7 +712,8 @@ std::vector<key_list_item *> Mdict::split_key_block(unsigned char *key_block,
           1; // Add 1 just in case (though hex_to_bytes checks evenness)
       unsigned char *utf16le_bytes = (unsigned char *)malloc(utf16le_buf_size);
       if (!utf16le_bytes) {
-        perror("Error allocating memory for UTF-16LE buffer");
+        MDICT_LOG(log(), MDICT_LOG_ERROR,
+                  "error allocating memory for UTF-16LE buffer");
         throw std::runtime_error("Error allocating memory for UTF-16LE buffer");
       }
 
@@ -637,7 +721,7 @@ std::vector<key_list_item *> Mdict::split_key_block(unsigned char *key_block,
           hex_to_bytes(hex_input.c_str(), utf16le_bytes, utf16le_buf_size);
       if (utf16_bytes_written < 0) {
         free(utf16le_bytes);
-        throw std::runtime_error("hex_to_bytes failed");
+        throw mdict_error(MDICT_ERR_CORRUPT, "hex_to_bytes failed");
       }
 
       // UTF-16LE Bytes to UTF-8
@@ -650,7 +734,8 @@ std::vector<key_list_item *> Mdict::split_key_block(unsigned char *key_block,
       size_t utf8_buf_size = ((size_t)utf16_bytes_written * 3) + 1;
       unsigned char *utf8_output = (unsigned char *)malloc(utf8_buf_size);
       if (!utf8_output) {
-        perror("Error allocating memory for UTF-8 output buffer");
+        MDICT_LOG(log(), MDICT_LOG_ERROR,
+                  "error allocating memory for UTF-8 output buffer");
         free(utf16le_bytes);
         throw std::runtime_error(
             "Error allocating memory for UTF-8 output buffer");
@@ -663,7 +748,7 @@ std::vector<key_list_item *> Mdict::split_key_block(unsigned char *key_block,
       if (utf8_bytes_written < 0) {
         free(utf16le_bytes);
         free(utf8_output);
-        throw std::runtime_error("utf16le_to_utf8 failed");
+        throw mdict_error(MDICT_ERR_CORRUPT, "utf16le_to_utf8 failed");
       }
 
       key_text = std::string(reinterpret_cast<char *>(utf8_output),
@@ -685,140 +770,180 @@ std::vector<key_list_item *> Mdict::split_key_block(unsigned char *key_block,
 }
 
 /**
- * decode key block info by block id use with reduce function
- * @param block_id key_block id
- * @return return key list item
+ * decompress a key or record block: 4 bytes compression type (0 stored,
+ * 1 lzo, 2 zlib), 4 bytes adler32 of the decompressed data, the data
+ * @param data the block as stored in the file
+ * @param comp_size size of the stored block, header included
+ * @param decomp_size size of the decompressed block
+ * @param out receives the decompressed block if MDICT_OK is returned
+ * @return MDICT_OK, MDICT_ERR_DECOMPRESS or MDICT_ERR_CORRUPT
  */
-std::vector<key_list_item *>
-Mdict::decode_key_block_by_block_id(unsigned long block_id) {
-  // ------------------------------------
-  // decode key_block_compressed
-  // ------------------------------------
+static mdict_error_t decode_block(const char *data, uint64_t comp_size,
+                                  uint64_t decomp_size,
+                                  std::shared_ptr<std::vector<uint8_t>> &out) {
+  if (comp_size < 8) {
+    return MDICT_ERR_CORRUPT;
+  }
+  int comp_type = data[0] & 0xff;
+  uint32_t checksum = be_bin_to_u32((const unsigned char *)data + 4);
+  const char *body = data + 8;
+  uint64_t body_size = comp_size - 8;
+
+  std::shared_ptr<std::vector<uint8_t>> block;
+  if (comp_type == 0) {
+    // stored
+    if (body_size < decomp_size) {
+      return MDICT_ERR_CORRUPT;
+    }
+    block = std::make_shared<std::vector<uint8_t>>(body, body + decomp_size);
+  } else if (comp_type == 1) {
+    // lzo, version 1.x dictionaries
+    block = std::make_shared<std::vector<uint8_t>>(decomp_size);
+    if (!lzo_mem_uncompress(block->data(), decomp_size, body, body_size)) {
+      return MDICT_ERR_DECOMPRESS;
+    }
+  } else if (comp_type == 2) {
+    block = std::make_shared<std::vector<uint8_t>>(
+        zlib_mem_uncompress(body, body_size, decomp_size));
+    if (block->size() != decomp_size) {
+      return MDICT_ERR_DECOMPRESS;
+    }
+  } else {
+    return MDICT_ERR_CORRUPT;
+  }
+
+  if (adler32checksum(block->data(), block->size()) != checksum) {
+    return MDICT_ERR_CORRUPT;
+  }
+  out = std::move(block);
+  return MDICT_OK;
+}
+
+/**
+ * decode_block() for the indexing paths, which report errors by exception
+ * @param what "key" or "record", for the error message
+ */
+static std::shared_ptr<std::vector<uint8_t>> decode_block_or_throw(
+    const char *data, uint64_t comp_size, uint64_t decomp_size,
+    const std::string &what) {
+  std::shared_ptr<std::vector<uint8_t>> block;
+  mdict_error_t err = decode_block(data, comp_size, decomp_size, block);
+  if (err != MDICT_OK) {
+    throw mdict_error(err, what + " block: " + mdict_strerror(err));
+  }
+  return block;
+}
 
-  unsigned long idx = block_id;
+/**
+ * read and decompress one key block, through the block cache
+ * @param block_id key_block id
+ * @param hint MDICT_ACCESS_SCAN neither admits nor promotes the block
+ * @return the decompressed key block
+ */
+block_ptr Mdict::load_key_block(unsigned long block_id, mdict_access_t hint) {
+  bool scan = this->is_scan(hint);
+  if (this->prefetch && !scan) {
+    this->note_block_access(KEY_BLOCK, block_id);
+  }
+  block_key bk{this->cache_id, KEY_BLOCK, block_id};
+  if (this->blocks) {
+    if (block_ptr cached = this->blocks->get(bk, scan)) {
+      return cached;
+    }
+  }
 
-  unsigned long comp_size = this->key_block_info_list[idx]->key_block_comp_size;
-  unsigned long decomp_size =
-      this->key_block_info_list[idx]->key_block_decomp_size;
-  unsigned long start_ofset =
-      this->key_block_info_list[idx]->key_block_comp_accumulator +
+  uint64_t comp_size =
+      this->key_block_info_list[block_id]->key_block_comp_size;
+  uint64_t decomp_size =
+      this->key_block_info_list[block_id]->key_block_decomp_size;
+  uint64_t start_ofset =
+      this->key_block_info_list[block_id]->key_block_comp_accumulator +
       this->key_block_compressed_start_offset;
 
-  char *key_block_buffer =
-      (char *)calloc(static_cast<size_t>(comp_size), sizeof(unsigned char));
-
-  readfile(start_ofset, static_cast<int>(comp_size), key_block_buffer);
-
-  // 4 bytes comp type
-  char *key_block_comp_type = (char *)calloc(4, sizeof(char));
-  memcpy(key_block_comp_type, key_block_buffer, 4 * sizeof(char));
-  // 4 bytes adler checksum of decompressed key block
-  uint32_t chksum =
-      be_bin_to_u32((unsigned char *)key_block_buffer + 4 * sizeof(char));
-
-  unsigned char *key_block = nullptr;
-  std::vector<uint8_t> kb_uncompressed; // note: ensure kb_uncompressed not
-                                        // die when out of uncompress scope
-
-  if ((key_block_comp_type[0] & 255) == 0) {
-    // none compressed
-    key_block = (unsigned char *)(key_block_buffer + 8 * sizeof(char));
-  } else if ((key_block_comp_type[0] & 255) == 1) {
-    // 01000000
-    // TODO lzo decompress
-
-  } else if ((key_block_comp_type[0] & 255) == 2) {
-    // zlib compress
-    kb_uncompressed =
-        zlib_mem_uncompress(key_block_buffer + 8 * sizeof(char), comp_size);
-    if (kb_uncompressed.empty()) {
-      throw std::runtime_error("key block decompress failed empty");
-    }
-    key_block = kb_uncompressed.data();
-
-    uint32_t adler32cs =
-        adler32checksum(key_block, static_cast<uint32_t>(decomp_size));
-    assert(adler32cs == chksum);
-    assert(kb_uncompressed.size() == decomp_size);
-  } else {
-    throw std::runtime_error("cannot determine the key block compress type");
+  std::vector<char> key_block_buffer(comp_size);
+  if (!readfile(start_ofset, comp_size, key_block_buffer.data())) {
+    throw mdict_error(MDICT_ERR_IO, "short read of key block");
+  }
+  block_ptr key_block = decode_block_or_throw(key_block_buffer.data(),
+                                              comp_size, decomp_size, "key");
+
+  if (this->blocks) {
+    this->blocks->put(bk, key_block, scan);
   }
+  return key_block;
+}
 
+/**
+ * decode key block info by block id use with reduce function
+ * @param block_id key_block id
+ * @param hint access hint, see load_key_block
+ * @return return key list item, owned by the caller
+ */
+std::vector<key_list_item *>
+Mdict::decode_key_block_by_block_id(unsigned long block_id,
+                                    mdict_access_t hint) {
+  block_ptr key_block = this->load_key_block(block_id, hint);
   // split key
-  std::vector<key_list_item *> tlist =
-      split_key_block(key_block, decomp_size, idx);
-  return tlist;
+  return split_key_block(key_block->data(), key_block->size(), block_id);
 }
 
 /**
  * decode the key block decode function, will invoke split key block
  *
- * this is for key block (not key block info)
+ * this is for key block (not key block info). the key section is read a
+ * window at a time, so init() never holds all of it
  *
- * @param key_block_buffer
- * @param kb_buff_len
  * @return
  */
-int Mdict::decode_key_block(unsigned char *key_block_buffer,
-                            unsigned long kb_buff_len) {
-  int i = 0;
-
-  for (long idx = 0; idx < static_cast<long>(this->key_block_info_list.size()); idx++) {
-    unsigned long comp_size =
-        this->key_block_info_list[idx]->key_block_comp_size;
-    unsigned long decomp_size =
-        this->key_block_info_list[idx]->key_block_decomp_size;
-    unsigned long start_ofset = i;
-    // unsigned long end_ofset = i + comp_size;
-    // 4 bytes comp type
-    char *key_block_comp_type = (char *)calloc(4, sizeof(char));
-    memcpy(key_block_comp_type, key_block_buffer, 4 * sizeof(char));
-    // 4 bytes adler checksum of decompressed key block
-    // TODO  adler32 = unpack('>I', key_block_compressed[start + 4:start +
-    // 8])[0]
-    uint32_t chksum =
-        be_bin_to_u32(key_block_buffer + start_ofset + 4 * sizeof(char));
-
-    unsigned char *key_block = nullptr;
-
-    std::vector<uint8_t> kb_uncompressed; // note: ensure kb_uncompressed not
-                                          // die when out of uncompress scope
-
-    if ((key_block_comp_type[0] & 255) == 0) {
-      // none compressed
-      key_block = key_block_buffer + 8 * sizeof(char);
-    } else if ((key_block_comp_type[0] & 255) == 1) {
-      // 01000000
-      // TODO lzo decompress
-
-    } else if ((key_block_comp_type[0] & 255) == 2) {
-      // zlib compress
-      kb_uncompressed =
-          zlib_mem_uncompress(key_block_buffer + start_ofset + 8, comp_size);
-      if (kb_uncompressed.empty() || kb_uncompressed.size() == 0) {
-        throw std::runtime_error("key block decompress failed");
-      }
-      key_block = kb_uncompressed.data();
-
-      uint32_t adler32cs =
-          adler32checksum(key_block, static_cast<uint32_t>(decomp_size));
-      assert(adler32cs == chksum);
-      assert(kb_uncompressed.size() == decomp_size);
-    } else {
-      throw std::runtime_error("cannot determine the key block compress type");
+int Mdict::decode_key_block() {
+  size_t blocks = this->key_block_info_list.size();
+  std::vector<char> window;
+  // offset of the current block in the key section
+  uint64_t pos = 0;
+  size_t idx = 0;
+  while (idx < blocks) {
+    // as many whole blocks as fit in the window, at least one
+    size_t last = idx;
+    uint64_t span = this->key_block_info_list[idx]->key_block_comp_size;
+    while (last + 1 < blocks &&
+           span + this->key_block_info_list[last + 1]->key_block_comp_size <=
+               this->index_window_bytes) {
+      last++;
+      span += this->key_block_info_list[last]->key_block_comp_size;
+    }
+    if (pos + span > this->key_block_size) {
+      throw mdict_error(MDICT_ERR_CORRUPT, "key block past the key section");
+    }
+    window.resize(span);
+    if (!this->readfile(this->key_block_compressed_start_offset + pos, span,
+                        window.data())) {
+      throw mdict_error(MDICT_ERR_IO, "short read of key blocks");
     }
 
-    // split key
-    std::vector<key_list_item *> tlist =
-        split_key_block(key_block, decomp_size, idx);
-    key_list.insert(key_list.end(), tlist.begin(), tlist.end());
-
-    // TODO HERE append keys
-
-    // next round
-    i += comp_size;
+    uint64_t i = 0;
+    for (; idx <= last; idx++) {
+      uint64_t comp_size = this->key_block_info_list[idx]->key_block_comp_size;
+      uint64_t decomp_size =
+          this->key_block_info_list[idx]->key_block_decomp_size;
+      auto kb_uncompressed = decode_block_or_throw(window.data() + i, comp_size,
+                                                   decomp_size, "key");
+
+      // split key
+      std::vector<key_list_item *> tlist = split_key_block(
+          kb_uncompressed->data(), kb_uncompressed->size(), idx);
+      this->key_block_info_list[idx]->key_list_offset = key_list.size();
+      this->key_block_info_list[idx]->key_list_entries = tlist.size();
+      key_list.insert(key_list.end(), tlist.begin(), tlist.end());
+      i += comp_size;
+    }
+    pos += span;
+  }
+  if (key_list.size() != this->entries_num) {
+    throw mdict_error(MDICT_ERR_CORRUPT,
+                      "key blocks hold " + std::to_string(key_list.size()) +
+                          " entries, the header says " +
+                          std::to_string(this->entries_num));
   }
-  assert(key_list.size() == this->entries_num);
   /// passed
 
   this->record_block_info_offset = this->key_block_info_start_offset +
@@ -855,21 +980,33 @@ int Mdict::read_record_block_header() {
   char *record_info_buffer =
       (char *)calloc(record_block_info_size, sizeof(char));
 
-  this->readfile(record_block_info_offset, record_block_info_size,
-                 record_info_buffer);
-
-  if (this->version >= 2.0) {
-    record_block_number = be_bin_to_u64((unsigned char *)record_info_buffer);
-    record_block_entries_number = be_bin_to_u64(
-        (unsigned char *)record_info_buffer + number_width * sizeof(char));
-    record_block_header_size = be_bin_to_u64(
-        (unsigned char *)record_info_buffer + 2 * number_width * sizeof(char));
-    record_block_size = be_bin_to_u64((unsigned char *)record_info_buffer +
-                                      3 * number_width * sizeof(char));
+  if (!this->readfile(record_block_info_offset, record_block_info_size,
+                      record_info_buffer)) {
+    std::free(record_info_buffer);
+    throw mdict_error(MDICT_ERR_IO, "short read of record block info");
   }
 
+  // 8 byte numbers from version 2.0 on, 4 byte numbers before
+  auto number = [this](const char *p) -> uint64_t {
+    return this->number_width == 8 ? be_bin_to_u64((const unsigned char *)p)
+                                   : be_bin_to_u32((const unsigned char *)p);
+  };
+  record_block_number = number(record_info_buffer);
+  record_block_entries_number = number(record_info_buffer + number_width);
+  record_block_header_size = number(record_info_buffer + 2 * number_width);
+  record_block_size = number(record_info_buffer + 3 * number_width);
+
   free(record_info_buffer);
-  assert(record_block_entries_number == entries_num);
+  if (record_block_entries_number != entries_num) {
+    throw mdict_error(MDICT_ERR_CORRUPT,
+                      "record blocks hold " +
+                          std::to_string(record_block_entries_number) +
+                          " entries, the header says " +
+                          std::to_string(entries_num));
+  }
+  if (record_block_header_size < record_block_number * 2 * number_width) {
+    throw mdict_error(MDICT_ERR_CORRUPT, "record block header truncated");
+  }
   /// passed
 
   /**
@@ -883,38 +1020,43 @@ int Mdict::read_record_block_header() {
   char *record_header_buffer =
       (char *)calloc(record_block_header_size, sizeof(char));
 
-  this->readfile(this->record_block_info_offset + record_block_info_size,
-                 record_block_header_size, record_header_buffer);
+  if (!this->readfile(this->record_block_info_offset + record_block_info_size,
+                      record_block_header_size, record_header_buffer)) {
+    std::free(record_header_buffer);
+    throw mdict_error(MDICT_ERR_IO, "short read of record block index");
+  }
+
+  uint64_t comp_size = 0;
+  uint64_t uncomp_size = 0;
+  uint64_t size_counter = 0;
 
-  unsigned long comp_size = 0l;
-  unsigned long uncomp_size = 0l;
-  unsigned long size_counter = 0l;
+  uint64_t comp_accu = 0;
+  uint64_t decomp_accu = 0;
 
-  unsigned long comp_accu = 0l;
-  unsigned long decomp_accu = 0l;
+  this->record_comp_offsets.assign(1, 0);
+  this->record_decomp_offsets.assign(1, 0);
+  this->record_comp_offsets.reserve(record_block_number + 1);
+  this->record_decomp_offsets.reserve(record_block_number + 1);
 
   for (unsigned long i = 0; i < record_block_number; ++i) {
-    if (this->version >= 2.0) {
-      comp_size =
-          be_bin_to_u64((unsigned char *)(record_header_buffer + size_counter));
-      size_counter += number_width;
-      uncomp_size =
-          be_bin_to_u64((unsigned char *)(record_header_buffer + size_counter));
-      size_counter += number_width;
-
-      this->record_header.push_back(new record_header_item(
-          i, comp_size, uncomp_size, comp_accu, decomp_accu));
-      // ensure after push
-      comp_accu += comp_size;
-      decomp_accu += uncomp_size;
-    } else {
-      // TODO
-    }
+    comp_size = number(record_header_buffer + size_counter);
+    size_counter += number_width;
+    uncomp_size = number(record_header_buffer + size_counter);
+    size_counter += number_width;
+
+    comp_accu += comp_size;
+    decomp_accu += uncomp_size;
+    this->record_comp_offsets.push_back(comp_accu);
+    this->record_decomp_offsets.push_back(decomp_accu);
   }
 
   free(record_header_buffer);
-  assert(this->record_header.size() == this->record_block_number);
-  assert(size_counter == this->record_block_header_size);
+  if (this->record_comp_offsets.size() != this->record_block_number + 1 ||
+      size_counter != this->record_block_header_size) {
+    throw mdict_error(MDICT_ERR_CORRUPT, "record block header size mismatch");
+  }
+
+  this->build_record_buckets();
 
   record_block_offset = record_block_info_offset + record_block_info_size +
                         record_block_header_size;
@@ -922,81 +1064,225 @@ int Mdict::read_record_block_header() {
   return 0;
 }
 
-std::vector<std::pair<std::string, std::string>>
-Mdict::decode_record_block_by_rid(unsigned long rid /* record id */) {
-  // record block start offset: record_block_offset
-  uint64_t record_offset = this->record_block_offset;
+/**
+ * read, decrypt and decompress one record block, through the block cache
+ * @param rid record block id
+ * @param hint MDICT_ACCESS_SCAN neither admits nor promotes the block
+ * @return the decompressed record block
+ */
+block_ptr Mdict::load_record_block(unsigned long rid, mdict_access_t hint) {
+  block_ptr record_block;
+  mdict_error_t err = this->fetch_record_block(rid, hint, record_block);
+  if (err != MDICT_OK) {
+    throw mdict_error(err, "record block " + std::to_string(rid) + ": " +
+                               mdict_strerror(err));
+  }
+  return record_block;
+}
 
-  // key list index counter
-  unsigned long i = 0l;
+mdict_error_t Mdict::fetch_record_block(unsigned long rid, mdict_access_t hint,
+                                        block_ptr &out) {
+  if (rid >= this->record_block_number) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  bool scan = this->is_scan(hint);
+  if (this->prefetch && !scan) {
+    this->note_block_access(RECORD_BLOCK, rid);
+  }
+  block_key bk{this->cache_id, RECORD_BLOCK, rid};
+  if (this->blocks) {
+    if (block_ptr cached = this->blocks->get(bk, scan)) {
+      out = std::move(cached);
+      return MDICT_OK;
+    }
+  }
 
-  std::vector<uint8_t> record_block_uncompressed_v;
-  unsigned char *record_block_uncompressed_b;
-  uint64_t checksum = 0l;
+  uint64_t comp_size = this->record_comp_size(rid);
+  if (comp_size < 8) {
+    return MDICT_ERR_CORRUPT;
+  }
+  std::vector<char> record_block_cmp_buffer(comp_size);
+  if (!this->readfile(this->record_block_offset + this->record_comp_offsets[rid],
+                      comp_size, record_block_cmp_buffer.data())) {
+    return MDICT_ERR_IO;
+  }
+  block_ptr record_block;
+  mdict_error_t err =
+      this->decode_record_data(rid, record_block_cmp_buffer.data(), record_block);
+  if (err != MDICT_OK) {
+    return err;
+  }
 
-  unsigned long idx = rid;
+  if (this->blocks) {
+    this->blocks->put(bk, record_block, scan);
+  }
+  out = std::move(record_block);
+  return MDICT_OK;
+}
 
-  //  for (int idx = 0; idx < this->record_header.size(); idx++) {
-  uint64_t comp_size = record_header[idx]->compressed_size;
-  uint64_t uncomp_size = record_header[idx]->decompressed_size;
-  uint64_t comp_accu = record_header[idx]->compressed_size_accumulator;
-  uint64_t decomp_accu = record_header[idx]->decompressed_size_accumulator;
-  uint64_t previous_end = 0;
-  uint64_t previous_uncomp_size = 0;
-  if (idx > 0) {
-    previous_end = record_header[idx - 1]->decompressed_size_accumulator;
-    previous_uncomp_size = record_header[idx - 1]->decompressed_size;
-  }
-
-  char *record_block_cmp_buffer = (char *)calloc(comp_size, sizeof(char));
-
-  this->readfile(record_offset + comp_accu, comp_size, record_block_cmp_buffer);
-  // 4 bytes, compress type
-  char *comp_type_b = (char *)calloc(4, sizeof(char));
-  memcpy(comp_type_b, record_block_cmp_buffer, 4 * sizeof(char));
-  //    putbytes(comp_type_b, 4, true);
-  int comp_type = comp_type_b[0] & 0xff;
-  // 4 bytes adler32 checksum
-  char *checksum_b = (char *)calloc(4, sizeof(char));
-  memcpy(checksum_b, record_block_cmp_buffer + 4, 4 * sizeof(char));
-  checksum = be_bin_to_u32((unsigned char *)checksum_b);
-  free(checksum_b);
-
-  if (comp_type == 0 /* not compressed TODO*/) {
-    throw std::runtime_error("uncompress block not support yet");
-  } else {
-    char *record_block_decrypted_buff;
-    if (this->encrypt == ENCRYPT_RECORD_ENC /* record block encrypted */) {
-      // TODO
-      throw std::runtime_error("record encrypted not support yet");
-    }
-    record_block_decrypted_buff = record_block_cmp_buffer + 8 * sizeof(char);
-    // decompress
-    if (comp_type == 1 /* lzo */) {
-      throw std::runtime_error("lzo compress not support yet");
-    } else if (comp_type == 2) {
-      // zlib compress
-      record_block_uncompressed_v =
-          zlib_mem_uncompress(record_block_decrypted_buff, comp_size);
-      if (record_block_uncompressed_v.empty()) {
-        throw std::runtime_error("record block decompress failed size == 0");
+/**
+ * decrypt and decompress a record block read from the file
+ * @param rid record block id
+ * @param data the compressed block, record_comp_size(rid) bytes
+ * @param out receives the decompressed record block
+ */
+mdict_error_t Mdict::decode_record_data(unsigned long rid, const char *data,
+                                        block_ptr &out) const {
+  if (this->encrypt == ENCRYPT_RECORD_ENC /* record block encrypted */) {
+    // TODO
+    return MDICT_ERR_UNSUPPORTED;
+  }
+  std::shared_ptr<std::vector<uint8_t>> block;
+  mdict_error_t err = decode_block(data, this->record_comp_size(rid),
+                                   this->record_decomp_size(rid), block);
+  if (err == MDICT_OK) {
+    out = std::move(block);
+  }
+  return err;
+}
+
+/**
+ * load record blocks through the block cache, merging the reads of missing
+ * blocks which are close to each other in the file
+ * @param rids record block ids, in any order, duplicates allowed
+ * @param hint MDICT_ACCESS_SCAN neither admits nor promotes the blocks
+ * @param errs nullptr throws on the first bad block, otherwise errs[i]
+ * receives the error of block rids[i] and out[i] is left empty
+ * @return the decompressed blocks, out[i] is block rids[i]
+ */
+std::vector<block_ptr> Mdict::load_record_blocks(
+    const std::vector<unsigned long> &rids, mdict_access_t hint,
+    std::vector<mdict_error_t> *errs) {
+  bool scan = this->is_scan(hint);
+  std::vector<block_ptr> out(rids.size());
+  if (errs) {
+    errs->assign(rids.size(), MDICT_OK);
+  }
+  // the blocks to read, in file order
+  std::vector<unsigned long> missing;
+  for (size_t i = 0; i < rids.size(); i++) {
+    if (rids[i] >= this->record_block_number) {
+      if (!errs) {
+        throw mdict_error(MDICT_ERR_INVALID_ARGUMENT,
+                          "record block out of range");
+      }
+      (*errs)[i] = MDICT_ERR_INVALID_ARGUMENT;
+      continue;
+    }
+    if (this->blocks) {
+      out[i] = this->blocks->get(
+          block_key{this->cache_id, RECORD_BLOCK, rids[i]}, scan);
+    }
+    if (!out[i]) {
+      missing.push_back(rids[i]);
+    }
+  }
+  std::sort(missing.begin(), missing.end());
+  missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+  std::unordered_map<unsigned long, block_ptr> loaded;
+  std::unordered_map<unsigned long, mdict_error_t> failed;
+  auto fail = [&](unsigned long rid, mdict_error_t err, const char *what) {
+    if (!errs) {
+      throw mdict_error(err, "record block " + std::to_string(rid) + ": " +
+                                 what);
+    }
+    MDICT_LOG(log(), MDICT_LOG_DEBUG,
+              "record block " << rid << ": " << what);
+    failed.emplace(rid, err);
+  };
+  auto decode = [&](unsigned long rid, const char *data) {
+    block_ptr block;
+    mdict_error_t err = this->decode_record_data(rid, data, block);
+    if (err != MDICT_OK) {
+      fail(rid, err, mdict_strerror(err));
+      return;
+    }
+    if (this->blocks) {
+      this->blocks->put(block_key{this->cache_id, RECORD_BLOCK, rid},
+                        block, scan);
+    }
+    loaded.emplace(rid, std::move(block));
+  };
+
+  std::vector<char> buffer;
+  for (size_t first = 0; first < missing.size();) {
+    // extend the read while the next block is close and the read stays small
+    uint64_t begin = this->record_comp_offsets[missing[first]];
+    size_t last = first;
+    while (last + 1 < missing.size()) {
+      uint64_t gap = this->record_comp_offsets[missing[last + 1]] -
+                     this->record_comp_offsets[missing[last] + 1];
+      uint64_t span = this->record_comp_offsets[missing[last + 1] + 1] - begin;
+      if (gap > this->coalesce_gap_bytes || span > this->coalesce_read_bytes) {
+        break;
+      }
+      last++;
+    }
+    uint64_t span = this->record_comp_offsets[missing[last] + 1] - begin;
+    buffer.resize(span);
+    if (this->readfile(this->record_block_offset + begin, span, buffer.data())) {
+      for (size_t j = first; j <= last; j++) {
+        unsigned long rid = missing[j];
+        decode(rid, buffer.data() + (this->record_comp_offsets[rid] - begin));
       }
-      record_block_uncompressed_b = record_block_uncompressed_v.data();
-      uint32_t adler32cs = adler32checksum(record_block_uncompressed_b,
-                                           static_cast<uint32_t>(uncomp_size));
-      assert(record_block_uncompressed_v.size() == uncomp_size);
-      assert(adler32cs == checksum);
+    } else if (first == last) {
+      fail(missing[first], MDICT_ERR_IO, "short read");
+    } else {
+      if (!errs) {
+        throw mdict_error(MDICT_ERR_IO, "short read of record blocks");
+      }
+      // read the blocks of the failed run one by one, so only the blocks
+      // which cannot be read fail
+      for (size_t j = first; j <= last; j++) {
+        unsigned long rid = missing[j];
+        uint64_t size = this->record_comp_size(rid);
+        buffer.resize(size);
+        if (this->readfile(this->record_block_offset +
+                               this->record_comp_offsets[rid],
+                           size, buffer.data())) {
+          decode(rid, buffer.data());
+        } else {
+          fail(rid, MDICT_ERR_IO, "short read");
+        }
+      }
+    }
+    first = last + 1;
+  }
+
+  for (size_t i = 0; i < rids.size(); i++) {
+    if (out[i] || (errs && (*errs)[i] != MDICT_OK)) {
+      continue;
+    }
+    auto it = loaded.find(rids[i]);
+    if (it != loaded.end()) {
+      out[i] = it->second;
     } else {
-      throw std::runtime_error(
-          "cannot determine the record block compress type");
+      (*errs)[i] = failed.at(rids[i]);
     }
   }
+  return out;
+}
+
+std::vector<std::pair<std::string, std::string>>
+Mdict::decode_record_block_by_rid(unsigned long rid /* record id */,
+                                  mdict_access_t hint) {
+  unsigned long idx = rid;
 
-  free(comp_type_b);
-  free(record_block_cmp_buffer);
-  //    free(record_block_uncompressed_b); /* ensure not free twice*/
+  uint64_t uncomp_size = this->record_decomp_size(idx);
+  uint64_t decomp_accu = this->record_decomp_offsets[idx];
 
-  unsigned char *record_block = record_block_uncompressed_b;
+  // key list index counter, keys are ordered by record start, start at the
+  // first key of this block
+  unsigned long i =
+      std::partition_point(this->key_list.begin(), this->key_list.end(),
+                           [&](const key_list_item *item) {
+                             return item->record_start < decomp_accu;
+                           }) -
+      this->key_list.begin();
+
+  // keeps the block alive even if the cache evicts it meanwhile
+  block_ptr block = this->load_record_block(idx, hint);
   /**
    * 请注意，block 是会有很多个的，而每个block都可能会被压缩
    * 而 key_list中的 record_start,
@@ -1024,7 +1310,6 @@ Mdict::decode_record_block_by_rid(unsigned long rid /* record id */) {
       break;
     }
 
-    unsigned long upbound = uncomp_size; // - this->key_list[i]->record_start;
     unsigned long expect_end = 0;
     auto expect_start = this->key_list[i]->record_start - decomp_accu;
     if (i < this->key_list.size() - 1) {
@@ -1033,19 +1318,14 @@ Mdict::decode_record_block_by_rid(unsigned long rid /* record id */) {
       expect_start = this->key_list[i]->record_start - decomp_accu;
     } else {
       // 前一个的 end + size 等于当前这个的开始
-      expect_end =
-          this->record_block_size - (previous_end + previous_uncomp_size);
+      expect_end = this->record_block_size - decomp_accu;
     }
+    // the last record of a block ends with the block
+    unsigned long upbound = uncomp_size - expect_start;
     upbound = expect_end < upbound ? expect_end : upbound;
 
-    std::string def;
-    if (this->filetype == "MDD") {
-      def = be_bin_to_utf16((char *)record_block, expect_start,
-                            upbound /* to delete null character*/);
-    } else {
-      def = be_bin_to_utf8((char *)record_block, expect_start,
-                           upbound /* to delete null character*/);
-    }
+    std::string def =
+        this->definition_text(block, expect_start, expect_start + upbound);
     std::pair<std::string, std::string> vp(key_text, def);
     vec.push_back(vp);
     i++;
@@ -1067,16 +1347,19 @@ int Mdict::decode_record_block() {
   unsigned long i = 0l;
 
   // record offset
-  unsigned long offset = 0l;
+  uint64_t offset = 0;
 
   std::vector<uint8_t> record_block_uncompressed_v;
   unsigned char *record_block_uncompressed_b;
   uint64_t checksum = 0l;
-  for (int idx = 0; idx < static_cast<int>(this->record_header.size()); idx++) {
-    uint64_t comp_size = record_header[idx]->compressed_size;
-    uint64_t uncomp_size = record_header[idx]->decompressed_size;
+  for (unsigned long idx = 0; idx < this->record_block_number; idx++) {
+    uint64_t comp_size = this->record_comp_size(idx);
+    uint64_t uncomp_size = this->record_decomp_size(idx);
     char *record_block_cmp_buffer = (char *)calloc(comp_size, sizeof(char));
-    this->readfile(record_offset, comp_size, record_block_cmp_buffer);
+    if (!this->readfile(record_offset, comp_size, record_block_cmp_buffer)) {
+      std::free(record_block_cmp_buffer);
+      throw mdict_error(MDICT_ERR_IO, "short read of record block");
+    }
     //    putbytes(record_block_cmp_buffer, 8, true);
     // 4 bytes, compress type
     char *comp_type_b = (char *)calloc(4, sizeof(char));
@@ -1090,32 +1373,37 @@ int Mdict::decode_record_block() {
     free(checksum_b);
 
     if (comp_type == 0 /* not compressed TODO*/) {
-      throw std::runtime_error("uncompress block not support yet");
+      throw mdict_error(MDICT_ERR_UNSUPPORTED, "uncompress block not support yet");
     } else {
       char *record_block_decrypted_buff;
       if (this->encrypt == ENCRYPT_RECORD_ENC /* record block encrypted */) {
         // TODO
-        throw std::runtime_error("record encrypted not support yet");
+        throw mdict_error(MDICT_ERR_UNSUPPORTED, "record encrypted not support yet");
       }
       record_block_decrypted_buff = record_block_cmp_buffer + 8 * sizeof(char);
       // decompress
       if (comp_type == 1 /* lzo */) {
-        throw std::runtime_error("lzo compress not support yet");
+        throw mdict_error(MDICT_ERR_UNSUPPORTED, "lzo compress not support yet");
       } else if (comp_type == 2) {
         // zlib compress
         record_block_uncompressed_v =
             zlib_mem_uncompress(record_block_decrypted_buff, comp_size);
         if (record_block_uncompressed_v.empty()) {
-          throw std::runtime_error("record block decompress failed size == 0");
+          throw mdict_error(MDICT_ERR_DECOMPRESS,
+                          "record block decompress failed size == 0");
         }
         record_block_uncompressed_b = record_block_uncompressed_v.data();
-        uint32_t adler32cs = adler32checksum(
-            record_block_uncompressed_b, static_cast<uint32_t>(uncomp_size));
-        assert(adler32cs == checksum);
-        assert(record_block_uncompressed_v.size() == uncomp_size);
+        if (record_block_uncompressed_v.size() != uncomp_size ||
+            adler32checksum(record_block_uncompressed_b, uncomp_size) !=
+                checksum) {
+          free(comp_type_b);
+          free(record_block_cmp_buffer);
+          throw mdict_error(MDICT_ERR_CORRUPT,
+                            "record block checksum mismatch");
+        }
       } else {
-        throw std::runtime_error(
-            "cannot determine the record block compress type");
+        throw mdict_error(MDICT_ERR_CORRUPT,
+                          "cannot determine the record block compress type");
       }
     }
 
@@ -1157,7 +1445,9 @@ int Mdict::decode_record_block() {
 
     //    break;
   }
-  assert(size_counter == record_block_size);
+  if (size_counter != record_block_size) {
+    throw mdict_error(MDICT_ERR_CORRUPT, "record block size mismatch");
+  }
   return 0;
 }
 
@@ -1170,19 +1460,21 @@ int Mdict::decode_record_block() {
  * @return
  */
 int Mdict::decode_key_block_info(char *key_block_info_buffer,
-                                 unsigned long kb_info_buff_len,
-                                 int key_block_num, int entries_num) {
+                                 uint64_t kb_info_buff_len,
+                                 uint64_t key_block_num, uint64_t entries_num) {
   char *kb_info_buff = key_block_info_buffer;
 
   // key block info offset indicator
-  unsigned long data_offset = 0;
+  uint64_t data_offset = 0;
 
+  std::vector<uint8_t> decompress_buff;
   if (this->version >= 2.0) {
     // if version >= 2.0, use zlib compression
-    assert(kb_info_buff[0] == 2);
-    assert(kb_info_buff[1] == 0);
-    assert(kb_info_buff[2] == 0);
-    assert(kb_info_buff[3] == 0);
+    // zlib compression type, then the adler32 checksum
+    if (kb_info_buff_len < 8 || kb_info_buff[0] != 2 || kb_info_buff[1] != 0 ||
+        kb_info_buff[2] != 0 || kb_info_buff[3] != 0) {
+      throw mdict_error(MDICT_ERR_CORRUPT, "bad key block info header");
+    }
     byte *kb_info_decrypted = (unsigned char *)key_block_info_buffer;
     if (this->encrypt == ENCRYPT_KEY_INFO_ENC) {
       kb_info_decrypted = mdx_decrypt((byte *)kb_info_buff, kb_info_buff_len);
@@ -1212,188 +1504,209 @@ int Mdict::decode_key_block_info(char *key_block_info_buffer,
 
     // note: we should uncompress key_block_info_buffer[8:] data, so we need
     // (decrypted + 8, and length -8)
-    std::vector<uint8_t> decompress_buff =
+    decompress_buff =
         zlib_mem_uncompress(kb_info_decrypted + 8, kb_info_buff_len - 8,
                             this->key_block_info_decompress_size);
-    /// uncompress successed
-    assert(decompress_buff.size() == this->key_block_info_decompress_size);
+    if (decompress_buff.size() != this->key_block_info_decompress_size) {
+      throw mdict_error(MDICT_ERR_DECOMPRESS,
+                        "key block info decompressed to the wrong size");
+    }
+  } else {
+    // before 2.0 the key block info is stored as is
+    decompress_buff.assign(kb_info_buff, kb_info_buff + kb_info_buff_len);
+  }
 
-    // get key block info list
-    //          std::vector<key_block_info*> key_block_info_list;
-    /// entries summary, every block has a lot of entries, the sum of entries
-    /// should equals entries_number
-    unsigned long num_entries_counter = 0;
-    // key number counter
-    unsigned long counter = 0;
+  // get key block info list
+  //          std::vector<key_block_info*> key_block_info_list;
+  /// entries summary, every block has a lot of entries, the sum of entries
+  /// should equals entries_number
+  uint64_t num_entries_counter = 0;
+  // key number counter
+  uint64_t counter = 0;
 
-    // current block entries
-    unsigned long current_entries = 0;
+  // current block entries
+  uint64_t current_entries = 0;
 
-    unsigned long previous_start_offset = 0;
+  uint64_t previous_start_offset = 0;
+
+  int byte_width = 1;
+  int text_term = 0;
+  if (this->version >= 2.0) {
+    byte_width = 2;
+    text_term = 1;
+  }
 
-    int byte_width = 1;
-    int text_term = 0;
+  uint64_t comp_acc = 0;
+  uint64_t decomp_acc = 0;
+  // the next n bytes must be in the buffer
+  auto need = [&](uint64_t n) {
+    if (data_offset + n > decompress_buff.size()) {
+      throw mdict_error(MDICT_ERR_CORRUPT, "key block info truncated");
+    }
+  };
+  while (counter < this->key_block_num) {
+    need(this->number_width + byte_width);
     if (this->version >= 2.0) {
-      byte_width = 2;
-      text_term = 1;
+      auto bin_pointer =
+          decompress_buff.data() + data_offset * sizeof(uint8_t);
+      current_entries = be_bin_to_u64(bin_pointer);
+    } else {
+      auto bin_pointer =
+          decompress_buff.data() + data_offset * sizeof(uint8_t);
+      current_entries = be_bin_to_u32(bin_pointer);
     }
+    num_entries_counter += current_entries;
 
-    unsigned long comp_acc = 0l;
-    unsigned long decomp_acc = 0l;
-    while (counter < this->key_block_num) {
-      if (this->version >= 2.0) {
-        auto bin_pointer =
-            decompress_buff.data() + data_offset * sizeof(uint8_t);
-        current_entries = be_bin_to_u64(bin_pointer);
-      } else {
-        auto bin_pointer =
-            decompress_buff.data() + data_offset * sizeof(uint8_t);
-        current_entries = be_bin_to_u32(bin_pointer);
-      }
-      num_entries_counter += current_entries;
-
-      // move offset
-      // if version>= 2.0 move forward 8 bytes
+    // move offset
+    // if version>= 2.0 move forward 8 bytes
 
-      data_offset += this->number_width * sizeof(uint8_t);
+    data_offset += this->number_width * sizeof(uint8_t);
 
-      // first key size
-      unsigned long first_key_size = 0;
-
-      if (this->version >= 2.0) {
-        first_key_size = be_bin_to_u16(decompress_buff.data() +
-                                       data_offset * sizeof(uint8_t));
-      } else {
-        first_key_size = be_bin_to_u8(decompress_buff.data() +
-                                      data_offset * sizeof(uint8_t));
-      }
-      data_offset += byte_width;
+    // first key size
+    unsigned long first_key_size = 0;
 
-      // step_gap means first key start offset to first key end;
-      int step_gap = 0;
+    if (this->version >= 2.0) {
+      first_key_size = be_bin_to_u16(decompress_buff.data() +
+                                     data_offset * sizeof(uint8_t));
+    } else {
+      first_key_size = be_bin_to_u8(decompress_buff.data() +
+                                    data_offset * sizeof(uint8_t));
+    }
+    data_offset += byte_width;
 
-      if (this->encoding == 1 /* encoding utf16 equals 1*/) {
-        step_gap = (first_key_size + text_term) * 2;
-      } else {
-        step_gap = first_key_size + text_term;
-      }
+    // step_gap means first key start offset to first key end;
+    int step_gap = 0;
 
-      // DECODE first CODE
-      // TODO here minus the terminal character size(1), but we still not sure
-      // should minus this or not
-      std::string first_key;
-      if (this->filetype == "MDX") {
-        first_key =
-            be_bin_to_utf8((char *)(decompress_buff.data() + data_offset), 0,
-                           (unsigned long)step_gap - text_term);
-      } else {
-        unsigned char *utf16_point =
-            (unsigned char *)(decompress_buff.data() + data_offset);
-        unsigned long utf16_len = (unsigned long)step_gap - text_term;
-        unsigned char *utf8_buff =
-            (unsigned char *)calloc(utf16_len, sizeof(unsigned char));
-        utf16le_to_utf8(utf16_point, utf16_len - 1, utf8_buff, utf16_len);
-        first_key = std::string(reinterpret_cast<char *>(utf8_buff), utf16_len);
-        free(utf8_buff);
-      }
-      // move forward
-      data_offset += step_gap;
+    if (this->encoding == 1 /* encoding utf16 equals 1*/) {
+      step_gap = (first_key_size + text_term) * 2;
+    } else {
+      step_gap = first_key_size + text_term;
+    }
+    need(step_gap + byte_width);
+
+    // DECODE first CODE
+    // TODO here minus the terminal character size(1), but we still not sure
+    // should minus this or not
+    std::string first_key;
+    if (this->filetype == "MDX") {
+      first_key =
+          be_bin_to_utf8((char *)(decompress_buff.data() + data_offset), 0,
+                         (unsigned long)step_gap - text_term);
+    } else {
+      unsigned char *utf16_point =
+          (unsigned char *)(decompress_buff.data() + data_offset);
+      unsigned long utf16_len = (unsigned long)step_gap - text_term;
+      unsigned char *utf8_buff =
+          (unsigned char *)calloc(utf16_len, sizeof(unsigned char));
+      // the key without its terminator, 2 bytes from version 2.0 on
+      utf16le_to_utf8(utf16_point, step_gap - text_term * 2, utf8_buff,
+                      utf16_len);
+      first_key = std::string(reinterpret_cast<char *>(utf8_buff), utf16_len);
+      free(utf8_buff);
+    }
+    // move forward
+    data_offset += step_gap;
 
-      // the last key
-      unsigned long last_key_size = 0;
+    // the last key
+    unsigned long last_key_size = 0;
 
-      if (this->version >= 2.0) {
-        last_key_size = be_bin_to_u16(decompress_buff.data() +
-                                      data_offset * sizeof(uint8_t));
-      } else {
-        last_key_size = be_bin_to_u8(decompress_buff.data() +
-                                     data_offset * sizeof(uint8_t));
-      }
-      data_offset += byte_width;
+    if (this->version >= 2.0) {
+      last_key_size = be_bin_to_u16(decompress_buff.data() +
+                                    data_offset * sizeof(uint8_t));
+    } else {
+      last_key_size = be_bin_to_u8(decompress_buff.data() +
+                                   data_offset * sizeof(uint8_t));
+    }
+    data_offset += byte_width;
 
-      if (this->encoding == 1 /* ENCODING_UTF16 */) {
-        step_gap = (last_key_size + text_term) * 2;
-      } else {
-        step_gap = last_key_size + text_term;
-      }
+    if (this->encoding == 1 /* ENCODING_UTF16 */) {
+      step_gap = (last_key_size + text_term) * 2;
+    } else {
+      step_gap = last_key_size + text_term;
+    }
+    need(step_gap + 2 * this->number_width);
 
-      std::string last_key;
-      if (this->filetype == "MDX") {
-        last_key =
-            be_bin_to_utf8((char *)(decompress_buff.data() + data_offset), 0,
-                           (unsigned long)step_gap - text_term);
-      } else {
-        unsigned char *utf16_point =
-            (unsigned char *)(decompress_buff.data() + data_offset);
-        unsigned long utf16_len = (unsigned long)step_gap - text_term;
-        unsigned char *utf8_buff =
-            (unsigned char *)calloc(utf16_len, sizeof(unsigned char));
-        utf16le_to_utf8(utf16_point, utf16_len - 1, utf8_buff, utf16_len);
-        last_key = std::string(reinterpret_cast<char *>(utf8_buff), utf16_len);
-        free(utf8_buff);
-      }
+    std::string last_key;
+    if (this->filetype == "MDX") {
+      last_key =
+          be_bin_to_utf8((char *)(decompress_buff.data() + data_offset), 0,
+                         (unsigned long)step_gap - text_term);
+    } else {
+      unsigned char *utf16_point =
+          (unsigned char *)(decompress_buff.data() + data_offset);
+      unsigned long utf16_len = (unsigned long)step_gap - text_term;
+      unsigned char *utf8_buff =
+          (unsigned char *)calloc(utf16_len, sizeof(unsigned char));
+      // the key without its terminator, 2 bytes from version 2.0 on
+      utf16le_to_utf8(utf16_point, step_gap - text_term * 2, utf8_buff,
+                      utf16_len);
+      last_key = std::string(reinterpret_cast<char *>(utf8_buff), utf16_len);
+      free(utf8_buff);
+    }
 
-      // move forward
-      data_offset += step_gap;
+    // move forward
+    data_offset += step_gap;
 
-      // ------------
-      // key block part
-      // ------------
+    // ------------
+    // key block part
+    // ------------
 
-      uint64_t key_block_compress_size = 0;
-      if (version >= 2.0) {
-        key_block_compress_size =
-            be_bin_to_u64(decompress_buff.data() + data_offset);
-      } else {
-        key_block_compress_size =
-            be_bin_to_u32(decompress_buff.data() + data_offset);
-      }
+    uint64_t key_block_compress_size = 0;
+    if (version >= 2.0) {
+      key_block_compress_size =
+          be_bin_to_u64(decompress_buff.data() + data_offset);
+    } else {
+      key_block_compress_size =
+          be_bin_to_u32(decompress_buff.data() + data_offset);
+    }
 
-      data_offset += this->number_width;
+    data_offset += this->number_width;
 
-      uint64_t key_block_decompress_size = 0;
+    uint64_t key_block_decompress_size = 0;
 
-      if (version >= 2.0) {
-        key_block_decompress_size =
-            be_bin_to_u64(decompress_buff.data() + data_offset);
-      } else {
-        key_block_decompress_size =
-            be_bin_to_u32(decompress_buff.data() + data_offset);
-      }
+    if (version >= 2.0) {
+      key_block_decompress_size =
+          be_bin_to_u64(decompress_buff.data() + data_offset);
+    } else {
+      key_block_decompress_size =
+          be_bin_to_u32(decompress_buff.data() + data_offset);
+    }
 
-      // entries offset move forward
-      data_offset += this->number_width;
+    // entries offset move forward
+    data_offset += this->number_width;
 
-      key_block_info *kbinfo = new key_block_info(
-          first_key, last_key, previous_start_offset, key_block_compress_size,
-          key_block_decompress_size, comp_acc, decomp_acc);
+    key_block_info *kbinfo = new key_block_info(
+        first_key, last_key, previous_start_offset, key_block_compress_size,
+        key_block_decompress_size, comp_acc, decomp_acc);
 
-      // adjust ofset
-      previous_start_offset += key_block_compress_size;
-      key_block_info_list.push_back(kbinfo);
+    // adjust ofset
+    previous_start_offset += key_block_compress_size;
+    key_block_info_list.push_back(kbinfo);
 
-      // key block counter
-      counter += 1;
-      // accumulate
-      comp_acc += key_block_compress_size;
-      decomp_acc += key_block_decompress_size;
-      //          break;
-    }
-    assert(counter == this->key_block_num);
+    // key block counter
+    counter += 1;
+    // accumulate
+    comp_acc += key_block_compress_size;
+    decomp_acc += key_block_decompress_size;
+    //          break;
+  }
+  if (counter != this->key_block_num) {
+    throw mdict_error(MDICT_ERR_CORRUPT,
+                      "key block info holds " + std::to_string(counter) +
+                          " blocks, the header says " +
+                          std::to_string(this->key_block_num));
+  }
 
-    // this allows us to handle some cases of malformed dictionaries without crashing.
-    if (num_entries_counter != this->entries_num) {
-    std::cerr << "[Warning] Key entry count mismatch: "
-              << num_entries_counter << " (found) vs "
-              << this->entries_num << " (expected)"
-              << std::endl;
-    }
+  // this allows us to handle some cases of malformed dictionaries without crashing.
+  if (num_entries_counter != this->entries_num) {
+    MDICT_LOG(log(), MDICT_LOG_WARN,
+              "key entry count mismatch: " << num_entries_counter
+                                           << " (found) vs "
+                                           << this->entries_num
+                                           << " (expected)");
+  }
  
 
-  } else {
-    // doesn't compression
-    throw std::logic_error("not implements yet");
-  }
 
   this->key_block_body_start =
       this->key_block_info_start_offset + this->key_block_info_size;
@@ -1406,16 +1719,52 @@ int Mdict::decode_key_block_info(char *key_block_info_buffer,
  * @param offset the file start offset
  * @param len the byte length needs to read
  * @param buf the target buffer
+ * @return false if the file ended or failed before len bytes, the stream
+ * is reset for the next read
  */
-void Mdict::readfile(uint64_t offset, uint64_t len, char *buf) {
+bool Mdict::readfile(uint64_t offset, uint64_t len, char *buf) {
+  this->io.reads++;
+  this->io.bytes += len;
   instream.seekg(offset);
   instream.read(buf, static_cast<std::streamsize>(len));
+  if (!instream) {
+    instream.clear();
+    return false;
+  }
+  return true;
 }
 
 /***************************************
  *             public part             *
  ***************************************/
 
+result<std::unique_ptr<Mdict>> Mdict::open(const std::string &fn) {
+  mdict_open_options_t options;
+  mdict_open_options_init(&options);
+  return open(fn, options);
+}
+
+result<std::unique_ptr<Mdict>> Mdict::open(
+    const std::string &fn, const mdict_open_options_t &options) {
+  std::error_code ec;
+  if (!std::filesystem::exists(fn, ec)) {
+    return MDICT_ERR_IO;
+  }
+  std::unique_ptr<Mdict> dict(new Mdict(fn));
+  dict->set_index_window(options.index_window_bytes);
+  try {
+    dict->init();
+  } catch (mdict_error &e) {
+    MDICT_LOG(dict->log(), MDICT_LOG_DEBUG, "open error: " << e.what());
+    return e.code;
+  } catch (std::exception &e) {
+    // the header and index parsers throw plain exceptions on garbage
+    MDICT_LOG(dict->log(), MDICT_LOG_DEBUG, "open error: " << e.what());
+    return MDICT_ERR_CORRUPT;
+  }
+  return std::move(dict);
+}
+
 /**
  * init the dictionary file
  */
@@ -1424,14 +1773,57 @@ void Mdict::init() {
     throw std::runtime_error("File does not exist: " + filename);
   }
 
+  // the prefetch worker reads the index, stop it before the index goes
+  bool prefetching = this->prefetch != nullptr;
+  this->prefetch.reset();
+  this->reset_index();
+
   this->instream = std::ifstream(filename, std::ios::binary);
 
+  // identity: size + mtime + checksums of the head (header and index
+  // headers) and the tail of the file, used to invalidate derived caches.
+  // it does not depend on the path, a moved dictionary keeps its sidecar
+  std::error_code ec;
+  uint64_t fsize = std::filesystem::file_size(filename, ec);
+  auto mtime = std::filesystem::last_write_time(filename, ec)
+                   .time_since_epoch()
+                   .count();
+  uint64_t head_len = std::min<uint64_t>(fsize, MDICT_IDENTITY_HEAD_BYTES);
+  uint64_t tail_len = std::min<uint64_t>(fsize, MDICT_IDENTITY_TAIL_BYTES);
+  std::vector<char> sample(head_len + tail_len);
+  if (!this->readfile(0, head_len, sample.data()) ||
+      !this->readfile(fsize - tail_len, tail_len, sample.data() + head_len)) {
+    throw mdict_error(MDICT_ERR_IO, "short read of the file identity");
+  }
+  uint64_t h = 0x9e3779b97f4a7c15ULL;
+  for (uint64_t v :
+       {fsize, static_cast<uint64_t>(mtime),
+        static_cast<uint64_t>(adler32checksum(
+            reinterpret_cast<const unsigned char *>(sample.data()), head_len)),
+        static_cast<uint64_t>(adler32checksum(
+            reinterpret_cast<const unsigned char *>(sample.data()) + head_len,
+            tail_len))}) {
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  }
+  if (this->dict_identity != 0 && h != this->dict_identity && this->blocks) {
+    // the file changed, the blocks cached for it are stale
+    this->blocks->erase_dict(this->cache_id);
+  }
+  this->dict_identity = h;
+  if (this->results) {
+    this->results->bind(this->dict_identity);
+  }
+
   /* indexing... */
   this->read_header();
   this->read_key_block_header();
   this->read_key_block_info();
   this->read_record_block_header();
   //  this->decode_record_block(); // don't use this function, it's too slow
+  this->key_hash_once.reset(new std::once_flag());
+  if (prefetching) {
+    this->enable_prefetch(true);
+  }
 }
 
 /**
@@ -1483,29 +1875,57 @@ long Mdict::reduce_key_info_block_items_vector(
 }
 
 /**
- *
- * @param wordlist
- * @param phrase
- * @return
+ * build the bucket table of reduce_record_block_offset: the decompressed
+ * offset space is cut into 2^record_bucket_shift sized buckets (about one
+ * bucket per record block), each bucket stores the block holding its first
+ * offset
  */
-long Mdict::reduce_record_block_offset(
-    unsigned long record_start) { // non-recursive reduce implements
-  // TODO OPTIMISE
-  unsigned long left = 0l;
-  unsigned long right = this->record_header.size() - 1;
-  unsigned long mid = 0;
-  while (left <= right) {
-    mid = left + ((right - left) >> 1);
-    if (record_start >=
-        this->record_header[mid]->decompressed_size_accumulator) {
-      left = mid + 1;
-    } else if (record_start <
-               this->record_header[mid]->decompressed_size_accumulator) {
-      right = mid - 1;
+void Mdict::build_record_buckets() {
+  this->record_buckets.clear();
+  this->record_bucket_shift = 0;
+  uint64_t blocks = this->record_decomp_offsets.size() - 1;
+  uint64_t total = this->record_decomp_offsets.back();
+  if (blocks == 0 || total == 0) {
+    return;
+  }
+  while ((total >> this->record_bucket_shift) > blocks) {
+    this->record_bucket_shift++;
+  }
+
+  uint64_t bucket_num = (total >> this->record_bucket_shift) + 1;
+  this->record_buckets.resize(bucket_num);
+  uint64_t rid = 0;
+  for (uint64_t b = 0; b < bucket_num; b++) {
+    uint64_t bucket_start = b << this->record_bucket_shift;
+    while (rid + 1 < blocks && this->record_decomp_offsets[rid + 1] <= bucket_start) {
+      rid++;
     }
+    this->record_buckets[b] = static_cast<uint32_t>(rid);
   }
-  return left - 1;
-  return 0;
+}
+
+/**
+ * find the record block containing a record start offset
+ * @param record_start record offset in the decompressed record data
+ * @return the record block id, offsets past the end map to the last block
+ */
+long Mdict::reduce_record_block_offset(uint64_t record_start) {
+  if (this->record_buckets.empty()) {
+    return 0;
+  }
+  uint64_t blocks = this->record_decomp_offsets.size() - 1;
+  uint64_t b = static_cast<uint64_t>(record_start) >> this->record_bucket_shift;
+  if (b >= this->record_buckets.size()) {
+    return static_cast<long>(blocks - 1);
+  }
+  // the block is between the first blocks of this and the next bucket
+  uint64_t lo = this->record_buckets[b];
+  uint64_t hi = b + 1 < this->record_buckets.size()
+                    ? this->record_buckets[b + 1]
+                    : blocks - 1;
+  auto first = this->record_decomp_offsets.begin();
+  auto it = std::upper_bound(first + lo + 1, first + hi + 1, record_start);
+  return static_cast<long>((it - first) - 1);
 }
 
 std::string Mdict::reduce_particial_keys_vector(
@@ -1533,40 +1953,690 @@ std::string Mdict::reduce_particial_keys_vector(
 }
 
 std::string Mdict::locate(const std::string resource_name,
-                          mdict_encoding_t encoding) {
-  // find key item in key list
-  auto it = std::find_if(this->key_list.begin(), this->key_list.end(),
-                         [&](const key_list_item *item) {
-                           return item->key_word == resource_name;
-                         });
-  if (it != this->key_list.end()) {
-    std::string key_word = (*it)->key_word;
-    if (key_word == resource_name) {
-      if ((*it)->record_start >= 0) {
-        // reduce search the record block index by word record start offset
-        unsigned long record_block_idx =
-            reduce_record_block_offset((*it)->record_start);
-        // decode recode by record index
-        auto vec = decode_record_block_by_rid(record_block_idx);
-        // reduce the definition by word
-        std::string def = reduce_particial_keys_vector(vec, resource_name);
-
-        auto treated_output = trim_nulls(def);
-
-        if (encoding == MDICT_ENCODING_HEX) {
-          return treated_output; // Return raw hex string
-        } else {
-          return base64_from_hex(
-              treated_output); // Return base64 encoded string
-        }
-      }
-      return std::string("");
-    }
+                          mdict_encoding_t encoding, mdict_access_t hint) {
+  return this->find_resource(resource_name, encoding, hint).value();
+}
+
+result<std::string> Mdict::find_resource(const std::string &resource_name,
+                                         mdict_encoding_t encoding,
+                                         mdict_access_t hint) {
+  // scans bypass the definition cache entirely
+  result_cache *rcache = this->is_scan(hint) ? nullptr : this->results.get();
+  std::string cache_key;
+  if (rcache) {
+    cache_key = result_cache::make_key(encoding == MDICT_ENCODING_HEX
+                                           ? result_cache::LOCATE_HEX
+                                           : result_cache::LOCATE_BASE64,
+                                       resource_name);
+    std::string cached;
+    if (rcache->get(cache_key, cached)) {
+      this->last_err = MDICT_OK;
+      return cached;
+    }
+  }
+
+  unsigned long rid = 0;
+  uint64_t start = 0;
+  uint64_t end = 0;
+  block_ptr block;
+  mdict_error_t err = MDICT_OK;
+  try {
+    long idx = this->find_key_index(resource_name);
+    if (idx < 0) {
+      err = MDICT_ERR_NOT_FOUND;
+    }
+    if (err == MDICT_OK) {
+      err = this->record_range(idx, rid, start, end);
+    }
+    if (err == MDICT_OK) {
+      err = this->fetch_record_block(rid, hint, block);
+    }
+    if (err == MDICT_OK && end > block->size()) {
+      err = MDICT_ERR_CORRUPT;
+    }
+    if (err == MDICT_OK) {
+      auto treated_output = trim_nulls(this->record_text(block, start, end));
+      if (encoding != MDICT_ENCODING_HEX) {
+        treated_output = base64_from_hex(treated_output);
+      }
+      if (rcache) {
+        rcache->put(cache_key, treated_output);
+      }
+      this->last_err = MDICT_OK;
+      return treated_output;
+    }
+  } catch (mdict_error &e) {
+    err = e.code;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "find_resource error: " << e.what());
+  } catch (std::exception &e) {
+    err = MDICT_ERR_INTERNAL;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "find_resource error: " << e.what());
+  }
+  if (err != MDICT_ERR_NOT_FOUND) {
+    MDICT_LOG(log(), MDICT_LOG_DEBUG,
+              "find_resource " << resource_name << ": " << mdict_strerror(err));
+  }
+  this->last_err = err;
+  return err;
+}
+
+long Mdict::find_key_index(const std::string &name) const {
+  if (!this->key_hash_once) {
+    // not initialized
+    return -1;
+  }
+  std::call_once(*this->key_hash_once, [this]() {
+    this->key_hash.reserve(this->key_list.size());
+    for (uint64_t i = 0; i < this->key_list.size(); i++) {
+      // emplace keeps the first of duplicate keys
+      this->key_hash.emplace(this->key_list[i]->key_word, i);
+    }
+  });
+  auto it = this->key_hash.find(name);
+  if (it == this->key_hash.end()) {
+    return -1;
+  }
+  return static_cast<long>(it->second);
+}
+
+// schemes of references which are not resources of the dictionary
+static const char *const foreign_schemes[] = {
+    "entry://", "bword://", "http://", "https://", "data:", "javascript:",
+    "mailto:"};
+// schemes dropped from references to resources
+static const char *const resource_schemes[] = {"sound://", "file://"};
+
+static bool starts_with_nocase(const std::string &s, const char *prefix) {
+  size_t n = strlen(prefix);
+  if (s.size() < n) {
+    return false;
+  }
+  for (size_t i = 0; i < n; i++) {
+    if (std::tolower(static_cast<unsigned char>(s[i])) != prefix[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// the resource name of an attribute value, empty if it is not a resource
+static std::string resource_name_of(std::string ref) {
+  for (const char *scheme : foreign_schemes) {
+    if (starts_with_nocase(ref, scheme)) {
+      return std::string();
+    }
+  }
+  for (const char *scheme : resource_schemes) {
+    if (starts_with_nocase(ref, scheme)) {
+      ref.erase(0, strlen(scheme));
+      break;
+    }
+  }
+  size_t cut = ref.find_first_of("#?");
+  if (cut != std::string::npos) {
+    ref.erase(cut);
+  }
+  if (ref.compare(0, 2, "./") == 0) {
+    ref.erase(0, 2);
+  }
+  if (ref.empty()) {
+    return ref;
+  }
+  std::replace(ref.begin(), ref.end(), '/', '\\');
+  if (ref[0] != '\\') {
+    ref.insert(ref.begin(), '\\');
+  }
+  return ref;
+}
+
+std::vector<std::string> Mdict::resource_names(const std::string &definition) {
+  std::vector<std::string> names;
+  std::unordered_set<std::string> seen;
+  for (size_t pos = 0; pos < definition.size(); pos++) {
+    // an attribute name after a blank: src=... or href=...
+    size_t len = 0;
+    if (pos > 0 && std::isspace(static_cast<unsigned char>(definition[pos - 1]))) {
+      std::string rest = definition.substr(pos, 5);
+      if (starts_with_nocase(rest, "src=")) {
+        len = 4;
+      } else if (starts_with_nocase(rest, "href=")) {
+        len = 5;
+      }
+    }
+    if (len == 0) {
+      continue;
+    }
+    size_t start = pos + len;
+    size_t stop = start;
+    if (start < definition.size() &&
+        (definition[start] == '"' || definition[start] == '\'')) {
+      stop = definition.find(definition[start], start + 1);
+      start++;
+    } else {
+      stop = definition.find_first_of(" \t\r\n>", start);
+    }
+    if (stop == std::string::npos) {
+      stop = definition.size();
+    }
+    std::string name = resource_name_of(definition.substr(start, stop - start));
+    if (!name.empty() && seen.insert(name).second) {
+      names.push_back(std::move(name));
+    }
+    pos = stop;
+  }
+  return names;
+}
+
+mdict_error_t Mdict::locate_batch(const std::vector<std::string> &names,
+                                  std::vector<resource_payload> &out,
+                                  mdict_access_t hint) {
+  out.assign(names.size(), resource_payload());
+  std::vector<size_t> found;
+  std::vector<size_t> key_indexes;
+  for (size_t i = 0; i < names.size(); i++) {
+    out[i].name = names[i];
+    long idx = this->find_key_index(names[i]);
+    if (idx >= 0) {
+      found.push_back(i);
+      key_indexes.push_back(static_cast<size_t>(idx));
+    }
+  }
+
+  std::vector<resource_payload> located;
+  this->locate_batch_at(key_indexes, located, hint);
+  for (size_t j = 0; j < found.size(); j++) {
+    out[found[j]].err = located[j].err;
+    out[found[j]].data = std::move(located[j].data);
+  }
+  this->last_err = MDICT_OK;
+  for (const auto &p : out) {
+    if (p.err != MDICT_OK) {
+      this->last_err = p.err;
+      break;
+    }
+  }
+  return this->last_err;
+}
+
+mdict_error_t Mdict::locate_batch_at(const std::vector<size_t> &key_indexes,
+                                     std::vector<resource_payload> &out,
+                                     mdict_access_t hint) {
+  out.resize(key_indexes.size());
+
+  // resolve every record, then load the blocks in one pass
+  struct pending {
+    size_t resource;
+    uint64_t start;
+    uint64_t end;
+  };
+  std::vector<pending> todo;
+  std::vector<unsigned long> rids;
+  for (size_t i = 0; i < key_indexes.size(); i++) {
+    unsigned long rid = 0;
+    uint64_t start = 0;
+    uint64_t end = 0;
+    out[i].err = this->record_range(key_indexes[i], rid, start, end);
+    out[i].data.clear();
+    if (out[i].err != MDICT_OK) {
+      continue;
+    }
+    todo.push_back(pending{i, start, end});
+    rids.push_back(rid);
+  }
+
+  std::vector<mdict_error_t> errs;
+  std::vector<block_ptr> loaded = this->load_record_blocks(rids, hint, &errs);
+  for (size_t j = 0; j < todo.size(); j++) {
+    resource_payload &p = out[todo[j].resource];
+    if (errs[j] != MDICT_OK) {
+      p.err = errs[j];
+    } else if (todo[j].end > loaded[j]->size()) {
+      p.err = MDICT_ERR_CORRUPT;
+    } else {
+      p.data.assign(
+          reinterpret_cast<const char *>(loaded[j]->data()) + todo[j].start,
+          todo[j].end - todo[j].start);
+    }
+  }
+  this->last_err = MDICT_OK;
+  for (const auto &p : out) {
+    if (p.err != MDICT_OK) {
+      this->last_err = p.err;
+      break;
+    }
+  }
+  return this->last_err;
+}
+
+std::string Mdict::locate_record(size_t key_index, mdict_encoding_t encoding,
+                                 mdict_access_t hint) {
+  const key_list_item *item = this->key_list.at(key_index);
+  // reduce search the record block index by word record start offset
+  unsigned long record_block_idx = reduce_record_block_offset(item->record_start);
+  // decode recode by record index
+  auto vec = decode_record_block_by_rid(record_block_idx, hint);
+  // reduce the definition by word
+  std::string def = reduce_particial_keys_vector(vec, item->key_word);
+
+  auto treated_output = trim_nulls(def);
+  if (encoding != MDICT_ENCODING_HEX) {
+    treated_output = base64_from_hex(treated_output);  // Return base64 encoded string
+  }
+  return treated_output;
+}
+
+std::string Mdict::locate_at(size_t key_index, mdict_encoding_t encoding,
+                             mdict_access_t hint) {
+  if (key_index >= this->key_list.size()) {
+    this->last_err = MDICT_ERR_INVALID_ARGUMENT;
+    return std::string("");
+  }
+  try {
+    std::string out = this->locate_record(key_index, encoding, hint);
+    this->last_err = MDICT_OK;
+    return out;
+  } catch (mdict_error &e) {
+    this->last_err = e.code;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "locate error: " << e.what());
+  } catch (std::exception &e) {
+    this->last_err = MDICT_ERR_INTERNAL;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "locate error: " << e.what());
   }
   return std::string("");
 }
 
-std::string Mdict::lookup0(const std::string word) {
+void Mdict::record_range_at(size_t key_index, unsigned long &rid,
+                            uint64_t &start, uint64_t &end) {
+  mdict_error_t err = this->record_range(key_index, rid, start, end);
+  if (err == MDICT_ERR_INVALID_ARGUMENT) {
+    throw mdict_error(err, "key index out of range");
+  } else if (err != MDICT_OK) {
+    throw mdict_error(err, "record outside of its block");
+  }
+}
+
+mdict_error_t Mdict::record_range(size_t key_index, unsigned long &rid,
+                                  uint64_t &start, uint64_t &end) {
+  if (key_index >= this->key_list.size() || this->record_buckets.empty()) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto it = this->key_list.begin() + key_index;
+  uint64_t record_start = (*it)->record_start;
+  uint64_t record_end = this->record_decomp_offsets.back();
+  if (it + 1 != this->key_list.end()) {
+    record_end = (*(it + 1))->record_start;
+  }
+
+  rid = reduce_record_block_offset(record_start);
+  uint64_t block_start = this->record_decomp_offsets[rid];
+  uint64_t block_end = this->record_decomp_offsets[rid + 1];
+  // the last record of a block ends with the block
+  record_end = std::min(record_end, block_end);
+  if (record_start < block_start || record_start > record_end) {
+    return MDICT_ERR_CORRUPT;
+  }
+  start = record_start - block_start;
+  end = record_end - block_start;
+  return MDICT_OK;
+}
+
+/**
+ * deliver bytes [start, end) of a buffer in pieces of at most chunk_bytes
+ */
+static void emit_bytes(const block_ptr &data, uint64_t start, uint64_t end,
+                       const resource_sink &sink, size_t chunk_bytes) {
+  for (uint64_t pos = start; pos < end; pos += chunk_bytes) {
+    size_t n = static_cast<size_t>(std::min<uint64_t>(chunk_bytes, end - pos));
+    if (!sink(data->data() + pos, n)) {
+      throw mdict_error(MDICT_ERR_IO, "resource sink stopped the transfer");
+    }
+  }
+}
+
+void Mdict::stream_record_range(unsigned long rid, uint64_t start,
+                                uint64_t end, const resource_sink &sink,
+                                size_t chunk_bytes, bool fill_cache) {
+  auto emit_block = [&](const block_ptr &block) {
+    emit_bytes(block, start, end, sink, chunk_bytes);
+  };
+
+  // decompressed already, slice it
+  if (this->blocks) {
+    block_key bk{this->cache_id, RECORD_BLOCK, rid};
+    if (block_ptr cached = this->blocks->get(bk, !fill_cache)) {
+      emit_block(cached);
+      return;
+    }
+    if (fill_cache &&
+        this->record_decomp_size(rid) <= this->blocks->capacity() / 8) {
+      emit_block(this->load_record_block(rid, MDICT_ACCESS_NORMAL));
+      return;
+    }
+  }
+
+  uint64_t comp_size = this->record_comp_size(rid);
+  uint64_t file_offset = this->record_block_offset + this->record_comp_offsets[rid];
+  if (comp_size < 8) {
+    throw mdict_error(MDICT_ERR_CORRUPT, "record block too short");
+  }
+  if (this->encrypt == ENCRYPT_RECORD_ENC) {
+    throw mdict_error(MDICT_ERR_UNSUPPORTED, "record encrypted not support yet");
+  }
+
+  std::vector<uint8_t> in(chunk_bytes);
+  if (!this->readfile(file_offset, 4, (char *)in.data())) {
+    throw mdict_error(MDICT_ERR_IO, "short read of record block header");
+  }
+  int comp_type = in[0] & 0xff;
+
+  if (comp_type == 0) {
+    // stored, the range maps straight to the file
+    for (uint64_t pos = start; pos < end;) {
+      uint64_t n = std::min<uint64_t>(chunk_bytes, end - pos);
+      if (!this->readfile(file_offset + 8 + pos, n, (char *)in.data())) {
+        throw mdict_error(MDICT_ERR_IO, "short read of record block");
+      }
+      if (!sink(in.data(), static_cast<size_t>(n))) {
+        throw mdict_error(MDICT_ERR_IO, "resource sink stopped the transfer");
+      }
+      pos += n;
+    }
+    return;
+  }
+  if (comp_type == 1) {
+    // lzo has no streaming decoder, the block is small in version 1.x files
+    emit_block(this->load_record_block(
+        rid, fill_cache ? MDICT_ACCESS_NORMAL : MDICT_ACCESS_SCAN));
+    return;
+  }
+  if (comp_type != 2) {
+    throw mdict_error(MDICT_ERR_CORRUPT,
+                      "record block compress type not streamable");
+  }
+
+  // the zlib stream follows the 4 byte type and 4 byte checksum
+  inflate_range(
+      [&](uint64_t off, uint64_t len, uint8_t *buf) {
+        if (!this->readfile(file_offset + 8 + off, len, (char *)buf)) {
+          throw mdict_error(MDICT_ERR_IO, "short read of record block");
+        }
+      },
+      comp_size - 8, start, end, sink, chunk_bytes, &this->checkpoints, rid);
+}
+
+mdict_error_t Mdict::locate_stream(const std::string &resource_name,
+                                   const resource_sink &sink,
+                                   size_t chunk_bytes) {
+  long idx = this->find_key_index(resource_name);
+  if (idx < 0) {
+    this->last_err = MDICT_ERR_NOT_FOUND;
+    return this->last_err;
+  }
+  return this->locate_stream_at(idx, sink, chunk_bytes);
+}
+
+mdict_error_t Mdict::locate_stream_at(size_t key_index,
+                                      const resource_sink &sink,
+                                      size_t chunk_bytes) {
+  if (!sink || chunk_bytes < 16) {
+    this->last_err = MDICT_ERR_INVALID_ARGUMENT;
+    return this->last_err;
+  }
+  try {
+    unsigned long rid = 0;
+    uint64_t start = 0;
+    uint64_t end = 0;
+    this->record_range_at(key_index, rid, start, end);
+    if (end - start <= MDICT_CONTENT_STORE_MAX_ITEM_BYTES &&
+        content_store::global().capacity() > 0) {
+      block_ptr data = this->shared_content(key_index, rid, start, end);
+      emit_bytes(data, 0, data->size(), sink, chunk_bytes);
+    } else if (this->content_hashes.count(key_index) == 0) {
+      // hash on the way, the whole resource passes through anyway
+      content_hasher hasher;
+      this->stream_record_range(
+          rid, start, end,
+          [&](const uint8_t *data, size_t len) {
+            hasher.update(data, len);
+            return sink(data, len);
+          },
+          chunk_bytes);
+      this->content_hashes[key_index] = hasher.finish();
+    } else {
+      this->stream_record_range(rid, start, end, sink, chunk_bytes);
+    }
+    this->last_err = MDICT_OK;
+  } catch (mdict_error &e) {
+    this->last_err = e.code;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "locate_stream error: " << e.what());
+  } catch (std::exception &e) {
+    this->last_err = MDICT_ERR_INTERNAL;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "locate_stream error: " << e.what());
+  }
+  return this->last_err;
+}
+
+mdict_error_t Mdict::locate_to(const std::string &resource_name, int fd) {
+  if (fd < 0) {
+    this->last_err = MDICT_ERR_INVALID_ARGUMENT;
+    return this->last_err;
+  }
+  return this->locate_stream(
+      resource_name, [fd](const uint8_t *data, size_t len) {
+        while (len > 0) {
+          ssize_t n = ::write(fd, data, len);
+          if (n < 0) {
+            if (errno == EINTR) {
+              continue;
+            }
+            return false;
+          }
+          data += n;
+          len -= static_cast<size_t>(n);
+        }
+        return true;
+      });
+}
+
+mdict_error_t Mdict::locate_range(const std::string &resource_name,
+                                  uint64_t offset, uint64_t length,
+                                  const resource_sink &sink,
+                                  uint64_t *resource_size,
+                                  size_t chunk_bytes) {
+  long idx = this->find_key_index(resource_name);
+  if (idx < 0) {
+    this->last_err = MDICT_ERR_NOT_FOUND;
+    return this->last_err;
+  }
+  return this->locate_range_at(idx, offset, length, sink, resource_size,
+                               chunk_bytes);
+}
+
+mdict_error_t Mdict::locate_range_at(size_t key_index, uint64_t offset,
+                                     uint64_t length,
+                                     const resource_sink &sink,
+                                     uint64_t *resource_size,
+                                     size_t chunk_bytes) {
+  if (!sink || chunk_bytes < 16) {
+    this->last_err = MDICT_ERR_INVALID_ARGUMENT;
+    return this->last_err;
+  }
+  try {
+    unsigned long rid = 0;
+    uint64_t start = 0;
+    uint64_t end = 0;
+    this->record_range_at(key_index, rid, start, end);
+    uint64_t size = end - start;
+    if (resource_size) {
+      *resource_size = size;
+    }
+    if (offset > size) {
+      this->last_err = MDICT_ERR_INVALID_ARGUMENT;
+      return this->last_err;
+    }
+    length = std::min(length, size - offset);
+    if (length > 0 && size <= MDICT_CONTENT_STORE_MAX_ITEM_BYTES &&
+        content_store::global().capacity() > 0) {
+      block_ptr data = this->shared_content(key_index, rid, start, end);
+      emit_bytes(data, offset, offset + length, sink, chunk_bytes);
+    } else if (length > 0) {
+      this->stream_record_range(rid, start + offset, start + offset + length,
+                                sink, chunk_bytes, !is_scan(MDICT_ACCESS_NORMAL));
+    }
+    this->last_err = MDICT_OK;
+  } catch (mdict_error &e) {
+    this->last_err = e.code;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "locate_range error: " << e.what());
+  } catch (std::exception &e) {
+    this->last_err = MDICT_ERR_INTERNAL;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "locate_range error: " << e.what());
+  }
+  return this->last_err;
+}
+
+block_ptr Mdict::shared_content(size_t key_index, unsigned long rid,
+                                uint64_t start, uint64_t end) {
+  content_store &store = content_store::global();
+  auto known = this->content_hashes.find(key_index);
+  if (known != this->content_hashes.end()) {
+    if (block_ptr stored = store.get(known->second)) {
+      return stored;
+    }
+  }
+
+  auto data = std::make_shared<std::vector<uint8_t>>();
+  data->reserve(end - start);
+  bool scan = this->is_scan(MDICT_ACCESS_NORMAL);
+  this->stream_record_range(
+      rid, start, end,
+      [&](const uint8_t *bytes, size_t len) {
+        data->insert(data->end(), bytes, bytes + len);
+        return true;
+      },
+      MDICT_STREAM_CHUNK_BYTES, !scan);
+
+  if (known == this->content_hashes.end()) {
+    content_hasher hasher;
+    hasher.update(data->data(), data->size());
+    known = this->content_hashes.emplace(key_index, hasher.finish()).first;
+  }
+  if (!scan) {
+    // ignored if another dictionary stored the same bytes first
+    store.put(known->second, data);
+  }
+  return data;
+}
+
+mdict_error_t Mdict::resource_hash_at(size_t key_index, content_hash &hash) {
+  try {
+    auto known = this->content_hashes.find(key_index);
+    if (known == this->content_hashes.end()) {
+      unsigned long rid = 0;
+      uint64_t start = 0;
+      uint64_t end = 0;
+      this->record_range_at(key_index, rid, start, end);
+      content_hasher hasher;
+      this->stream_record_range(
+          rid, start, end,
+          [&](const uint8_t *data, size_t len) {
+            hasher.update(data, len);
+            return true;
+          },
+          MDICT_STREAM_CHUNK_BYTES);
+      known = this->content_hashes.emplace(key_index, hasher.finish()).first;
+    }
+    hash = known->second;
+    this->last_err = MDICT_OK;
+  } catch (mdict_error &e) {
+    this->last_err = e.code;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "resource_hash error: " << e.what());
+  } catch (std::exception &e) {
+    this->last_err = MDICT_ERR_INTERNAL;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "resource_hash error: " << e.what());
+  }
+  return this->last_err;
+}
+
+mdict_error_t Mdict::resource_hash(const std::string &resource_name,
+                                   std::string &hex) {
+  long idx = this->find_key_index(resource_name);
+  if (idx < 0) {
+    this->last_err = MDICT_ERR_NOT_FOUND;
+    return this->last_err;
+  }
+  content_hash hash;
+  if (this->resource_hash_at(idx, hash) == MDICT_OK) {
+    hex = content_hash_hex(hash);
+  }
+  return this->last_err;
+}
+
+mdict_error_t Mdict::index_resource_hashes() {
+  try {
+    // blocks [window_first, window_first + window.size()), read with one
+    // coalesced read when the blocks are small
+    unsigned long window_first = 0;
+    std::vector<block_ptr> window;
+    for (size_t i = 0; i < this->key_list.size(); i++) {
+      if (this->content_hashes.count(i) != 0) {
+        continue;
+      }
+      unsigned long rid = 0;
+      uint64_t start = 0;
+      uint64_t end = 0;
+      this->record_range_at(i, rid, start, end);
+      // keys are in record order, each block is decoded once
+      if (rid < window_first || rid >= window_first + window.size()) {
+        std::vector<unsigned long> rids{rid};
+        uint64_t span = this->record_comp_size(rid);
+        for (unsigned long next = rid + 1; next < this->record_block_number;
+             next++) {
+          span += this->record_comp_size(next);
+          if (span > this->coalesce_read_bytes) {
+            break;
+          }
+          rids.push_back(next);
+        }
+        window = this->load_record_blocks(rids, MDICT_ACCESS_SCAN);
+        window_first = rid;
+      }
+      const block_ptr &block = window[rid - window_first];
+      if (end > block->size()) {
+        throw mdict_error(MDICT_ERR_CORRUPT,
+                          "resource past the end of record block " +
+                              std::to_string(rid));
+      }
+      content_hasher hasher;
+      hasher.update(block->data() + start, end - start);
+      this->content_hashes.emplace(i, hasher.finish());
+    }
+    this->last_err = MDICT_OK;
+  } catch (mdict_error &e) {
+    this->last_err = e.code;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "index_resource_hashes error: " << e.what());
+  } catch (std::exception &e) {
+    this->last_err = MDICT_ERR_INTERNAL;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "index_resource_hashes error: " << e.what());
+  }
+  return this->last_err;
+}
+
+std::string Mdict::lookup0(const std::string word, mdict_access_t hint) {
+  std::string edited;
+  if (this->overlay_decides(word, edited)) {
+    return edited;
+  }
+  result_cache *rcache = this->is_scan(hint) ? nullptr : this->results.get();
+  std::string cache_key;
+  if (rcache) {
+    cache_key = result_cache::make_key(result_cache::LOOKUP_EXACT, word);
+    std::string cached;
+    if (rcache->get(cache_key, cached)) {
+      this->last_err = MDICT_OK;
+      return cached;
+    }
+  }
+
   try {
 
     auto it = std::find_if(
@@ -1580,22 +2650,28 @@ std::string Mdict::lookup0(const std::string word) {
           unsigned long record_block_idx =
               reduce_record_block_offset((*it)->record_start);
           // decode recode by record index
-          auto vec = decode_record_block_by_rid(record_block_idx);
+          auto vec = decode_record_block_by_rid(record_block_idx, hint);
           // reduce the definition by word
           std::string def = reduce_particial_keys_vector(vec, word);
 
           auto treated_output = trim_nulls(def);
 
+          this->last_err = MDICT_OK;
+          if (rcache) {
+            rcache->put(cache_key, treated_output);
+          }
           return treated_output;
         }
-        return std::string("");
       }
     }
+    this->last_err = MDICT_ERR_NOT_FOUND;
     return std::string("");
-
-  
+  } catch (mdict_error &e) {
+    this->last_err = e.code;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "lookup error: " << e.what());
   } catch (std::exception &e) {
-    std::cout << "lookup error: " << e.what() << std::endl;
+    this->last_err = MDICT_ERR_INTERNAL;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "lookup error: " << e.what());
   }
   return std::string();
 }
@@ -1606,46 +2682,896 @@ std::string Mdict::lookup0(const std::string word) {
  * @param word the searching word
  * @return
  */
-std::string Mdict::lookup(const std::string word) {
+std::string Mdict::lookup(const std::string word, mdict_access_t hint) {
+  return this->find(word, hint).value();
+}
+
+result<std::string> Mdict::find(const std::string &word, mdict_access_t hint) {
+  std::string edited;
+  if (this->overlay_decides(word, edited)) {
+    if (this->last_err != MDICT_OK) {
+      return this->last_err;
+    }
+    return edited;
+  }
+  std::string pinned;
+  if (this->pinned_definition(_s(word), pinned)) {
+    this->last_err = MDICT_OK;
+    return pinned;
+  }
+  result_cache *rcache = this->is_scan(hint) ? nullptr : this->results.get();
+  std::string cache_key;
+  if (rcache) {
+    cache_key = result_cache::make_key(result_cache::LOOKUP, _s(word));
+    std::string cached;
+    if (rcache->get(cache_key, cached)) {
+      this->last_err = MDICT_OK;
+      return cached;
+    }
+  }
+
+  long key_index = -1;
+  unsigned long rid = 0;
+  uint64_t start = 0;
+  uint64_t end = 0;
+  block_ptr block;
+  mdict_error_t err = MDICT_OK;
   try {
+    if (this->key_model) {
+      // predicted position, then a few neighbouring keys
+      key_index = this->learned_find(_s(word));
+    } else {
+      // search word in key block info list
+      long idx = this->reduce_key_info_block(_s(word), 0,
+                                             this->key_block_info_list.size());
+      if (idx >= 0) {
+        // the key block goes through the block cache like the record block
+        std::vector<key_list_item *> tlist =
+            this->decode_key_block_by_block_id(idx, hint);
+        long word_id = reduce_key_info_block_items_vector(tlist, word);
+        if (word_id >= 0) {
+          key_index = static_cast<long>(
+                          this->key_block_info_list[idx]->key_list_offset) +
+                      word_id;
+        }
+        for (auto *item : tlist) {
+          delete item;
+        }
+      }
+    }
+    if (key_index < 0) {
+      err = MDICT_ERR_NOT_FOUND;
+    }
+    if (err == MDICT_OK) {
+      err = this->record_range(key_index, rid, start, end);
+    }
+    if (err == MDICT_OK) {
+      err = this->fetch_record_block(rid, hint, block);
+    }
+    if (err == MDICT_OK && end > block->size()) {
+      err = MDICT_ERR_CORRUPT;
+    }
+    if (err == MDICT_OK) {
+      std::string def = this->definition_text(block, start, end);
+      if (rcache) {
+        rcache->put(cache_key, def);
+      }
+      if (this->link_prefetch) {
+        this->prefetch_links(key_index, rid);
+      }
+      this->last_err = MDICT_OK;
+      return def;
+    }
+  } catch (mdict_error &e) {
+    err = e.code;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "find error: " << e.what());
+  } catch (std::exception &e) {
+    // the index and the text conversion don't fail on a loaded dictionary,
+    // this keeps the promise for bad_alloc and friends
+    err = MDICT_ERR_INTERNAL;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "find error: " << e.what());
+  }
+  if (err != MDICT_ERR_NOT_FOUND) {
+    MDICT_LOG(log(), MDICT_LOG_DEBUG,
+              "find " << word << ": " << mdict_strerror(err));
+  }
+  this->last_err = err;
+  return err;
+}
 
-    // search word in key block info list
-    long idx = this->reduce_key_info_block(_s(word), 0,
-                                           this->key_block_info_list.size());
-    if (idx >= 0) {
-      // decode key block by block id
-      std::vector<key_list_item *> tlist =
-          this->decode_key_block_by_block_id(idx);
-      // reduce word id from key list item vector to get the word index of key list
-      long word_id = reduce_key_info_block_items_vector(tlist, word);
-      if (word_id >= 0) {
-        // reduce search the record block index by word record start offset
-        unsigned long record_block_idx =
-            reduce_record_block_offset(tlist[word_id]->record_start);
-        // decode recode by record index
-        auto vec = decode_record_block_by_rid(record_block_idx);
-        // reduce the definition by word
-        std::string def = reduce_particial_keys_vector(vec, word);
-        return def;
+long Mdict::lookup_key_index(const std::string &word) {
+  if (this->key_model) {
+    return this->learned_find(_s(word));
+  }
+  long idx = this->reduce_key_info_block(_s(word), 0,
+                                         this->key_block_info_list.size());
+  if (idx < 0) {
+    return -1;
+  }
+  const key_block_info *info = this->key_block_info_list[idx];
+  // the keys of this block, already decoded into key_list by init()
+  std::vector<key_list_item *> tlist(
+      this->key_list.begin() + info->key_list_offset,
+      this->key_list.begin() + info->key_list_offset + info->key_list_entries);
+  long word_id = reduce_key_info_block_items_vector(tlist, word);
+  if (word_id < 0) {
+    return -1;
+  }
+  return static_cast<long>(info->key_list_offset) + word_id;
+}
+
+std::vector<std::pair<std::string, std::string>> Mdict::lookup_all(
+    const std::string &word, mdict_access_t hint) {
+  std::vector<std::pair<std::string, std::string>> entries;
+  std::string edited;
+  if (this->overlay_decides(word, edited)) {
+    // an edit replaces every entry of the headword
+    if (this->last_err == MDICT_OK) {
+      entries.emplace_back(word, edited);
+    }
+    return entries;
+  }
+  try {
+    long any = this->lookup_key_index(word);
+    if (any < 0) {
+      this->last_err = MDICT_ERR_NOT_FOUND;
+      return entries;
+    }
+    // the search stops at any equal key, widen to all of them
+    std::string normalized = _s(word);
+    size_t first = static_cast<size_t>(any);
+    size_t last = first;
+    while (first > 0 &&
+           _s(this->key_list[first - 1]->key_word) == normalized) {
+      first--;
+    }
+    while (last + 1 < this->key_list.size() &&
+           _s(this->key_list[last + 1]->key_word) == normalized) {
+      last++;
+    }
+    std::string pinned;
+    if (first == last && this->pinned_definition(normalized, pinned)) {
+      entries.emplace_back(this->key_list[first]->key_word, std::move(pinned));
+      this->last_err = MDICT_OK;
+      return entries;
+    }
+
+    std::vector<unsigned long> rids;
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    for (size_t i = first; i <= last; i++) {
+      unsigned long rid = 0;
+      uint64_t start = 0;
+      uint64_t end = 0;
+      this->record_range_at(i, rid, start, end);
+      rids.push_back(rid);
+      ranges.emplace_back(start, end);
+    }
+    std::vector<block_ptr> blocks = this->load_record_blocks(rids, hint);
+    for (size_t j = 0; j < rids.size(); j++) {
+      entries.emplace_back(
+          this->key_list[first + j]->key_word,
+          this->definition_text(blocks[j], ranges[j].first,
+                                ranges[j].second));
+    }
+    this->last_err = MDICT_OK;
+  } catch (mdict_error &e) {
+    entries.clear();
+    this->last_err = e.code;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "lookup_all error: " << e.what());
+  } catch (std::exception &e) {
+    entries.clear();
+    this->last_err = MDICT_ERR_INTERNAL;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "lookup_all error: " << e.what());
+  }
+  return entries;
+}
+
+bool Mdict::pinned_definition(const std::string &normalized,
+                              std::string &def) {
+  const char *pinned = nullptr;
+  uint64_t pinned_size = 0;
+  if (!this->hot || !this->hot->get(normalized, pinned, pinned_size)) {
+    return false;
+  }
+  def = this->definition_text(pinned, static_cast<size_t>(pinned_size));
+  return true;
+}
+
+bool Mdict::overlay_decides(const std::string &word, std::string &def) {
+  if (!this->edits) {
+    return false;
+  }
+  switch (this->edits->get(_s(word), &def)) {
+    case overlay_store::PRESENT:
+      // edited text goes through the same rewriting as the file's
+      if (this->rewriter) {
+        def = this->definition_text(def.data(), def.size());
       }
+      this->last_err = MDICT_OK;
+      return true;
+    case overlay_store::DELETED:
+      def.clear();
+      this->last_err = MDICT_ERR_NOT_FOUND;
+      return true;
+    default:
+      return false;
+  }
+}
+
+mdict_error_t Mdict::attach_overlay(const std::string &path) {
+  std::unique_ptr<overlay_store> store(new overlay_store(
+      path.empty() ? overlay_store::path_for(this->filename) : path));
+  mdict_error_t err = store->open();
+  if (err != MDICT_OK) {
+    MDICT_LOG(log(), MDICT_LOG_WARN,
+              "cannot open overlay: " << mdict_strerror(err));
+    return err;
+  }
+  this->edits = std::move(store);
+  return MDICT_OK;
+}
+
+std::vector<std::string> Mdict::suggest(const std::string word, size_t limit) {
+  std::string prefix = _s(word);
+  auto starts_with_prefix = [&](const std::string &normalized) {
+    return normalized.compare(0, prefix.size(), prefix) == 0;
+  };
+  // first key >= prefix, keys are in normalized order
+  auto it = std::partition_point(
+      this->key_list.begin(), this->key_list.end(),
+      [&](const key_list_item *item) {
+        return _s(item->key_word).compare(prefix) < 0;
+      });
+  std::vector<std::pair<std::string, std::string>> added;
+  if (this->edits) {
+    added = this->edits->prefix(prefix);
+  }
+
+  std::vector<std::string> out;
+  size_t a = 0;
+  std::string normalized;
+  bool base = it != this->key_list.end() &&
+              starts_with_prefix(normalized = _s((*it)->key_word));
+  while (out.size() < limit && (base || a < added.size())) {
+    if (a < added.size() && (!base || added[a].first <= normalized)) {
+      out.push_back(added[a++].second);
+      continue;
+    }
+    // keys edited in the overlay are listed from there, or deleted
+    if (!this->edits ||
+        this->edits->get(normalized, nullptr) == overlay_store::ABSENT) {
+      out.push_back((*it)->key_word);
     }
+    ++it;
+    base = it != this->key_list.end() &&
+           starts_with_prefix(normalized = _s((*it)->key_word));
+  }
+  return out;
+}
+
+std::vector<key_list_item> Mdict::merged_key_list() {
+  std::vector<key_list_item> out;
+  out.reserve(this->key_list.size());
+  std::vector<std::pair<std::string, std::string>> added;
+  if (this->edits) {
+    added = this->edits->prefix("");
+  }
+  size_t a = 0;
+  for (const key_list_item *item : this->key_list) {
+    if (!this->edits) {
+      out.emplace_back(item->record_start, item->key_word);
+      continue;
+    }
+    std::string normalized = _s(item->key_word);
+    while (a < added.size() && added[a].first <= normalized) {
+      out.emplace_back(MDICT_OVERLAY_RECORD_START, added[a++].second);
+    }
+    if (this->edits->get(normalized, nullptr) == overlay_store::ABSENT) {
+      out.emplace_back(item->record_start, item->key_word);
+    }
+  }
+  for (; a < added.size(); a++) {
+    out.emplace_back(MDICT_OVERLAY_RECORD_START, added[a].second);
+  }
+  return out;
+}
+
+std::string Mdict::record_text(const block_ptr &block, uint64_t start,
+                               uint64_t end) const {
+  const char *data = (const char *)block->data();
+  if (this->filetype == "MDD") {
+    return be_bin_to_utf16(data, start, end - start);
+  }
+  return be_bin_to_utf8(data, start, end - start);
+}
+
+std::string Mdict::definition_text(const block_ptr &block, uint64_t start,
+                                   uint64_t end) const {
+  if (!this->rewriter) {
+    return this->record_text(block, start, end);
+  }
+  return this->definition_text((const char *)block->data() + start,
+                               end - start);
+}
+
+std::string Mdict::definition_text(const char *data, size_t len) const {
+  std::string def;
+  if (this->rewriter) {
+    this->rewriter->rewrite(data, len, def);
+  } else {
+    def.assign(data, len);
+  }
+  return def;
+}
+
+mdict_error_t Mdict::key_at(uint64_t ordinal, std::string &key) {
+  if (ordinal >= this->key_list.size()) {
+    this->last_err = MDICT_ERR_INVALID_ARGUMENT;
+    return this->last_err;
+  }
+  key = this->key_list[ordinal]->key_word;
+  this->last_err = MDICT_OK;
+  return this->last_err;
+}
+
+mdict_error_t Mdict::entry_at(uint64_t ordinal, std::string &key,
+                              std::string &definition, mdict_access_t hint) {
+  if (ordinal >= this->key_list.size()) {
+    this->last_err = MDICT_ERR_INVALID_ARGUMENT;
+    return this->last_err;
+  }
+  try {
+    unsigned long rid = 0;
+    uint64_t start = 0;
+    uint64_t end = 0;
+    this->record_range_at(ordinal, rid, start, end);
+    block_ptr block = this->load_record_block(rid, hint);
+    key = this->key_list[ordinal]->key_word;
+    definition = this->definition_text(block, start, end);
+    this->last_err = MDICT_OK;
+  } catch (mdict_error &e) {
+    this->last_err = e.code;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "entry_at error: " << e.what());
   } catch (std::exception &e) {
-    std::cout << "lookup error: " << e.what() << std::endl;
+    this->last_err = MDICT_ERR_INTERNAL;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "entry_at error: " << e.what());
+  }
+  return this->last_err;
+}
+
+long Mdict::learned_find(const std::string &normalized) const {
+  size_t n = this->key_list.size();
+  auto less = [&](size_t i) {
+    return _s(this->key_list[i]->key_word).compare(normalized) < 0;
+  };
+  // a key of the dictionary is inside the window, including keys that
+  // share their first 8 bytes with many others; a word outside it is not
+  // in the dictionary
+  size_t lo = 0;
+  size_t hi = 0;
+  this->key_model->window(learned_index::pack(normalized), lo, hi);
+  hi = std::min(n, hi);
+  // first key >= normalized
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (less(mid)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < n && _s(this->key_list[lo]->key_word) == normalized) {
+    return static_cast<long>(lo);
+  }
+  return -1;
+}
+
+mdict_error_t Mdict::enable_learned_index(uint32_t epsilon, bool persist) {
+  std::string path = sidecar::path_for(this->filename);
+  sidecar side(this->dict_identity);
+  std::unique_ptr<learned_index> model(new learned_index());
+  if (side.load(path)) {
+    if (const std::string *section = side.section(learned_index::sidecar_tag)) {
+      section_reader r(*section);
+      if (model->deserialize(r) && model->epsilon() == epsilon &&
+          model->size() == this->key_list.size()) {
+        this->key_model = std::move(model);
+        return MDICT_OK;
+      }
+    }
+  }
+
+  // the model needs the keys in the order the searches compare them
+  std::vector<uint64_t> packed;
+  packed.reserve(this->key_list.size());
+  std::string previous;
+  for (size_t i = 0; i < this->key_list.size(); i++) {
+    std::string key = _s(this->key_list[i]->key_word);
+    if (i > 0 && previous.compare(key) > 0) {
+      MDICT_LOG(log(), MDICT_LOG_WARN,
+                "keys not in normalized order at "
+                    << i << ", learned index disabled");
+      this->key_model.reset();
+      return MDICT_ERR_UNSUPPORTED;
+    }
+    packed.push_back(learned_index::pack(key));
+    previous = std::move(key);
+  }
+  model->build(packed, epsilon);
+
+  if (persist) {
+    section_writer w;
+    model->serialize(w);
+    side.set_section(learned_index::sidecar_tag, std::move(w.data));
+    if (!side.save(path)) {
+      MDICT_LOG(log(), MDICT_LOG_WARN, "cannot write sidecar " << path);
+    }
+  }
+  this->key_model = std::move(model);
+  return MDICT_OK;
+}
+
+mdict_error_t Mdict::build_link_graph(bool persist) {
+  if (this->filetype == "MDD") {
+    return MDICT_ERR_UNSUPPORTED;
+  }
+  size_t n = this->key_list.size();
+  if (n > UINT32_MAX) {
+    return MDICT_ERR_UNSUPPORTED;
+  }
+  std::string path = sidecar::path_for(this->filename);
+  sidecar side(this->dict_identity);
+  std::unique_ptr<link_graph> loaded(new link_graph());
+  if (side.load(path)) {
+    if (const std::string *section = side.section(link_graph::sidecar_tag)) {
+      section_reader r(*section);
+      if (loaded->deserialize(r) && loaded->size() == n) {
+        this->graph = std::move(loaded);
+        return MDICT_OK;
+      }
+    }
+  }
+
+  std::vector<std::vector<uint32_t>> targets(n);
+  std::vector<std::string> words;
+  block_ptr block;
+  unsigned long loaded_rid = ULONG_MAX;
+  for (size_t i = 0; i < n; i++) {
+    unsigned long rid = 0;
+    uint64_t start = 0;
+    uint64_t end = 0;
+    mdict_error_t err = this->record_range(i, rid, start, end);
+    if (err == MDICT_OK && rid != loaded_rid) {
+      // a scan: the pass reads every block once and caches none
+      err = this->fetch_record_block(rid, MDICT_ACCESS_SCAN, block);
+      loaded_rid = rid;
+    }
+    if (err == MDICT_OK && end > block->size()) {
+      err = MDICT_ERR_CORRUPT;
+    }
+    if (err != MDICT_OK) {
+      MDICT_LOG(log(), MDICT_LOG_DEBUG,
+                "build_link_graph: entry " << i << ": " << mdict_strerror(err));
+      return err;
+    }
+    words.clear();
+    link_graph::extract(this->record_text(block, start, end), words);
+    for (const auto &word : words) {
+      long target = this->lookup_key_index(word);
+      if (target >= 0) {
+        targets[i].push_back(static_cast<uint32_t>(target));
+      }
+    }
+  }
+  std::unique_ptr<link_graph> built(new link_graph());
+  built->build(std::move(targets));
+
+  if (persist) {
+    section_writer w;
+    built->serialize(w);
+    side.set_section(link_graph::sidecar_tag, std::move(w.data));
+    if (!side.save(path)) {
+      MDICT_LOG(log(), MDICT_LOG_WARN, "cannot write sidecar " << path);
+    }
+  }
+  this->graph = std::move(built);
+  return MDICT_OK;
+}
+
+mdict_error_t Mdict::linked_keys(const std::string &word,
+                                 std::vector<std::string> &keys) {
+  keys.clear();
+  if (!this->graph) {
+    this->last_err = MDICT_ERR_UNSUPPORTED;
+    return this->last_err;
+  }
+  long key_index = this->lookup_key_index(word);
+  if (key_index < 0) {
+    this->last_err = MDICT_ERR_NOT_FOUND;
+    return this->last_err;
+  }
+  auto range = this->graph->links(static_cast<uint64_t>(key_index));
+  for (const uint32_t *t = range.first; t != range.second; ++t) {
+    keys.push_back(this->key_list[*t]->key_word);
+  }
+  this->last_err = MDICT_OK;
+  return this->last_err;
+}
+
+mdict_error_t Mdict::set_link_rewriter(const link_rewriter &rewriter) {
+  if (this->filetype == "MDD") {
+    return MDICT_ERR_UNSUPPORTED;
+  }
+  if (rewriter.empty()) {
+    this->rewriter.reset();
+  } else {
+    this->rewriter.reset(new link_rewriter(rewriter));
+  }
+  if (this->results) {
+    this->results->clear();
+  }
+  return MDICT_OK;
+}
+
+mdict_error_t Mdict::set_link_prefetch(bool enabled) {
+  if (enabled && (!this->graph || !this->prefetch)) {
+    return MDICT_ERR_UNSUPPORTED;
+  }
+  this->link_prefetch = enabled;
+  return MDICT_OK;
+}
+
+void Mdict::prefetch_links(uint64_t key_index, unsigned long rid) {
+  std::shared_ptr<block_cache> cache = this->blocks;
+  if (!this->prefetch || !this->graph || !cache) {
+    return;
+  }
+  auto range = this->graph->links(key_index);
+  size_t queued = 0;
+  // the queue keeps the newest guesses, don't push out the first links
+  for (const uint32_t *t = range.first;
+       t != range.second && queued < MDICT_PREFETCH_QUEUE; ++t) {
+    unsigned long target_rid = 0;
+    uint64_t start = 0;
+    uint64_t end = 0;
+    if (this->record_range(*t, target_rid, start, end) != MDICT_OK ||
+        target_rid == rid) {
+      continue;
+    }
+    block_key bk{this->cache_id, RECORD_BLOCK, target_rid};
+    if (cache->contains(bk)) {
+      continue;
+    }
+    this->prefetch->submit(bk, cache);
+    queued++;
   }
-  return std::string();
+}
+
+std::vector<std::string> Mdict::lookup_batch(
+    const std::vector<std::string> &words, mdict_access_t hint) {
+  result_cache *rcache = this->is_scan(hint) ? nullptr : this->results.get();
+  std::vector<std::string> defs(words.size());
+  mdict_error_t first_err = MDICT_OK;
+
+  // resolve every word from the index, then load the blocks in one pass
+  struct pending {
+    size_t word;
+    uint64_t start;
+    uint64_t end;
+  };
+  std::vector<pending> todo;
+  std::vector<unsigned long> rids;
+  for (size_t i = 0; i < words.size(); i++) {
+    if (this->overlay_decides(words[i], defs[i])) {
+      if (this->last_err != MDICT_OK && first_err == MDICT_OK) {
+        first_err = this->last_err;
+      }
+      continue;
+    }
+    if (this->pinned_definition(_s(words[i]), defs[i])) {
+      continue;
+    }
+    if (rcache && rcache->get(result_cache::make_key(result_cache::LOOKUP,
+                                                     _s(words[i])),
+                              defs[i])) {
+      continue;
+    }
+    try {
+      long key_index = this->lookup_key_index(words[i]);
+      if (key_index < 0) {
+        if (first_err == MDICT_OK) {
+          first_err = MDICT_ERR_NOT_FOUND;
+        }
+        continue;
+      }
+      unsigned long rid = 0;
+      uint64_t start = 0;
+      uint64_t end = 0;
+      this->record_range_at(key_index, rid, start, end);
+      todo.push_back(pending{i, start, end});
+      rids.push_back(rid);
+    } catch (mdict_error &e) {
+      if (first_err == MDICT_OK) {
+        first_err = e.code;
+      }
+      MDICT_LOG(log(), MDICT_LOG_DEBUG, "lookup_batch error: " << e.what());
+    }
+  }
+
+  // a bad block only fails the words whose definitions are in it
+  std::vector<mdict_error_t> errs;
+  std::vector<block_ptr> loaded = this->load_record_blocks(rids, hint, &errs);
+  for (size_t j = 0; j < todo.size(); j++) {
+    const pending &p = todo[j];
+    mdict_error_t err = errs[j];
+    if (err == MDICT_OK && p.end > loaded[j]->size()) {
+      err = MDICT_ERR_CORRUPT;
+    }
+    if (err != MDICT_OK) {
+      if (first_err == MDICT_OK) {
+        first_err = err;
+      }
+      continue;
+    }
+    std::string &def = defs[p.word];
+    def = this->definition_text(loaded[j], p.start, p.end);
+    if (rcache) {
+      rcache->put(result_cache::make_key(result_cache::LOOKUP,
+                                         _s(words[p.word])),
+                  def);
+    }
+  }
+  this->last_err = first_err;
+  return defs;
 }
 
 std::string Mdict::parse_definition(const std::string word,
-                                    unsigned long record_start) {
+                                    uint64_t record_start,
+                                    mdict_access_t hint) {
+  std::string edited;
+  if (this->overlay_decides(word, edited)) {
+    return edited;
+  }
   // reduce search the record block index by word record start offset
   unsigned long record_block_idx = reduce_record_block_offset(record_start);
   // decode recode by record index
-  auto vec = decode_record_block_by_rid(record_block_idx);
+  auto vec = decode_record_block_by_rid(record_block_idx, hint);
   // reduce the definition by word
   std::string def = reduce_particial_keys_vector(vec, word);
   return def;
 }
 
+void Mdict::set_result_cache(uint64_t capacity_bytes,
+                             mdict_cache_policy_t policy) {
+  if (capacity_bytes == 0) {
+    this->results.reset();
+    return;
+  }
+  this->results.reset(new result_cache(capacity_bytes, policy));
+  this->results->bind(this->dict_identity);
+}
+
+mdict_cache_stats_t Mdict::result_cache_stats() {
+  if (!this->results) {
+    return mdict_cache_stats_t{};
+  }
+  return this->results->stats();
+}
+
+mdict_error_t Mdict::load_hot_set(const std::vector<std::string> &words,
+                                  uint64_t capacity_bytes) {
+  struct hot_pick {
+    std::string normalized;
+    unsigned long rid;
+    uint64_t start;
+    uint64_t end;
+  };
+  std::unique_ptr<hot_table> table(new hot_table(capacity_bytes));
+  std::vector<hot_pick> picks;
+  uint64_t planned = 0;
+  uint64_t arena_bytes = 0;
+  std::unordered_set<std::string> seen;
+  try {
+    for (const auto &word : words) {
+      std::string normalized = _s(word);
+      if (!seen.insert(normalized).second) {
+        continue;
+      }
+      long key_index = this->lookup_key_index(word);
+      hot_pick p{normalized, 0, 0, 0};
+      if (key_index < 0 ||
+          this->record_range(key_index, p.rid, p.start, p.end) != MDICT_OK) {
+        continue;
+      }
+      uint64_t cost = hot_table::charge(normalized, p.end - p.start);
+      if (planned + cost > capacity_bytes) {
+        continue;
+      }
+      planned += cost;
+      arena_bytes += p.end - p.start;
+      picks.push_back(std::move(p));
+    }
+
+    // each record block is read once, in file order
+    std::stable_sort(picks.begin(), picks.end(),
+                     [](const hot_pick &a, const hot_pick &b) {
+                       return a.rid < b.rid;
+                     });
+    table->reserve(picks.size(), arena_bytes);
+    block_ptr block;
+    unsigned long loaded = ULONG_MAX;
+    for (const auto &p : picks) {
+      if (p.rid != loaded) {
+        mdict_error_t err =
+            this->fetch_record_block(p.rid, MDICT_ACCESS_SCAN, block);
+        if (err != MDICT_OK) {
+          this->last_err = err;
+          return err;
+        }
+        loaded = p.rid;
+      }
+      if (p.end > block->size()) {
+        this->last_err = MDICT_ERR_CORRUPT;
+        return this->last_err;
+      }
+      table->add(p.normalized, this->record_text(block, p.start, p.end));
+    }
+  } catch (mdict_error &e) {
+    this->last_err = e.code;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "load_hot_set error: " << e.what());
+    return this->last_err;
+  } catch (std::exception &e) {
+    this->last_err = MDICT_ERR_INTERNAL;
+    MDICT_LOG(log(), MDICT_LOG_DEBUG, "load_hot_set error: " << e.what());
+    return this->last_err;
+  }
+  this->hot = std::move(table);
+  this->last_err = MDICT_OK;
+  return this->last_err;
+}
+
+mdict_error_t Mdict::load_hot_list(const std::string &path,
+                                   uint64_t capacity_bytes) {
+  std::vector<std::string> words;
+  mdict_error_t err = hot_table::read_list(path, words);
+  if (err != MDICT_OK) {
+    this->last_err = err;
+    return err;
+  }
+  return this->load_hot_set(words, capacity_bytes);
+}
+
+mdict_error_t Mdict::save_hot_list(const std::string &path, size_t limit) {
+  if (!this->results) {
+    return MDICT_ERR_UNSUPPORTED;
+  }
+  std::ofstream out(path, std::ios::trunc);
+  for (const auto &word : this->results->queries(result_cache::LOOKUP, limit)) {
+    out << word << '\n';
+  }
+  out.flush();
+  return out ? MDICT_OK : MDICT_ERR_IO;
+}
+
+mdict_error_t Mdict::enable_prefetch(bool enabled) {
+  this->prefetch.reset();
+  if (!enabled) {
+    return MDICT_OK;
+  }
+  if (!this->blocks) {
+    return MDICT_ERR_UNSUPPORTED;
+  }
+  // only reads what init() left immutable, the worker runs concurrently
+  // with the reader
+  auto load = [this](std::ifstream &in, const block_key &key,
+                     block_ptr &out) -> mdict_error_t {
+    uint64_t offset = 0;
+    uint64_t comp_size = 0;
+    if (key.kind == KEY_BLOCK) {
+      const key_block_info *info = this->key_block_info_list[key.block_id];
+      offset = this->key_block_compressed_start_offset +
+               info->key_block_comp_accumulator;
+      comp_size = info->key_block_comp_size;
+    } else {
+      offset = this->record_block_offset +
+               this->record_comp_offsets[key.block_id];
+      comp_size = this->record_comp_size(key.block_id);
+    }
+    std::vector<char> buffer(comp_size);
+    in.seekg(static_cast<std::streamoff>(offset));
+    in.read(buffer.data(), static_cast<std::streamsize>(comp_size));
+    if (!in) {
+      in.clear();
+      return MDICT_ERR_IO;
+    }
+    if (key.kind == KEY_BLOCK) {
+      std::shared_ptr<std::vector<uint8_t>> block;
+      mdict_error_t err = decode_block(
+          buffer.data(), comp_size,
+          this->key_block_info_list[key.block_id]->key_block_decomp_size,
+          block);
+      out = std::move(block);
+      return err;
+    }
+    return this->decode_record_data(key.block_id, buffer.data(), out);
+  };
+  std::unique_ptr<prefetcher> p(new prefetcher(this->filename, load));
+  if (!p->ok()) {
+    return MDICT_ERR_IO;
+  }
+  this->prefetch = std::move(p);
+  return MDICT_OK;
+}
+
+void Mdict::note_block_access(uint8_t kind, uint64_t block_id) {
+  int direction = this->prefetch->observe(kind, block_id);
+  uint64_t count = kind == KEY_BLOCK ? this->key_block_info_list.size()
+                                     : this->record_block_number;
+  if (direction == 0 || (direction < 0 && block_id == 0) ||
+      (direction > 0 && block_id + 1 >= count)) {
+    return;
+  }
+  std::shared_ptr<block_cache> cache = this->blocks;
+  block_key next{this->cache_id, kind, block_id + direction};
+  if (!cache || cache->contains(next)) {
+    return;
+  }
+  this->prefetch->submit(next, std::move(cache));
+}
+
+mdict_cache_stats_t Mdict::hot_set_stats() const {
+  if (!this->hot) {
+    return mdict_cache_stats_t{};
+  }
+  return this->hot->stats();
+}
+
+void Mdict::set_block_cache(uint64_t capacity_bytes,
+                            mdict_cache_policy_t policy,
+                            unsigned int warm_percent) {
+  this->release_block_cache();
+  if (capacity_bytes == 0) {
+    this->blocks.reset();
+    return;
+  }
+  this->blocks = block_cache::with_budget(capacity_bytes, policy, warm_percent);
+}
+
+void Mdict::set_block_cache(std::shared_ptr<block_cache> cache) {
+  if (cache != this->blocks) {
+    this->release_block_cache();
+  }
+  this->blocks = std::move(cache);
+}
+
+void Mdict::release_block_cache() {
+  // a cache nobody else holds goes away with this dictionary anyway
+  if (!this->blocks || this->blocks.use_count() == 1) {
+    return;
+  }
+  this->blocks->reserve(this->cache_id, 0);
+  this->blocks->erase_dict(this->cache_id);
+}
+
+mdict_cache_stats_t Mdict::block_cache_stats() {
+  if (!this->blocks) {
+    return mdict_cache_stats_t{};
+  }
+  return this->blocks->stats();
+}
+
+void Mdict::use_shared_block_cache(uint64_t reserved_bytes) {
+  this->set_block_cache(block_cache::shared());
+  this->blocks->reserve(this->cache_id, reserved_bytes);
+}
+
+mdict_cache_stats_t Mdict::block_cache_dict_stats() {
+  if (!this->blocks) {
+    return mdict_cache_stats_t{};
+  }
+  return this->blocks->dict_stats(this->cache_id);
+}
+
 /**
  * look the file by word
  * @param word the searching word
@@ -1653,6 +3579,30 @@ std::string Mdict::parse_definition(const std::string word,
  */
 std::vector<key_list_item *> Mdict::keyList() { return this->key_list; }
 
+std::vector<block_ref> Mdict::resolve_blocks(const std::string &word) {
+  std::vector<block_ref> refs;
+  long idx = this->reduce_key_info_block(_s(word), 0,
+                                         this->key_block_info_list.size());
+  if (idx < 0) {
+    return refs;
+  }
+  const key_block_info *info = this->key_block_info_list[idx];
+  // lookup reads the key block before it knows whether the word is there
+  refs.push_back(block_ref{KEY_BLOCK, static_cast<unsigned long>(idx),
+                           info->key_block_decomp_size});
+  // the keys of this block, already decoded into key_list by init()
+  std::vector<key_list_item *> tlist(
+      this->key_list.begin() + info->key_list_offset,
+      this->key_list.begin() + info->key_list_offset + info->key_list_entries);
+  long word_id = reduce_key_info_block_items_vector(tlist, word);
+  if (word_id < 0) {
+    return refs;
+  }
+  unsigned long rid = reduce_record_block_offset(tlist[word_id]->record_start);
+  refs.push_back(block_ref{RECORD_BLOCK, rid, this->record_decomp_size(rid)});
+  return refs;
+}
+
 bool Mdict::endsWith(std::string const &fullString, std::string const &ending) {
   if (fullString.length() >= ending.length()) {
     return (0 == fullString.compare(fullString.length() - ending.length(),
@@ -17,6 +17,7 @@
 #include <cstring>
 #include <type_traits>
 #include "include/mdict.h"
+#include "include/resource_set.h"
 
 /**
   实现 mdict_extern.h中的方法
@@ -65,10 +66,38 @@ extern "C" {
  init the dictionary
  */
 void *mdict_init(const char *dictionary_path) {
-  std::string dict_file_path(dictionary_path);
-  auto *mydict = new mdict::Mdict(dict_file_path);
-  mydict->init();
-  return mydict;
+  void *dict = nullptr;
+  mdict_init_ex(dictionary_path, &dict);
+  return dict;
+}
+
+mdict_error_t mdict_init_ex(const char *dictionary_path, void **dict) {
+  return mdict_init_with_options(dictionary_path, nullptr, dict);
+}
+
+void mdict_open_options_init(mdict_open_options_t *options) {
+  if (options == nullptr) {
+    return;
+  }
+  options->index_window_bytes = MDICT_INDEX_WINDOW_BYTES;
+}
+
+mdict_error_t mdict_init_with_options(const char *dictionary_path,
+                                      const mdict_open_options_t *options,
+                                      void **dict) {
+  if (dict == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  *dict = nullptr;
+  if (dictionary_path == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  mdict_open_options_t defaults;
+  mdict_open_options_init(&defaults);
+  auto opened = mdict::Mdict::open(std::string(dictionary_path),
+                                   options ? *options : defaults);
+  *dict = opened ? opened.value().release() : nullptr;
+  return opened.error();
 }
 
 /**
@@ -88,13 +117,75 @@ void mdict_lookup(void *dict, const char *word, char **result) {
     // Allocate result buffer once, copy vector content
     *result = (char*)malloc(buf.size());
     if (!*result) {
-        perror("malloc");
+        mdict::log_printf(MDICT_LOG_ERROR, "malloc failed");
         return;
     }
     memcpy(*result, buf.data(), buf.size());
 }
 
 
+// malloc'ed, null terminated copy of a string
+static char *copy_string(const std::string &s) {
+  char *p = (char *)malloc(s.size() + 1);
+  if (!p) {
+    mdict::log_printf(MDICT_LOG_ERROR, "malloc failed");
+    return nullptr;
+  }
+  memcpy(p, s.c_str(), s.size() + 1);
+  return p;
+}
+
+mdict_error_t mdict_lookup_ex(void *dict, const char *word, char **result) {
+  auto *self = (mdict::Mdict *)dict;
+  auto def = self->find(std::string(word));
+  *result = def ? copy_string(*def) : nullptr;
+  return def.error();
+}
+
+void mdict_lookup_batch(void *dict, const char **words, size_t count,
+                        char **results) {
+  auto *self = (mdict::Mdict *)dict;
+  std::vector<std::string> batch(words, words + count);
+  std::vector<std::string> defs = self->lookup_batch(batch);
+  for (size_t i = 0; i < count; i++) {
+    results[i] = copy_string(defs[i]);
+  }
+}
+
+mdict_error_t mdict_lookup_all(void *dict, const char *word,
+                               char ***definitions, uint64_t *count) {
+  if (dict == nullptr || word == nullptr || definitions == nullptr ||
+      count == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  auto entries = self->lookup_all(word);
+  *definitions = nullptr;
+  *count = 0;
+  if (!entries.empty()) {
+    *definitions = (char **)calloc(entries.size(), sizeof(char *));
+    if (!*definitions) {
+      mdict::log_printf(MDICT_LOG_ERROR, "malloc failed");
+      return MDICT_ERR_INTERNAL;
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+      (*definitions)[i] = copy_string(entries[i].second);
+    }
+    *count = entries.size();
+  }
+  return self->last_error();
+}
+
+void mdict_free_strings(char **strings, uint64_t count) {
+  if (strings == nullptr) {
+    return;
+  }
+  for (uint64_t i = 0; i < count; i++) {
+    free(strings[i]);
+  }
+  free(strings);
+}
+
 /**
  locate a word
  */
@@ -109,15 +200,23 @@ void mdict_locate(void *dict, const char *word, char **result, mdict_encoding_t
 
     *result = (char*)malloc(buf.size());
     if (!*result) {
-        perror("malloc");
+        mdict::log_printf(MDICT_LOG_ERROR, "malloc failed");
         return;
     }
     memcpy(*result, buf.data(), buf.size());
 }
 
+mdict_error_t mdict_locate_ex(void *dict, const char *name, char **result,
+                              mdict_encoding_t encoding) {
+  auto *self = (mdict::Mdict *)dict;
+  auto resource = self->find_resource(std::string(name), encoding);
+  *result = resource ? copy_string(*resource) : nullptr;
+  return resource.error();
+}
+
 
 void mdict_parse_definition(void *dict, const char *word,
-                            unsigned long record_start, char **result) {
+                            uint64_t record_start, char **result) {
   auto *self = (mdict::Mdict *)dict;
   std::string queryWord(word);
   std::string s = self->parse_definition(queryWord, record_start);
@@ -127,10 +226,45 @@ void mdict_parse_definition(void *dict, const char *word,
   (*result)[s.size()] = '\0';
 }
 
+uint64_t mdict_entry_count(void *dict) {
+  auto *self = (mdict::Mdict *)dict;
+  return self->entry_count();
+}
+
+mdict_error_t mdict_key_at(void *dict, uint64_t ordinal, char **key) {
+  if (dict == nullptr || key == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  std::string k;
+  mdict_error_t err = self->key_at(ordinal, k);
+  *key = err == MDICT_OK ? copy_string(k) : nullptr;
+  return err;
+}
+
+mdict_error_t mdict_entry_at(void *dict, uint64_t ordinal, char **key,
+                             char **definition) {
+  if (dict == nullptr || key == nullptr || definition == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  std::string k;
+  std::string def;
+  mdict_error_t err = self->entry_at(ordinal, k, def);
+  *key = err == MDICT_OK ? copy_string(k) : nullptr;
+  *definition = err == MDICT_OK ? copy_string(def) : nullptr;
+  return err;
+}
+
 simple_key_item **mdict_keylist(void *dict, uint64_t *len) {
     auto *self = reinterpret_cast<mdict::Mdict*>(dict);
     auto keylist = self->keyList();              // copy of whatever keyList() returns
-    const std::size_t n = keylist.size();
+    // with an overlay attached, its edits are merged into the list
+    std::vector<mdict::key_list_item> merged;
+    if (self->overlay()) {
+      merged = self->merged_key_list();
+    }
+    const std::size_t n = self->overlay() ? merged.size() : keylist.size();
     *len = static_cast<uint64_t>(n);
 
     // allocate array of pointers (new T[0] is fine in C++).
@@ -203,7 +337,7 @@ simple_key_item **mdict_keylist(void *dict, uint64_t *len) {
     constexpr bool elem_is_ptr = std::is_pointer_v<Elem>;
 
     for (std::size_t i = 0; i < n; ++i) {
-      items[i] = make_item(keylist[i]); 
+      items[i] = self->overlay() ? make_item(&merged[i]) : make_item(keylist[i]);
 }
 
 
@@ -238,7 +372,48 @@ int mdict_filetype(void *dict) {
 suggest  a word
 */
 void mdict_suggest(void *dict, char *word, char **suggested_words, int length) {
+  if (dict == nullptr || word == nullptr || suggested_words == nullptr ||
+      length <= 0) {
+    return;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  std::vector<std::string> words =
+      self->suggest(word, static_cast<size_t>(length));
+  for (int i = 0; i < length; i++) {
+    suggested_words[i] =
+        size_t(i) < words.size() ? copy_string(words[i]) : nullptr;
+  }
+}
+
+mdict_error_t mdict_overlay_attach(void *dict, const char *path) {
+  if (dict == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  return self->attach_overlay(path ? path : "");
+}
 
+mdict_error_t mdict_overlay_put(void *dict, const char *key,
+                                const char *definition) {
+  if (dict == nullptr || key == nullptr || definition == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  if (!self->overlay()) {
+    return MDICT_ERR_UNSUPPORTED;
+  }
+  return self->overlay()->put(key, definition);
+}
+
+mdict_error_t mdict_overlay_remove(void *dict, const char *key) {
+  if (dict == nullptr || key == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  if (!self->overlay()) {
+    return MDICT_ERR_UNSUPPORTED;
+  }
+  return self->overlay()->remove(key);
 }
 
 /**
@@ -253,6 +428,466 @@ int mdict_destroy(void *dict) {
 }
 
 
+void mdict_set_result_cache(void *dict, uint64_t capacity_bytes,
+                            mdict_cache_policy_t policy) {
+  auto *self = (mdict::Mdict *)dict;
+  self->set_result_cache(capacity_bytes, policy);
+}
+
+void mdict_result_cache_stats(void *dict, mdict_cache_stats_t *stats) {
+  auto *self = (mdict::Mdict *)dict;
+  *stats = self->result_cache_stats();
+}
+
+mdict_error_t mdict_load_hot_list(void *dict, const char *path,
+                                  uint64_t capacity_bytes) {
+  auto *self = (mdict::Mdict *)dict;
+  return self->load_hot_list(std::string(path), capacity_bytes);
+}
+
+mdict_error_t mdict_save_hot_list(void *dict, const char *path,
+                                  uint64_t limit) {
+  auto *self = (mdict::Mdict *)dict;
+  return self->save_hot_list(std::string(path), static_cast<size_t>(limit));
+}
+
+void mdict_hot_set_stats(void *dict, mdict_cache_stats_t *stats) {
+  auto *self = (mdict::Mdict *)dict;
+  *stats = self->hot_set_stats();
+}
+
+void mdict_set_block_cache(void *dict, uint64_t capacity_bytes,
+                           mdict_cache_policy_t policy,
+                           unsigned int warm_percent) {
+  auto *self = (mdict::Mdict *)dict;
+  self->set_block_cache(capacity_bytes, policy, warm_percent);
+}
+
+void mdict_block_cache_stats(void *dict, mdict_cache_stats_t *stats) {
+  auto *self = (mdict::Mdict *)dict;
+  *stats = self->block_cache_stats();
+}
+
+void mdict_set_shared_block_cache(uint64_t capacity_bytes,
+                                  mdict_cache_policy_t policy,
+                                  unsigned int warm_percent) {
+  mdict::block_cache::configure_shared(capacity_bytes, policy, warm_percent);
+}
+
+void mdict_use_shared_block_cache(void *dict, uint64_t reserved_bytes) {
+  auto *self = (mdict::Mdict *)dict;
+  self->use_shared_block_cache(reserved_bytes);
+}
+
+void mdict_block_cache_dict_stats(void *dict, mdict_cache_stats_t *stats) {
+  auto *self = (mdict::Mdict *)dict;
+  *stats = self->block_cache_dict_stats();
+}
+
+void mdict_shared_block_cache_stats(mdict_cache_stats_t *stats) {
+  *stats = mdict::block_cache::shared()->stats();
+}
+
+void mdict_set_read_coalescing(void *dict, uint64_t max_gap_bytes,
+                               uint64_t max_read_bytes) {
+  auto *self = (mdict::Mdict *)dict;
+  self->set_read_coalescing(max_gap_bytes, max_read_bytes);
+}
+
+mdict_error_t mdict_set_prefetch(void *dict, int enabled) {
+  auto *self = (mdict::Mdict *)dict;
+  return self->enable_prefetch(enabled != 0);
+}
+
+void mdict_prefetch_stats(void *dict, mdict_prefetch_stats_t *stats) {
+  auto *self = (mdict::Mdict *)dict;
+  *stats = self->prefetch_stats();
+}
+
+mdict_error_t mdict_build_link_graph(void *dict) {
+  auto *self = (mdict::Mdict *)dict;
+  return self->build_link_graph();
+}
+
+mdict_error_t mdict_linked_keys(void *dict, const char *word, char ***keys,
+                                uint64_t *count) {
+  if (dict == nullptr || word == nullptr || keys == nullptr ||
+      count == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  std::vector<std::string> linked;
+  mdict_error_t err = self->linked_keys(word, linked);
+  *keys = nullptr;
+  *count = 0;
+  if (!linked.empty()) {
+    *keys = (char **)calloc(linked.size(), sizeof(char *));
+    if (!*keys) {
+      mdict::log_printf(MDICT_LOG_ERROR, "malloc failed");
+      return MDICT_ERR_INTERNAL;
+    }
+    for (size_t i = 0; i < linked.size(); i++) {
+      (*keys)[i] = copy_string(linked[i]);
+    }
+    *count = linked.size();
+  }
+  return err;
+}
+
+mdict_error_t mdict_set_link_prefetch(void *dict, int enabled) {
+  auto *self = (mdict::Mdict *)dict;
+  return self->set_link_prefetch(enabled != 0);
+}
+
+mdict_error_t mdict_set_link_prefix(void *dict, mdict_link_kind_t kind,
+                                    const char *prefix) {
+  if (dict == nullptr || kind < MDICT_LINK_ENTRY || kind > MDICT_LINK_RESOURCE) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  mdict::link_rewriter rewriter;
+  if (self->link_rewriting()) {
+    rewriter = *self->link_rewriting();
+  }
+  if (prefix) {
+    rewriter.set_prefix(kind, prefix);
+  } else {
+    rewriter.clear_prefix(kind);
+  }
+  return self->set_link_rewriter(rewriter);
+}
+
+void mdict_io_stats(void *dict, mdict_io_stats_t *stats) {
+  auto *self = (mdict::Mdict *)dict;
+  *stats = self->io_stats();
+}
+
+mdict_error_t mdict_enable_learned_index(void *dict, unsigned int epsilon) {
+  if (dict == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  return self->enable_learned_index(
+      epsilon == 0 ? MDICT_LEARNED_INDEX_EPSILON : epsilon);
+}
+
+void mdict_set_access_hint(void *dict, mdict_access_t hint) {
+  auto *self = (mdict::Mdict *)dict;
+  self->set_access_hint(hint);
+}
+
+mdict_error_t mdict_locate_stream(void *dict, const char *name,
+                                  mdict_write_callback_t callback,
+                                  void *user_data) {
+  if (dict == nullptr || name == nullptr || callback == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  return self->locate_stream(
+      name, [callback, user_data](const uint8_t *data, size_t len) {
+        return callback(data, len, user_data) == 0;
+      });
+}
+
+mdict_error_t mdict_locate_to_fd(void *dict, const char *name, int fd) {
+  if (dict == nullptr || name == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  return self->locate_to(name, fd);
+}
+
+mdict_error_t mdict_locate_range(void *dict, const char *name, uint64_t offset,
+                                 uint64_t length,
+                                 mdict_write_callback_t callback,
+                                 void *user_data, uint64_t *resource_size) {
+  if (dict == nullptr || name == nullptr || callback == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  return self->locate_range(
+      name, offset, length,
+      [callback, user_data](const uint8_t *data, size_t len) {
+        return callback(data, len, user_data) == 0;
+      },
+      resource_size);
+}
+
+mdict_error_t mdict_resource_hash(void *dict, const char *name, char *hex) {
+  if (dict == nullptr || name == nullptr || hex == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  std::string s;
+  mdict_error_t err = self->resource_hash(name, s);
+  memcpy(hex, s.c_str(), s.size() + 1);
+  return err;
+}
+
+mdict_error_t mdict_index_resource_hashes(void *dict) {
+  if (dict == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  return self->index_resource_hashes();
+}
+
+void mdict_set_content_store(uint64_t capacity_bytes) {
+  mdict::content_store::global().set_capacity(capacity_bytes);
+}
+
+void mdict_content_store_stats(mdict_cache_stats_t *stats) {
+  *stats = mdict::content_store::global().stats();
+}
+
+mdict_error_t mdict_resource_names(const char *definition, char ***names,
+                                   uint64_t *count) {
+  if (definition == nullptr || names == nullptr || count == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  std::vector<std::string> found = mdict::Mdict::resource_names(definition);
+  *names = nullptr;
+  *count = 0;
+  if (!found.empty()) {
+    *names = (char **)calloc(found.size(), sizeof(char *));
+    if (!*names) {
+      mdict::log_printf(MDICT_LOG_ERROR, "malloc failed");
+      return MDICT_ERR_INTERNAL;
+    }
+    for (size_t i = 0; i < found.size(); i++) {
+      (*names)[i] = copy_string(found[i]);
+    }
+    *count = found.size();
+  }
+  return MDICT_OK;
+}
+
+/**
+ copy batch payloads to a malloc'ed array of mdict_resource_t
+ */
+static mdict_error_t copy_resources(
+    const std::vector<mdict::resource_payload> &payloads,
+    mdict_resource_t **resources) {
+  *resources = nullptr;
+  if (payloads.empty()) {
+    return MDICT_OK;
+  }
+  *resources =
+      (mdict_resource_t *)calloc(payloads.size(), sizeof(mdict_resource_t));
+  if (!*resources) {
+    mdict::log_printf(MDICT_LOG_ERROR, "malloc failed");
+    return MDICT_ERR_INTERNAL;
+  }
+  for (size_t i = 0; i < payloads.size(); i++) {
+    mdict_resource_t &r = (*resources)[i];
+    r.name = copy_string(payloads[i].name);
+    r.error = payloads[i].err;
+    if (r.error != MDICT_OK) {
+      continue;
+    }
+    // never NULL for a resource which was found, even if it is empty
+    r.data = (uint8_t *)malloc(payloads[i].data.size() + 1);
+    if (!r.data) {
+      mdict::log_printf(MDICT_LOG_ERROR, "malloc failed");
+      r.error = MDICT_ERR_INTERNAL;
+      continue;
+    }
+    memcpy(r.data, payloads[i].data.data(), payloads[i].data.size());
+    r.size = payloads[i].data.size();
+  }
+  return MDICT_OK;
+}
+
+mdict_error_t mdict_locate_batch(void *dict, const char **names, size_t count,
+                                 mdict_resource_t **resources) {
+  if (dict == nullptr || (names == nullptr && count > 0) ||
+      resources == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  std::vector<std::string> batch(names, names + count);
+  std::vector<mdict::resource_payload> payloads;
+  mdict_error_t err = self->locate_batch(batch, payloads);
+  mdict_error_t copied = copy_resources(payloads, resources);
+  return copied != MDICT_OK ? copied : err;
+}
+
+void mdict_free_resources(mdict_resource_t *resources, uint64_t count) {
+  if (resources == nullptr) {
+    return;
+  }
+  for (uint64_t i = 0; i < count; i++) {
+    free(resources[i].name);
+    free(resources[i].data);
+  }
+  free(resources);
+}
+
+void *mdict_resource_set_open(const char *dictionary_path) {
+  if (dictionary_path == nullptr) {
+    return nullptr;
+  }
+  auto *set = new mdict::resource_set(dictionary_path);
+  if (set->volume_count() == 0) {
+    delete set;
+    return nullptr;
+  }
+  return set;
+}
+
+mdict_error_t mdict_resource_set_volumes(void *set, int *count) {
+  if (set == nullptr || count == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::resource_set *)set;
+  *count = static_cast<int>(self->volume_count());
+  return MDICT_OK;
+}
+
+mdict_error_t mdict_resource_set_locate(void *set, const char *name,
+                                        char **result,
+                                        mdict_encoding_t encoding) {
+  if (result == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  *result = nullptr;
+  if (set == nullptr || name == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::resource_set *)set;
+  std::string s = self->locate(name, encoding);
+
+  (*result) = (char *)calloc(sizeof(char), s.size() + 1);
+  if (*result == nullptr) {
+    return MDICT_ERR_INTERNAL;
+  }
+  std::copy(s.begin(), s.end(), (*result));
+  (*result)[s.size()] = '\0';
+  return self->last_error();
+}
+
+mdict_error_t mdict_resource_set_locate_stream(void *set, const char *name,
+                                               mdict_write_callback_t callback,
+                                               void *user_data) {
+  if (set == nullptr || name == nullptr || callback == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::resource_set *)set;
+  return self->locate_stream(
+      name, [callback, user_data](const uint8_t *data, size_t len) {
+        return callback(data, len, user_data) == 0;
+      });
+}
+
+mdict_error_t mdict_resource_set_locate_range(void *set, const char *name,
+                                              uint64_t offset, uint64_t length,
+                                              mdict_write_callback_t callback,
+                                              void *user_data,
+                                              uint64_t *resource_size) {
+  if (set == nullptr || name == nullptr || callback == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::resource_set *)set;
+  return self->locate_range(
+      name, offset, length,
+      [callback, user_data](const uint8_t *data, size_t len) {
+        return callback(data, len, user_data) == 0;
+      },
+      resource_size);
+}
+
+mdict_error_t mdict_resource_set_hash(void *set, const char *name, char *hex) {
+  if (set == nullptr || name == nullptr || hex == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::resource_set *)set;
+  std::string s;
+  mdict_error_t err = self->resource_hash(name, s);
+  memcpy(hex, s.c_str(), s.size() + 1);
+  return err;
+}
+
+mdict_error_t mdict_resource_set_locate_batch(void *set, const char **names,
+                                              size_t count,
+                                              mdict_resource_t **resources) {
+  if (set == nullptr || (names == nullptr && count > 0) ||
+      resources == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::resource_set *)set;
+  std::vector<std::string> batch(names, names + count);
+  std::vector<mdict::resource_payload> payloads;
+  mdict_error_t err = self->locate_batch(batch, payloads);
+  mdict_error_t copied = copy_resources(payloads, resources);
+  return copied != MDICT_OK ? copied : err;
+}
+
+mdict_error_t mdict_resource_set_last_error(void *set) {
+  if (set == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  return ((mdict::resource_set *)set)->last_error();
+}
+
+void mdict_resource_set_close(void *set) {
+  delete (mdict::resource_set *)set;
+}
+
+mdict_error_t mdict_last_error(void *dict) {
+  if (dict == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  return self->last_error();
+}
+
+const char *mdict_strerror(mdict_error_t err) {
+  switch (err) {
+    case MDICT_OK:
+      return "success";
+    case MDICT_ERR_NOT_FOUND:
+      return "not found";
+    case MDICT_ERR_IO:
+      return "i/o error";
+    case MDICT_ERR_DECOMPRESS:
+      return "decompression failed";
+    case MDICT_ERR_UNSUPPORTED:
+      return "unsupported dictionary feature";
+    case MDICT_ERR_CORRUPT:
+      return "corrupt dictionary data";
+    case MDICT_ERR_INVALID_ARGUMENT:
+      return "invalid argument";
+    default:
+      return "internal error";
+  }
+}
+
+void mdict_set_log_handler(mdict_log_callback_t callback, void *user_data,
+                           mdict_log_level_t level) {
+  mdict::logger::global().set_handler(callback, user_data, level);
+}
+
+void mdict_set_log_rate_limit(unsigned int per_second) {
+  mdict::logger::global().set_rate_limit(per_second);
+}
+
+mdict_error_t mdict_dict_set_log_handler(void *dict,
+                                         mdict_log_callback_t callback,
+                                         void *user_data,
+                                         mdict_log_level_t level) {
+  if (dict == nullptr) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  auto *self = (mdict::Mdict *)dict;
+  if (callback == nullptr) {
+    self->set_logger(nullptr);
+    return MDICT_OK;
+  }
+  self->set_logger(
+      std::make_shared<mdict::logger>(callback, user_data, level));
+  return MDICT_OK;
+}
+
 const char* c_mime_detect(const char* filename) {
     static std::string result;       // keep it alive after return
     result = mime_detect(filename);  
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#include "include/mdict_log.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <vector>
+
+namespace mdict {
+
+static const char *level_name(mdict_log_level_t level) {
+  switch (level) {
+    case MDICT_LOG_TRACE:
+      return "trace";
+    case MDICT_LOG_DEBUG:
+      return "debug";
+    case MDICT_LOG_INFO:
+      return "info";
+    case MDICT_LOG_WARN:
+      return "warning";
+    case MDICT_LOG_ERROR:
+      return "error";
+    default:
+      return "log";
+  }
+}
+
+logger::logger(mdict_log_callback_t handler, void *user_data,
+               mdict_log_level_t level)
+    : min_level(static_cast<int>(level)),
+      handler(handler),
+      user_data(user_data),
+      last_refill(std::chrono::steady_clock::now()) {}
+
+logger &logger::global() {
+  // never destroyed, so it stays usable from static destructors
+  static logger *instance = [] {
+    auto *lg = new logger(nullptr, nullptr, MDICT_LOG_WARN);
+    lg->set_rate_limit(20);
+    return lg;
+  }();
+  return *instance;
+}
+
+void logger::set_handler(mdict_log_callback_t handler, void *user_data,
+                         mdict_log_level_t level) {
+  std::lock_guard<std::mutex> lock(mtx);
+  this->handler = handler;
+  this->user_data = user_data;
+  this->min_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void logger::set_level(mdict_log_level_t level) {
+  this->min_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void logger::set_rate_limit(unsigned int per_second) {
+  std::lock_guard<std::mutex> lock(mtx);
+  this->rate_limit = per_second;
+  this->tokens = per_second;
+  this->last_refill = std::chrono::steady_clock::now();
+}
+
+void logger::write(mdict_log_level_t level, const std::string &message) {
+  std::unique_lock<std::mutex> lock(mtx);
+
+  uint64_t dropped = 0;
+  if (this->rate_limit > 0) {
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - this->last_refill;
+    this->last_refill = now;
+    this->tokens += elapsed.count() * this->rate_limit;
+    if (this->tokens > this->rate_limit) {
+      this->tokens = this->rate_limit;
+    }
+    if (this->tokens < 1.0) {
+      this->suppressed++;
+      return;
+    }
+    this->tokens -= 1.0;
+    dropped = this->suppressed;
+    this->suppressed = 0;
+  }
+
+  mdict_log_callback_t cb = this->handler;
+  void *ud = this->user_data;
+  // the handler may be slow, do not hold the lock while calling it
+  lock.unlock();
+
+  std::string text = message;
+  if (dropped > 0) {
+    text += " (" + std::to_string(dropped) + " similar messages suppressed)";
+  }
+
+  if (cb != nullptr) {
+    cb(level, text.c_str(), ud);
+  } else {
+    std::fprintf(stderr, "[mdict %s] %s\n", level_name(level), text.c_str());
+  }
+}
+
+void log_printf(mdict_log_level_t level, const char *fmt, ...) {
+  logger &lg = logger::global();
+  if (!lg.enabled(level)) {
+    return;
+  }
+
+  va_list args;
+  va_start(args, fmt);
+  va_list args_copy;
+  va_copy(args_copy, args);
+  int len = std::vsnprintf(nullptr, 0, fmt, args_copy);
+  va_end(args_copy);
+  if (len < 0) {
+    va_end(args);
+    return;
+  }
+
+  std::vector<char> buf(static_cast<size_t>(len) + 1);
+  std::vsnprintf(buf.data(), buf.size(), fmt, args);
+  va_end(args);
+
+  // strip the trailing newline of printf style messages
+  std::string message(buf.data(), static_cast<size_t>(len));
+  while (!message.empty() && message.back() == '\n') {
+    message.pop_back();
+  }
+  lg.write(level, message);
+}
+
+}  // namespace mdict
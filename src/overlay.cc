@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#include "include/overlay.h"
+
+#include <filesystem>
+#include <iterator>
+
+#include "include/adler32.h"
+#include "include/mdict.h"
+#include "include/sidecar.h"
+
+namespace mdict {
+
+static const char overlay_magic[] = "MDXOVLY1";
+static const size_t overlay_magic_len = sizeof(overlay_magic) - 1;
+
+mdict_error_t overlay_store::open() {
+  this->sorted.clear();
+  this->hashed.clear();
+  this->live = 0;
+  if (this->log.is_open()) {
+    this->log.close();
+  }
+
+  std::error_code ec;
+  bool exists = std::filesystem::exists(this->path, ec);
+  if (exists) {
+    std::ifstream in(this->path, std::ios::binary);
+    if (!in) {
+      return MDICT_ERR_IO;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+    if (data.size() < overlay_magic_len ||
+        data.compare(0, overlay_magic_len, overlay_magic) != 0) {
+      return MDICT_ERR_CORRUPT;
+    }
+
+    section_reader r(data);
+    char magic[overlay_magic_len];
+    r.bytes(magic, sizeof(magic));
+    size_t good = overlay_magic_len;
+    for (;;) {
+      uint8_t op = 0;
+      uint32_t key_len = 0;
+      uint32_t def_len = 0;
+      if (!r.bytes(&op, 1) || !r.u32(key_len) || !r.u32(def_len) ||
+          r.remaining() < uint64_t(key_len) + def_len + 4) {
+        break;
+      }
+      std::string key(key_len, '\0');
+      std::string def(def_len, '\0');
+      uint32_t checksum = 0;
+      r.bytes(&key[0], key_len);
+      r.bytes(&def[0], def_len);
+      r.u32(checksum);
+      uint32_t record_len = 9 + key_len + def_len;
+      if ((op != OP_PUT && op != OP_DELETE) ||
+          adler32checksum(reinterpret_cast<const unsigned char *>(
+                              data.data() + good),
+                          record_len) != checksum) {
+        break;
+      }
+      this->apply(op, key, std::move(def));
+      good += record_len + 4;
+    }
+    if (good < data.size()) {
+      log_printf(MDICT_LOG_WARN, "overlay %s: dropping %zu bytes of torn records",
+                 this->path.c_str(), data.size() - good);
+      std::filesystem::resize_file(this->path, good, ec);
+      if (ec) {
+        return MDICT_ERR_IO;
+      }
+    }
+  }
+
+  this->log.open(this->path, std::ios::binary | std::ios::app);
+  if (!this->log) {
+    return MDICT_ERR_IO;
+  }
+  if (!exists) {
+    this->log.write(overlay_magic, overlay_magic_len);
+    this->log.flush();
+    if (!this->log) {
+      return MDICT_ERR_IO;
+    }
+  }
+  return MDICT_OK;
+}
+
+void overlay_store::apply(uint8_t op, const std::string &key,
+                          std::string definition) {
+  std::string normalized = _s(key);
+  bool deleted = op == OP_DELETE;
+  auto it = this->sorted.find(normalized);
+  if (it == this->sorted.end()) {
+    it = this->sorted
+             .emplace(normalized, entry{key, std::move(definition), deleted})
+             .first;
+    this->hashed.emplace(normalized, &it->second);
+  } else {
+    if (!it->second.deleted) {
+      this->live--;
+    }
+    it->second = entry{key, std::move(definition), deleted};
+  }
+  if (!deleted) {
+    this->live++;
+  }
+}
+
+mdict_error_t overlay_store::append(uint8_t op, const std::string &key,
+                                    const std::string &definition) {
+  if (!this->log.is_open()) {
+    return MDICT_ERR_IO;
+  }
+  section_writer w;
+  w.bytes(&op, 1);
+  w.u32(static_cast<uint32_t>(key.size()));
+  w.u32(static_cast<uint32_t>(definition.size()));
+  w.bytes(key.data(), key.size());
+  w.bytes(definition.data(), definition.size());
+  w.u32(adler32checksum(reinterpret_cast<const unsigned char *>(w.data.data()),
+                        static_cast<uint32_t>(w.data.size())));
+  this->log.write(w.data.data(), static_cast<std::streamsize>(w.data.size()));
+  this->log.flush();
+  if (!this->log) {
+    return MDICT_ERR_IO;
+  }
+  this->apply(op, key, definition);
+  return MDICT_OK;
+}
+
+mdict_error_t overlay_store::put(const std::string &key,
+                                 const std::string &definition) {
+  if (key.empty() || definition.size() > UINT32_MAX) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  return this->append(OP_PUT, key, definition);
+}
+
+mdict_error_t overlay_store::remove(const std::string &key) {
+  if (key.empty()) {
+    return MDICT_ERR_INVALID_ARGUMENT;
+  }
+  return this->append(OP_DELETE, key, std::string());
+}
+
+overlay_store::state overlay_store::get(const std::string &normalized,
+                                        std::string *definition) const {
+  auto it = this->hashed.find(normalized);
+  if (it == this->hashed.end()) {
+    return ABSENT;
+  }
+  if (it->second->deleted) {
+    return DELETED;
+  }
+  if (definition) {
+    *definition = it->second->definition;
+  }
+  return PRESENT;
+}
+
+std::vector<std::pair<std::string, std::string>> overlay_store::prefix(
+    const std::string &normalized_prefix) const {
+  std::vector<std::pair<std::string, std::string>> out;
+  for (auto it = this->sorted.lower_bound(normalized_prefix);
+       it != this->sorted.end() &&
+       it->first.compare(0, normalized_prefix.size(), normalized_prefix) == 0;
+       ++it) {
+    if (!it->second.deleted) {
+      out.emplace_back(it->first, it->second.key);
+    }
+  }
+  return out;
+}
+
+}  // namespace mdict
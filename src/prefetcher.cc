@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#include "include/prefetcher.h"
+
+#include <utility>
+
+namespace mdict {
+
+prefetcher::prefetcher(const std::string &path, loader load, int min_run)
+    : in(path, std::ios::binary), load(std::move(load)), min_run(min_run) {
+  this->worker = std::thread(&prefetcher::work, this);
+}
+
+prefetcher::~prefetcher() {
+  {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    this->stopping = true;
+    this->queue.clear();
+  }
+  this->wake.notify_one();
+  this->worker.join();
+}
+
+int prefetcher::observe(uint8_t kind, uint64_t block_id) {
+  run &r = this->runs[kind == KEY_BLOCK ? 0 : 1];
+  if (!r.seen) {
+    r.seen = true;
+    r.last = block_id;
+    return 0;
+  }
+  if (block_id == r.last) {
+    // more entries of the same block
+    return r.length >= this->min_run ? r.direction : 0;
+  }
+  int direction = 0;
+  if (block_id == r.last + 1) {
+    direction = 1;
+  } else if (block_id + 1 == r.last) {
+    direction = -1;
+  }
+  if (direction != 0 && direction == r.direction) {
+    r.length++;
+  } else {
+    r.direction = direction;
+    r.length = direction != 0 ? 1 : 0;
+  }
+  r.last = block_id;
+  return r.length >= this->min_run ? r.direction : 0;
+}
+
+void prefetcher::submit(const block_key &key,
+                        std::shared_ptr<block_cache> cache) {
+  {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    for (const auto &j : this->queue) {
+      if (j.key == key) {
+        return;
+      }
+    }
+    if (this->queue.size() >= MDICT_PREFETCH_QUEUE) {
+      // the reader moved on, the oldest guess is the least useful
+      this->queue.pop_front();
+      this->counters.dropped++;
+    }
+    this->queue.push_back(job{key, std::move(cache)});
+    this->counters.issued++;
+  }
+  this->wake.notify_one();
+}
+
+void prefetcher::wait_idle() {
+  std::unique_lock<std::mutex> lock(this->mtx);
+  this->idle.wait(lock, [this] { return this->queue.empty() && !this->busy; });
+}
+
+mdict_prefetch_stats_t prefetcher::stats() {
+  std::lock_guard<std::mutex> lock(this->mtx);
+  return this->counters;
+}
+
+void prefetcher::work() {
+  std::unique_lock<std::mutex> lock(this->mtx);
+  for (;;) {
+    this->wake.wait(lock,
+                    [this] { return this->stopping || !this->queue.empty(); });
+    if (this->stopping) {
+      return;
+    }
+    job j = std::move(this->queue.front());
+    this->queue.pop_front();
+    this->busy = true;
+    lock.unlock();
+
+    bool cached = j.cache->contains(j.key);
+    mdict_error_t err = MDICT_OK;
+    block_ptr block;
+    if (!cached) {
+      err = this->load(this->in, j.key, block);
+      if (err == MDICT_OK) {
+        j.cache->put(j.key, block);
+      }
+    }
+
+    lock.lock();
+    if (cached) {
+      this->counters.skipped++;
+    } else if (err == MDICT_OK) {
+      this->counters.completed++;
+      this->counters.bytes += block->size();
+    } else {
+      this->counters.failed++;
+    }
+    this->busy = false;
+    if (this->queue.empty()) {
+      this->idle.notify_all();
+    }
+  }
+}
+
+}  // namespace mdict
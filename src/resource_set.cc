@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#include "include/resource_set.h"
+
+#include <filesystem>
+
+namespace mdict {
+
+resource_set::resource_set(const std::string &dict_path)
+    : blocks(block_cache::shared()) {
+  // foo.mdx / foo.mdd -> foo
+  std::string base = dict_path;
+  size_t dot = base.find_last_of('.');
+  if (dot != std::string::npos && base.find('/', dot) == std::string::npos) {
+    base = base.substr(0, dot);
+  }
+
+  // foo.mdd, then foo.1.mdd, foo.2.mdd, ... up to the first missing number
+  if (std::filesystem::exists(base + ".mdd")) {
+    this->paths.push_back(base + ".mdd");
+  }
+  for (int i = 1;; i++) {
+    std::string volume = base + "." + std::to_string(i) + ".mdd";
+    if (!std::filesystem::exists(volume)) {
+      break;
+    }
+    this->paths.push_back(volume);
+  }
+}
+
+void resource_set::open_next() {
+  size_t v = this->volumes.size();
+  std::unique_ptr<Mdict> dict(new Mdict(this->paths[v]));
+  try {
+    dict->init();
+  } catch (std::exception &e) {
+    // an unreadable volume hides its resources, not the whole set
+    log_printf(MDICT_LOG_WARN, "cannot open resource volume %s: %s",
+               this->paths[v].c_str(), e.what());
+    this->volumes.push_back(nullptr);
+    return;
+  }
+  dict->set_block_cache(this->blocks);
+
+  auto keys = dict->keyList();
+  this->index.reserve(this->index.size() + keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    // emplace keeps the entry of an earlier volume
+    this->index.emplace(keys[i]->key_word, entry{static_cast<uint32_t>(v),
+                                                 static_cast<uint32_t>(i)});
+  }
+  this->volumes.push_back(std::move(dict));
+}
+
+const resource_set::entry *resource_set::resolve(
+    const std::string &resource_name) {
+  for (;;) {
+    auto it = this->index.find(resource_name);
+    if (it != this->index.end()) {
+      return &it->second;
+    }
+    if (this->volumes.size() == this->paths.size()) {
+      return nullptr;
+    }
+    this->open_next();
+  }
+}
+
+bool resource_set::contains(const std::string &resource_name) {
+  return this->resolve(resource_name) != nullptr;
+}
+
+std::string resource_set::locate(const std::string &resource_name,
+                                 mdict_encoding_t encoding) {
+  const entry *e = this->resolve(resource_name);
+  if (!e) {
+    this->last_err = MDICT_ERR_NOT_FOUND;
+    return std::string("");
+  }
+  Mdict &dict = *this->volumes[e->volume];
+  std::string out = dict.locate_at(e->key_index, encoding);
+  this->last_err = dict.last_error();
+  return out;
+}
+
+mdict_error_t resource_set::locate_stream(const std::string &resource_name,
+                                          const resource_sink &sink,
+                                          size_t chunk_bytes) {
+  const entry *e = this->resolve(resource_name);
+  if (!e) {
+    this->last_err = MDICT_ERR_NOT_FOUND;
+    return this->last_err;
+  }
+  this->last_err = this->volumes[e->volume]->locate_stream_at(
+      e->key_index, sink, chunk_bytes);
+  return this->last_err;
+}
+
+mdict_error_t resource_set::locate_range(const std::string &resource_name,
+                                         uint64_t offset, uint64_t length,
+                                         const resource_sink &sink,
+                                         uint64_t *resource_size,
+                                         size_t chunk_bytes) {
+  const entry *e = this->resolve(resource_name);
+  if (!e) {
+    this->last_err = MDICT_ERR_NOT_FOUND;
+    return this->last_err;
+  }
+  this->last_err = this->volumes[e->volume]->locate_range_at(
+      e->key_index, offset, length, sink, resource_size, chunk_bytes);
+  return this->last_err;
+}
+
+mdict_error_t resource_set::locate_batch(const std::vector<std::string> &names,
+                                         std::vector<resource_payload> &out) {
+  out.assign(names.size(), resource_payload());
+  // per volume: the key indexes to locate and the payloads they fill
+  std::vector<std::vector<size_t>> key_indexes;
+  std::vector<std::vector<size_t>> targets;
+  for (size_t i = 0; i < names.size(); i++) {
+    out[i].name = names[i];
+    const entry *e = this->resolve(names[i]);
+    if (!e) {
+      continue;
+    }
+    if (e->volume >= key_indexes.size()) {
+      key_indexes.resize(e->volume + 1);
+      targets.resize(e->volume + 1);
+    }
+    key_indexes[e->volume].push_back(e->key_index);
+    targets[e->volume].push_back(i);
+  }
+
+  std::vector<resource_payload> located;
+  for (size_t v = 0; v < key_indexes.size(); v++) {
+    if (key_indexes[v].empty()) {
+      continue;
+    }
+    this->volumes[v]->locate_batch_at(key_indexes[v], located);
+    for (size_t j = 0; j < located.size(); j++) {
+      out[targets[v][j]].err = located[j].err;
+      out[targets[v][j]].data = std::move(located[j].data);
+    }
+  }
+  this->last_err = MDICT_OK;
+  for (const auto &p : out) {
+    if (p.err != MDICT_OK) {
+      this->last_err = p.err;
+      break;
+    }
+  }
+  return this->last_err;
+}
+
+mdict_error_t resource_set::resource_hash(const std::string &resource_name,
+                                          std::string &hex) {
+  const entry *e = this->resolve(resource_name);
+  if (!e) {
+    this->last_err = MDICT_ERR_NOT_FOUND;
+    return this->last_err;
+  }
+  content_hash hash;
+  this->last_err = this->volumes[e->volume]->resource_hash_at(e->key_index, hash);
+  if (this->last_err == MDICT_OK) {
+    hex = content_hash_hex(hash);
+  }
+  return this->last_err;
+}
+
+void resource_set::set_block_cache(uint64_t capacity_bytes,
+                                   mdict_cache_policy_t policy,
+                                   unsigned int warm_percent) {
+  if (capacity_bytes == 0) {
+    this->blocks.reset();
+  } else {
+    this->blocks = block_cache::with_budget(capacity_bytes, policy, warm_percent);
+  }
+  for (auto &dict : this->volumes) {
+    if (dict) {
+      dict->set_block_cache(this->blocks);
+    }
+  }
+}
+
+mdict_cache_stats_t resource_set::block_cache_stats() {
+  if (!this->blocks) {
+    return mdict_cache_stats_t{};
+  }
+  return this->blocks->stats();
+}
+
+}  // namespace mdict
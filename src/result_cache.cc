@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#include "include/result_cache.h"
+
+namespace mdict {
+
+result_cache::result_cache(uint64_t capacity_bytes,
+                           mdict_cache_policy_t policy)
+    : capacity(capacity_bytes), policy(policy), hand(entries.end()) {}
+
+void result_cache::bind(uint64_t identity) {
+  std::lock_guard<std::mutex> lock(mtx);
+  if (this->identity != identity) {
+    this->identity = identity;
+    entries.clear();
+    index.clear();
+    hand = entries.end();
+    used = 0;
+  }
+}
+
+bool result_cache::get(const std::string &key, std::string &out) {
+  std::lock_guard<std::mutex> lock(mtx);
+  auto it = index.find(key);
+  if (it == index.end()) {
+    misses++;
+    return false;
+  }
+  hits++;
+  if (policy == MDICT_CACHE_LRU) {
+    entries.splice(entries.begin(), entries, it->second);
+  } else {
+    it->second->referenced = true;
+  }
+  out = it->second->value;
+  return true;
+}
+
+void result_cache::put(const std::string &key, const std::string &value) {
+  uint64_t cost = charge(key, value);
+  std::lock_guard<std::mutex> lock(mtx);
+  if (cost > capacity) {
+    return;
+  }
+
+  auto it = index.find(key);
+  if (it != index.end()) {
+    used -= charge(it->second->key, it->second->value);
+    it->second->value = value;
+    it->second->referenced = true;
+    used += cost;
+  } else {
+    entry_list::iterator pos;
+    if (policy == MDICT_CACHE_LRU) {
+      pos = entries.insert(entries.begin(), entry{key, value, false});
+    } else {
+      // new entries go right behind the hand, they are the last to be swept
+      pos = entries.insert(hand, entry{key, value, false});
+    }
+    index.emplace(key, pos);
+    used += cost;
+  }
+  evict();
+}
+
+void result_cache::evict() {
+  while (used > capacity && !entries.empty()) {
+    entry_list::iterator victim;
+    if (policy == MDICT_CACHE_LRU) {
+      victim = std::prev(entries.end());
+    } else {
+      if (hand == entries.end()) {
+        hand = entries.begin();
+      }
+      if (hand->referenced) {
+        hand->referenced = false;
+        ++hand;
+        continue;
+      }
+      victim = hand++;
+    }
+    used -= charge(victim->key, victim->value);
+    index.erase(victim->key);
+    entries.erase(victim);
+    evictions++;
+  }
+}
+
+void result_cache::clear() {
+  std::lock_guard<std::mutex> lock(mtx);
+  entries.clear();
+  index.clear();
+  hand = entries.end();
+  used = 0;
+}
+
+std::vector<std::string> result_cache::queries(kind k, size_t limit) {
+  std::lock_guard<std::mutex> lock(mtx);
+  std::vector<std::string> out;
+  for (const auto &e : entries) {
+    if (out.size() >= limit) {
+      break;
+    }
+    if (!e.key.empty() && e.key[0] == static_cast<char>(k)) {
+      out.push_back(e.key.substr(1));
+    }
+  }
+  return out;
+}
+
+mdict_cache_stats_t result_cache::stats() {
+  std::lock_guard<std::mutex> lock(mtx);
+  mdict_cache_stats_t s{};
+  s.hits = hits;
+  s.misses = misses;
+  s.evictions = evictions;
+  s.entries = index.size();
+  s.bytes = used;
+  s.capacity = capacity;
+  return s;
+}
+
+}  // namespace mdict
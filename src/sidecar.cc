@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2025-Present
+ * All rights reserved.
+ *
+ * This code is licensed under the BSD 3-Clause License.
+ * See the LICENSE file for details.
+ */
+
+#include "include/sidecar.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "include/adler32.h"
+#include "include/binutils.h"
+
+namespace mdict {
+
+static const char sidecar_magic[] = "MDXSIDE1";
+
+// ------------------------------------------
+// section_writer / section_reader
+// ------------------------------------------
+
+void section_writer::u32(uint32_t v) {
+  for (int i = 3; i >= 0; i--) {
+    this->data.push_back(static_cast<char>(v >> (8 * i)));
+  }
+}
+
+void section_writer::u64(uint64_t v) {
+  this->u32(static_cast<uint32_t>(v >> 32));
+  this->u32(static_cast<uint32_t>(v));
+}
+
+void section_writer::f64(double v) {
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  this->u64(bits);
+}
+
+void section_writer::bytes(const void *data, size_t len) {
+  this->data.append(static_cast<const char *>(data), len);
+}
+
+bool section_reader::bytes(void *out, size_t len) {
+  if (this->remaining() < len) {
+    return false;
+  }
+  memcpy(out, this->data.data() + this->pos, len);
+  this->pos += len;
+  return true;
+}
+
+bool section_reader::u32(uint32_t &v) {
+  unsigned char buf[4];
+  if (!this->bytes(buf, sizeof(buf))) {
+    return false;
+  }
+  v = be_bin_to_u32(buf);
+  return true;
+}
+
+bool section_reader::u64(uint64_t &v) {
+  unsigned char buf[8];
+  if (!this->bytes(buf, sizeof(buf))) {
+    return false;
+  }
+  v = be_bin_to_u64(buf);
+  return true;
+}
+
+bool section_reader::f64(double &v) {
+  uint64_t bits;
+  if (!this->u64(bits)) {
+    return false;
+  }
+  memcpy(&v, &bits, sizeof(v));
+  return true;
+}
+
+// ------------------------------------------
+// sidecar
+// ------------------------------------------
+
+static uint32_t tag_value(const std::string &tag) {
+  uint32_t v = 0;
+  for (size_t i = 0; i < 4; i++) {
+    v = (v << 8) | (i < tag.size() ? static_cast<unsigned char>(tag[i]) : ' ');
+  }
+  return v;
+}
+
+static std::string tag_name(uint32_t v) {
+  std::string tag(4, ' ');
+  for (int i = 0; i < 4; i++) {
+    tag[i] = static_cast<char>(v >> (8 * (3 - i)));
+  }
+  return tag;
+}
+
+bool sidecar::load(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::string file((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+  size_t magic_len = sizeof(sidecar_magic) - 1;
+  if (file.size() < magic_len + 4 ||
+      file.compare(0, magic_len, sidecar_magic) != 0) {
+    return false;
+  }
+  size_t body = file.size() - 4;
+  uint32_t checksum =
+      be_bin_to_u32(reinterpret_cast<const unsigned char *>(file.data()) + body);
+  if (adler32checksum(reinterpret_cast<const unsigned char *>(file.data()),
+                      static_cast<uint32_t>(body)) != checksum) {
+    return false;
+  }
+  file.resize(body);
+
+  section_reader r(file);
+  char magic[8];
+  uint64_t file_identity = 0;
+  uint32_t count = 0;
+  if (!r.bytes(magic, sizeof(magic)) || !r.u64(file_identity) ||
+      !r.u32(count) || file_identity != this->identity) {
+    return false;
+  }
+  std::map<std::string, std::string> loaded;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t tag = 0;
+    uint64_t len = 0;
+    if (!r.u32(tag) || !r.u64(len) || len > r.remaining()) {
+      return false;
+    }
+    std::string payload(static_cast<size_t>(len), '\0');
+    r.bytes(&payload[0], payload.size());
+    loaded[tag_name(tag)] = std::move(payload);
+  }
+  this->sections = std::move(loaded);
+  return true;
+}
+
+bool sidecar::save(const std::string &path) const {
+  section_writer w;
+  w.bytes(sidecar_magic, sizeof(sidecar_magic) - 1);
+  w.u64(this->identity);
+  w.u32(static_cast<uint32_t>(this->sections.size()));
+  for (const auto &s : this->sections) {
+    w.u32(tag_value(s.first));
+    w.u64(s.second.size());
+    w.bytes(s.second.data(), s.second.size());
+  }
+  w.u32(adler32checksum(reinterpret_cast<const unsigned char *>(w.data.data()),
+                        static_cast<uint32_t>(w.data.size())));
+
+  // readers never see a half written file
+  std::string tmp = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out.write(w.data.data(), static_cast<std::streamsize>(w.data.size()))) {
+      std::remove(tmp.c_str());
+      return false;
+    }
+  }
+  return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+const std::string *sidecar::section(const std::string &tag) const {
+  auto it = this->sections.find(tag_name(tag_value(tag)));
+  return it == this->sections.end() ? nullptr : &it->second;
+}
+
+void sidecar::set_section(const std::string &tag, std::string payload) {
+  this->sections[tag_name(tag_value(tag))] = std::move(payload);
+}
+
+}  // namespace mdict
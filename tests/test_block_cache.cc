@@ -0,0 +1,364 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "include/block_cache.h"
+#include "include/mdict.h"
+
+using mdict::block_cache;
+using mdict::block_key;
+using mdict::block_ptr;
+
+static block_key rkey(uint64_t id) {
+  return block_key{1, mdict::RECORD_BLOCK, id};
+}
+
+static block_ptr make_block(size_t n) {
+  return std::make_shared<const std::vector<uint8_t>>(n, 0x5a);
+}
+
+// miss -> decode -> put, the way Mdict uses the cache
+static bool touch(block_cache &c, uint64_t id, bool scan = false) {
+  if (c.get(rkey(id), scan)) {
+    return true;
+  }
+  c.put(rkey(id), make_block(1000), scan);
+  return false;
+}
+
+static int hot_hits_after_scan(mdict_cache_policy_t policy) {
+  // room for about 20 blocks of 1000 bytes
+  block_cache c(20 * 1128, policy);
+  for (int round = 0; round < 5; round++) {
+    for (uint64_t id = 0; id < 5; id++) {
+      touch(c, id);
+    }
+  }
+  // one pass over many cold blocks
+  for (uint64_t id = 1000; id < 1200; id++) {
+    touch(c, id);
+  }
+  int hits = 0;
+  for (uint64_t id = 0; id < 5; id++) {
+    hits += c.get(rkey(id)) ? 1 : 0;
+  }
+  return hits;
+}
+
+TEST(FrequencySketchTest, CountsAndSaturates) {
+  mdict::frequency_sketch s(64);
+  EXPECT_EQ(s.estimate(42), 0);
+  for (int i = 0; i < 3; i++) {
+    s.increment(42);
+  }
+  EXPECT_EQ(s.estimate(42), 3);
+  for (int i = 0; i < 100; i++) {
+    s.increment(7);
+  }
+  EXPECT_LE(s.estimate(7), 15);
+  EXPECT_GE(s.estimate(7), 7);  // may have been halved by aging
+}
+
+TEST(BlockCacheTest, HitMissAndStats) {
+  block_cache c(1 << 20);
+  EXPECT_FALSE(touch(c, 1));
+  EXPECT_TRUE(touch(c, 1));
+  block_key other{2, mdict::RECORD_BLOCK, 1};
+  EXPECT_EQ(c.get(other), nullptr);  // dictionaries do not collide
+
+  mdict_cache_stats_t st = c.stats();
+  EXPECT_EQ(st.hits, 1);
+  EXPECT_EQ(st.misses, 2);
+  EXPECT_EQ(st.entries, 1);
+  EXPECT_LE(st.bytes, st.capacity);
+}
+
+TEST(BlockCacheTest, TinyLfuSurvivesScan) {
+  EXPECT_EQ(hot_hits_after_scan(MDICT_CACHE_TINYLFU), 5);
+  // a plain LRU is flushed by the same pass
+  EXPECT_EQ(hot_hits_after_scan(MDICT_CACHE_LRU), 0);
+}
+
+TEST(BlockCacheTest, ScanHintDoesNotInsert) {
+  block_cache c(1 << 20);
+  EXPECT_FALSE(touch(c, 1, true));
+  EXPECT_FALSE(touch(c, 1, true));
+  EXPECT_EQ(c.stats().entries, 0);
+  // scans still read blocks that are already cached
+  touch(c, 2);
+  EXPECT_TRUE(touch(c, 2, true));
+}
+
+TEST(BlockCacheTest, ClockRespectsBudget) {
+  block_cache c(5 * 1128, MDICT_CACHE_CLOCK);
+  for (uint64_t id = 0; id < 50; id++) {
+    touch(c, id);
+  }
+  mdict_cache_stats_t st = c.stats();
+  EXPECT_EQ(st.entries, 5);
+  EXPECT_EQ(st.evictions, 45);
+}
+
+TEST(BlockCacheTest, WarmTierKeepsEvictedBlocks) {
+  // two decompressed blocks, plenty of room for compressed ones
+  block_cache c(2 * 1128, MDICT_CACHE_LRU, 1 << 20);
+  for (uint64_t id = 0; id < 10; id++) {
+    touch(c, id);
+  }
+  mdict_cache_stats_t st = c.stats();
+  EXPECT_EQ(st.entries, 2);
+  EXPECT_EQ(st.warm_entries, 8);
+  EXPECT_LT(st.warm_bytes, 8 * 1000);
+
+  block_ptr b = c.get(rkey(0));
+  ASSERT_NE(b, nullptr);
+  EXPECT_EQ(*b, std::vector<uint8_t>(1000, 0x5a));
+  st = c.stats();
+  EXPECT_EQ(st.warm_hits, 1);
+  EXPECT_EQ(st.misses, 10);
+  // promoted back into the hot tier
+  EXPECT_TRUE(touch(c, 0));
+  EXPECT_EQ(c.stats().hits, 1);
+}
+
+TEST(BlockCacheTest, OneBudgetForBothTiers) {
+  mdict_cache_stats_t st =
+      block_cache::with_budget(100 << 10, MDICT_CACHE_LRU, 25)->stats();
+  EXPECT_EQ(st.capacity, 75u << 10);
+  EXPECT_EQ(st.warm_capacity, 25u << 10);
+  // the hot tier keeps a share
+  st = block_cache::with_budget(1000, MDICT_CACHE_LRU, 200)->stats();
+  EXPECT_EQ(st.warm_capacity, 900u);
+  EXPECT_EQ(st.capacity, 100u);
+
+  // resizing keeps the warm tier unless asked otherwise
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  dict.set_block_cache(8 << 20);
+  st = dict.block_cache_stats();
+  EXPECT_GT(st.warm_capacity, 0u);
+  EXPECT_EQ(st.capacity + st.warm_capacity, 8u << 20);
+  dict.set_block_cache(8 << 20, MDICT_CACHE_LRU, 0);
+  EXPECT_EQ(dict.block_cache_stats().warm_capacity, 0u);
+}
+
+TEST(BlockCacheTest, WarmTierSkipsIncompressibleBlocks) {
+  block_cache c(1128, MDICT_CACHE_LRU, 1 << 20);
+  uint32_t x = 12345;
+  for (uint64_t id = 0; id < 3; id++) {
+    auto noise = std::make_shared<std::vector<uint8_t>>(1000);
+    for (auto &byte : *noise) {
+      x = x * 1103515245 + 12345;
+      byte = static_cast<uint8_t>(x >> 24);
+    }
+    c.put(rkey(id), noise);
+  }
+  EXPECT_EQ(c.stats().warm_entries, 0);
+}
+
+TEST(BlockCacheTest, DictionaryLookup) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.set_block_cache(24 << 20);
+  dict.init();
+
+  std::string def = dict.lookup("cake");
+  ASSERT_FALSE(def.empty());
+  mdict_cache_stats_t first = dict.block_cache_stats();
+  EXPECT_EQ(first.misses, 2);  // key block + record block
+  EXPECT_EQ(first.entries, 2);
+
+  EXPECT_EQ(dict.lookup("cake"), def);
+  mdict_cache_stats_t second = dict.block_cache_stats();
+  EXPECT_EQ(second.hits, first.hits + 2);
+
+  // a scan over a fresh dictionary leaves its block cache empty
+  mdict::Mdict scanned("../testdict/testdict.mdx");
+  scanned.set_block_cache(24 << 20);
+  scanned.init();
+  EXPECT_EQ(scanned.lookup("cake", MDICT_ACCESS_SCAN), def);
+  EXPECT_EQ(scanned.block_cache_stats().entries, 0);
+
+  // disabled cache
+  dict.set_block_cache(0);
+  EXPECT_EQ(dict.lookup("cake"), def);
+  EXPECT_EQ(dict.block_cache_stats().capacity, 0);
+}
+
+TEST(BlockCacheTest, ResolveBlocksMatchesLookup) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.set_block_cache(24 << 20);
+  dict.init();
+
+  std::vector<mdict::block_ref> refs = dict.resolve_blocks("cake");
+  ASSERT_EQ(refs.size(), 2u);
+  EXPECT_EQ(refs[0].kind, mdict::KEY_BLOCK);
+  EXPECT_EQ(refs[1].kind, mdict::RECORD_BLOCK);
+  EXPECT_GT(refs[0].decompressed_size, 0u);
+  EXPECT_GT(refs[1].decompressed_size, 0u);
+  // resolving reads nothing
+  EXPECT_EQ(dict.block_cache_stats().misses, 0);
+
+  // the lookup fills exactly the resolved blocks
+  ASSERT_FALSE(dict.lookup("cake").empty());
+  mdict_cache_stats_t st = dict.block_cache_stats();
+  EXPECT_EQ(st.entries, 2);
+  EXPECT_EQ(st.bytes,
+            refs[0].decompressed_size + refs[1].decompressed_size + 2 * 128);
+
+  // a missing word still costs the key block it is searched in
+  std::vector<mdict::block_ref> missing = dict.resolve_blocks("cakeqqq");
+  ASSERT_EQ(missing.size(), 1u);
+  EXPECT_EQ(missing[0].kind, mdict::KEY_BLOCK);
+  EXPECT_EQ(missing[0].block_id, refs[0].block_id);
+  EXPECT_TRUE(dict.lookup("cakeqqq").empty());
+  EXPECT_EQ(dict.block_cache_stats().hits, 1);
+  EXPECT_LE(dict.resolve_blocks("notaword_zzzz").size(), 1u);
+}
+
+static int reserved_survivors(mdict_cache_policy_t policy) {
+  // room for about 20 blocks, dictionary 7 reserves 5 of them
+  block_cache c(20 * 1128, policy);
+  c.reserve(7, 5 * 1128);
+  for (uint64_t id = 0; id < 5; id++) {
+    c.put(block_key{7, mdict::RECORD_BLOCK, id}, make_block(1000));
+  }
+  // a busy dictionary streams many blocks through the cache
+  for (int round = 0; round < 3; round++) {
+    for (uint64_t id = 0; id < 200; id++) {
+      touch(c, id);
+    }
+  }
+  EXPECT_LE(c.stats().bytes, c.capacity());
+  int kept = 0;
+  for (uint64_t id = 0; id < 5; id++) {
+    kept += c.get(block_key{7, mdict::RECORD_BLOCK, id}) ? 1 : 0;
+  }
+  return kept;
+}
+
+TEST(BlockCacheTest, PerDictionaryStats) {
+  block_cache c(1 << 20);
+  touch(c, 1);
+  touch(c, 1);
+  // dictionary 2 holds a reservation, so its first miss is counted too
+  c.reserve(2, 1000);
+  block_key other{2, mdict::RECORD_BLOCK, 1};
+  c.get(other);
+  c.put(other, make_block(500));
+  c.put(block_key{2, mdict::KEY_BLOCK, 1}, make_block(500));
+
+  mdict_cache_stats_t a = c.dict_stats(1);
+  EXPECT_EQ(a.hits, 1);
+  EXPECT_EQ(a.misses, 0);
+  EXPECT_EQ(a.entries, 1);
+  mdict_cache_stats_t b = c.dict_stats(2);
+  EXPECT_EQ(b.hits, 0);
+  EXPECT_EQ(b.misses, 1);
+  EXPECT_EQ(b.entries, 2);
+  EXPECT_EQ(a.bytes + b.bytes, c.stats().bytes);
+  EXPECT_EQ(c.dict_stats(3).entries, 0);
+
+  // misses of an erased dictionary must not bring its counters back
+  c.erase_dict(1);
+  c.get(block_key{1, mdict::RECORD_BLOCK, 1});
+  EXPECT_EQ(c.dict_stats(1).misses, 0);
+  EXPECT_EQ(c.stats().entries, 2);
+}
+
+TEST(BlockCacheTest, ReservationsSurviveOtherDictionaries) {
+  for (auto policy : {MDICT_CACHE_LRU, MDICT_CACHE_CLOCK, MDICT_CACHE_TINYLFU}) {
+    EXPECT_EQ(reserved_survivors(policy), 5) << "policy " << policy;
+  }
+}
+
+TEST(BlockCacheTest, SharedCacheAcrossDictionaries) {
+  mdict::block_cache::configure_shared(4 << 20, MDICT_CACHE_TINYLFU, 0);
+  mdict::Mdict mdx("../testdict/testdict.mdx");
+  mdx.init();
+  mdict::Mdict mdd("../testdict/testdict.1.mdd");
+  mdd.init();
+  mdx.use_shared_block_cache(1 << 20);
+  mdd.use_shared_block_cache();
+
+  EXPECT_FALSE(mdx.lookup("cake").empty());
+  EXPECT_FALSE(mdx.lookup("zoom").empty());
+  EXPECT_FALSE(mdd.locate("\\img\\b.png").empty());
+
+  mdict_cache_stats_t shared = mdict::block_cache::shared()->stats();
+  mdict_cache_stats_t a = mdx.block_cache_dict_stats();
+  mdict_cache_stats_t b = mdd.block_cache_dict_stats();
+  EXPECT_GE(a.entries, 2);
+  EXPECT_GE(b.entries, 1);
+  EXPECT_EQ(a.capacity, 1u << 20);
+  EXPECT_EQ(a.entries + b.entries, shared.entries);
+  EXPECT_EQ(mdx.block_cache_stats().capacity, 4u << 20);
+}
+
+TEST(BlockCacheTest, ClosedDictionariesLeaveTheSharedCache) {
+  mdict::block_cache::configure_shared(4 << 20, MDICT_CACHE_TINYLFU, 0);
+  auto shared = mdict::block_cache::shared();
+  mdict::Mdict mdx("../testdict/testdict.mdx");
+  mdx.init();
+  mdx.use_shared_block_cache();
+  EXPECT_FALSE(mdx.lookup("cake").empty());
+  uint64_t id = 0;
+  {
+    mdict::Mdict mdd("../testdict/testdict.1.mdd");
+    mdd.init();
+    mdd.use_shared_block_cache(1 << 20);
+    EXPECT_FALSE(mdd.locate("\\img\\b.png").empty());
+    id = mdd.block_cache_id();
+    EXPECT_GE(shared->dict_stats(id).entries, 1);
+  }
+  mdict_cache_stats_t gone = shared->dict_stats(id);
+  EXPECT_EQ(gone.entries, 0);
+  EXPECT_EQ(gone.capacity, 0);
+  EXPECT_EQ(gone.hits + gone.misses, 0);
+  EXPECT_EQ(shared->stats().entries, mdx.block_cache_dict_stats().entries);
+
+  // moving to a private cache releases the shared one too
+  mdx.set_block_cache(1 << 20);
+  EXPECT_EQ(shared->stats().entries, 0);
+  EXPECT_EQ(shared->dict_stats(mdx.block_cache_id()).misses, 0);
+}
+
+TEST(BlockCacheTest, DictionariesUseTheSharedCacheByDefault) {
+  mdict::block_cache::configure_shared(4 << 20, MDICT_CACHE_TINYLFU, 0);
+  mdict::Mdict mdx("../testdict/testdict.mdx");
+  mdx.init();
+  EXPECT_FALSE(mdx.lookup("cake").empty());
+  EXPECT_EQ(mdx.block_cache_stats().capacity, 4u << 20);
+  EXPECT_EQ(mdict::block_cache::shared()->stats().entries,
+            mdx.block_cache_dict_stats().entries);
+}
+
+TEST(BlockCacheTest, HandlesOnOneFileKeepTheirOwnShare) {
+  mdict::block_cache::configure_shared(4 << 20, MDICT_CACHE_TINYLFU, 0);
+  auto shared = mdict::block_cache::shared();
+  mdict::Mdict y("../testdict/testdict.mdx");
+  y.init();
+  y.use_shared_block_cache(1 << 20);
+  EXPECT_FALSE(y.lookup("cake").empty());
+  {
+    mdict::Mdict x("../testdict/testdict.mdx");
+    x.init();
+    x.use_shared_block_cache(1 << 20);
+    EXPECT_EQ(x.identity(), y.identity());
+    EXPECT_NE(x.block_cache_id(), y.block_cache_id());
+    EXPECT_FALSE(x.lookup("zoom").empty());
+  }
+  // closing x must not take y's reservation or blocks with it
+  mdict_cache_stats_t s = y.block_cache_dict_stats();
+  EXPECT_EQ(s.capacity, 1u << 20);
+  EXPECT_GE(s.entries, 2);
+  EXPECT_EQ(s.entries, shared->stats().entries);
+  EXPECT_EQ(s.misses, 2);
+  EXPECT_FALSE(y.lookup("cake").empty());
+  EXPECT_EQ(y.block_cache_dict_stats().misses, 2);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "include/hot_table.h"
+#include "include/mdict.h"
+
+static const std::vector<std::string> hot_words = {"cake", "zoom", "Satan",
+                                                   "wisdom", "tableau"};
+
+TEST(HotSetTest, LookupsSkipTheBlockCache) {
+  mdict::Mdict reference("../testdict/testdict.mdx");
+  reference.init();
+
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.set_block_cache(24 << 20);
+  dict.init();
+  ASSERT_EQ(dict.load_hot_set(hot_words), MDICT_OK);
+  EXPECT_EQ(dict.hot_set_stats().entries, hot_words.size());
+  // loading reads the blocks without caching them
+  EXPECT_EQ(dict.block_cache_stats().entries, 0u);
+
+  mdict_cache_stats_t before = dict.block_cache_stats();
+  for (const auto &word : hot_words) {
+    EXPECT_EQ(dict.lookup(word), reference.lookup(word)) << word;
+    EXPECT_EQ(dict.last_error(), MDICT_OK);
+  }
+  EXPECT_EQ(dict.lookup("CAKE"), reference.lookup("cake"));
+  mdict_cache_stats_t after = dict.block_cache_stats();
+  EXPECT_EQ(after.hits, before.hits);
+  EXPECT_EQ(after.misses, before.misses);
+  EXPECT_EQ(dict.hot_set_stats().hits, hot_words.size() + 1);
+
+  // other words take the regular path
+  EXPECT_EQ(dict.lookup("ab initio"), reference.lookup("ab initio"));
+  EXPECT_GT(dict.block_cache_stats().misses, before.misses);
+}
+
+TEST(HotSetTest, BatchAndAllLookupsUseTheHotSet) {
+  mdict::Mdict reference("../testdict/testdict.mdx");
+  reference.init();
+
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.set_block_cache(24 << 20);
+  dict.init();
+  ASSERT_EQ(dict.load_hot_set(hot_words), MDICT_OK);
+
+  mdict_cache_stats_t before = dict.block_cache_stats();
+  EXPECT_EQ(dict.lookup_batch(hot_words), reference.lookup_batch(hot_words));
+  EXPECT_EQ(dict.last_error(), MDICT_OK);
+  mdict_cache_stats_t after = dict.block_cache_stats();
+  EXPECT_EQ(after.hits + after.misses, before.hits + before.misses);
+  EXPECT_EQ(dict.hot_set_stats().hits, hot_words.size());
+
+  // the hot set holds one entry per headword, enough for "cake"
+  ASSERT_EQ(reference.lookup_all("cake").size(), 1u);
+  EXPECT_EQ(dict.lookup_all("cake"), reference.lookup_all("cake"));
+  EXPECT_EQ(dict.hot_set_stats().hits, hot_words.size() + 1);
+  EXPECT_EQ(dict.block_cache_stats().misses, after.misses);
+}
+
+TEST(HotSetTest, BudgetAndUnknownWords) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  std::string cake = dict.lookup("cake");
+  uint64_t one = mdict::hot_table::charge("cake", cake.size());
+
+  ASSERT_EQ(dict.load_hot_set({"notaword_zzzz", "cake", "zoom"}, one), MDICT_OK);
+  mdict_cache_stats_t st = dict.hot_set_stats();
+  EXPECT_EQ(st.entries, 1u);
+  EXPECT_EQ(st.bytes, one);
+  EXPECT_EQ(st.capacity, one);
+  EXPECT_EQ(dict.lookup("cake"), cake);
+  EXPECT_EQ(dict.hot_set_stats().hits, 1u);
+
+  dict.drop_hot_set();
+  EXPECT_EQ(dict.hot_set_stats().entries, 0u);
+  EXPECT_EQ(dict.lookup("cake"), cake);
+}
+
+TEST(HotSetTest, OverlayWins) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  std::string path = testing::TempDir() + "mdict_hot_set.overlay";
+  std::remove(path.c_str());
+  ASSERT_EQ(dict.load_hot_set(hot_words), MDICT_OK);
+  ASSERT_EQ(dict.attach_overlay(path), MDICT_OK);
+  ASSERT_EQ(dict.overlay()->put("cake", "edited"), MDICT_OK);
+  EXPECT_EQ(dict.lookup("cake"), "edited");
+  dict.detach_overlay();
+  std::remove(path.c_str());
+}
+
+TEST(HotSetTest, FrequencyListRoundTrip) {
+  std::string list = testing::TempDir() + "mdict_hot_list.txt";
+  {
+    std::ofstream out(list);
+    out << "zoom\t3\ncake\t10\nwisdom\t7\n";
+  }
+  std::vector<std::string> words;
+  ASSERT_EQ(mdict::hot_table::read_list(list, words), MDICT_OK);
+  EXPECT_EQ(words, (std::vector<std::string>{"cake", "wisdom", "zoom"}));
+
+  // seed the list from the definition cache of a running dictionary
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  EXPECT_EQ(dict.save_hot_list(list), MDICT_ERR_UNSUPPORTED);
+  dict.set_result_cache(1 << 20);
+  dict.lookup("zoom");
+  dict.lookup("cake");
+  ASSERT_EQ(dict.save_hot_list(list), MDICT_OK);
+  ASSERT_EQ(mdict::hot_table::read_list(list, words), MDICT_OK);
+  EXPECT_EQ(words, (std::vector<std::string>{"cake", "zoom"}));
+
+  void *next = mdict_init("../testdict/testdict.mdx");
+  ASSERT_NE(next, nullptr);
+  ASSERT_EQ(mdict_load_hot_list(next, list.c_str(), 1 << 20), MDICT_OK);
+  mdict_cache_stats_t st;
+  mdict_hot_set_stats(next, &st);
+  EXPECT_EQ(st.entries, 2u);
+  EXPECT_EQ(mdict_load_hot_list(next, "/nonexistent/list.txt", 1 << 20),
+            MDICT_ERR_IO);
+  mdict_destroy(next);
+  std::remove(list.c_str());
+}
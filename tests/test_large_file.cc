@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "include/adler32.h"
+#include "include/mdict.h"
+#include "miniz/miniz.h"
+
+// size of the stored padding resource, past the 4GB mark
+static const uint64_t pad_size = (9ULL << 30) / 2;
+// a marker written into the padding, beyond 4GB
+static const uint64_t marker_at = 4300000000ULL;
+static const std::string marker = "beyond 4GB";
+static const std::string tail = "the last resource of a large file\n";
+
+static void put_u16(std::string &out, uint16_t v) {
+  out += static_cast<char>(v >> 8);
+  out += static_cast<char>(v);
+}
+
+static void put_u32(std::string &out, uint32_t v) {
+  for (int s = 24; s >= 0; s -= 8) {
+    out += static_cast<char>(v >> s);
+  }
+}
+
+static void put_u64(std::string &out, uint64_t v) {
+  for (int s = 56; s >= 0; s -= 8) {
+    out += static_cast<char>(v >> s);
+  }
+}
+
+static std::string utf16(const std::string &ascii) {
+  std::string out;
+  for (char c : ascii) {
+    out += c;
+    out += '\0';
+  }
+  return out;
+}
+
+static uint32_t adler(const std::string &data) {
+  return adler32checksum(reinterpret_cast<const unsigned char *>(data.data()),
+                         static_cast<uint32_t>(data.size()));
+}
+
+// zlib block: type 2 | adler32 of the raw data | zlib stream
+static std::string zlib_block(const std::string &raw) {
+  mz_ulong len = mz_compressBound(raw.size());
+  std::vector<unsigned char> comp(len);
+  mz_compress(comp.data(), &len,
+              reinterpret_cast<const unsigned char *>(raw.data()), raw.size());
+  std::string out("\x02\x00\x00\x00", 4);
+  put_u32(out, adler(raw));
+  out.append(reinterpret_cast<const char *>(comp.data()), len);
+  return out;
+}
+
+/**
+ * write a version 2.0 MDD with two resources: "\a.bin", pad_size bytes in a
+ * stored record block left as a hole of the sparse file, and "\b.txt" in a
+ * zlib block behind it
+ * @return false if the file system can't hold the file
+ */
+static bool write_large_mdd(const std::string &path) {
+  std::string header = utf16(
+      "<Library_Data GeneratedByEngineVersion=\"2.0\" "
+      "RequiredEngineVersion=\"2.0\" Encrypted=\"No\" Encoding=\"\" "
+      "Format=\"\" KeyCaseSensitive=\"No\" Stripkey=\"No\" "
+      "Description=\"large\" Title=\"large\"/>\r\n");
+  header += std::string(2, '\0');
+  std::string out;
+  put_u32(out, static_cast<uint32_t>(header.size()));
+  out += header;
+  uint32_t header_sum = adler(header);
+  for (int i = 0; i < 4; i++) {
+    out += static_cast<char>(header_sum >> (8 * i));
+  }
+
+  // one key block with both keys
+  std::string keys;
+  put_u64(keys, 0);
+  keys += utf16("\\a.bin") + std::string(2, '\0');
+  put_u64(keys, pad_size);
+  keys += utf16("\\b.txt") + std::string(2, '\0');
+  std::string key_block = zlib_block(keys);
+
+  std::string info;
+  put_u64(info, 2);
+  put_u16(info, 6);
+  info += utf16("\\a.bin") + std::string(2, '\0');
+  put_u16(info, 6);
+  info += utf16("\\b.txt") + std::string(2, '\0');
+  put_u64(info, key_block.size());
+  put_u64(info, keys.size());
+  std::string info_block = zlib_block(info);
+
+  std::string key_header;
+  put_u64(key_header, 1);
+  put_u64(key_header, 2);
+  put_u64(key_header, info.size());
+  put_u64(key_header, info_block.size());
+  put_u64(key_header, key_block.size());
+  out += key_header;
+  put_u32(out, adler(key_header));
+  out += info_block + key_block;
+
+  std::string stored("\x00\x00\x00\x00\x00\x00\x00\x00", 8);
+  std::string packed = zlib_block(tail);
+  put_u64(out, 2);
+  put_u64(out, 2);
+  put_u64(out, 32);
+  put_u64(out, stored.size() + pad_size + packed.size());
+  put_u64(out, stored.size() + pad_size);
+  put_u64(out, pad_size);
+  put_u64(out, packed.size());
+  put_u64(out, tail.size());
+  out += stored;
+
+  std::ofstream f(path, std::ios::binary | std::ios::trunc);
+  f.write(out.data(), static_cast<std::streamsize>(out.size()));
+  uint64_t pad_start = out.size();
+  // everything but the marker stays a hole
+  f.seekp(static_cast<std::streamoff>(pad_start + marker_at));
+  f.write(marker.data(), static_cast<std::streamsize>(marker.size()));
+  f.seekp(static_cast<std::streamoff>(pad_start + pad_size));
+  f.write(packed.data(), static_cast<std::streamsize>(packed.size()));
+  return static_cast<bool>(f);
+}
+
+class LargeFileTest : public testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    path = testing::TempDir() + "mdict_large.mdd";
+    written = write_large_mdd(path);
+  }
+
+  static void TearDownTestSuite() { std::remove(path.c_str()); }
+
+  void SetUp() override {
+    if (!written) {
+      GTEST_SKIP() << "cannot write a sparse file larger than 4GB";
+    }
+  }
+
+  static std::string path;
+  static bool written;
+};
+
+std::string LargeFileTest::path;
+bool LargeFileTest::written = false;
+
+TEST_F(LargeFileTest, OffsetsPast4GB) {
+  ASSERT_GT(std::filesystem::file_size(path), 1ULL << 32);
+  mdict::Mdict dict(path);
+  dict.init();
+  auto keys = dict.keyList();
+  ASSERT_EQ(keys.size(), 2u);
+  EXPECT_EQ(keys[1]->record_start, pad_size);
+}
+
+TEST_F(LargeFileTest, LocateBehind4GB) {
+  mdict::Mdict dict(path);
+  dict.init();
+  std::string out;
+  ASSERT_EQ(dict.locate_stream("\\b.txt",
+                               [&](const uint8_t *data, size_t len) {
+                                 out.append(reinterpret_cast<const char *>(data),
+                                            len);
+                                 return true;
+                               }),
+            MDICT_OK);
+  EXPECT_EQ(out, tail);
+}
+
+TEST_F(LargeFileTest, RangeOfResourceLargerThan4GB) {
+  mdict::Mdict dict(path);
+  dict.init();
+  std::string out;
+  uint64_t size = 0;
+  ASSERT_EQ(dict.locate_range(
+                "\\a.bin", marker_at, marker.size(),
+                [&](const uint8_t *data, size_t len) {
+                  out.append(reinterpret_cast<const char *>(data), len);
+                  return true;
+                },
+                &size),
+            MDICT_OK);
+  EXPECT_EQ(size, pad_size);
+  EXPECT_EQ(out, marker);
+  // the stored block is read in place, not loaded
+  EXPECT_LT(dict.io_stats().bytes, 1u << 20);
+}
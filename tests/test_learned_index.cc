@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "include/learned_index.h"
+#include "include/mdict.h"
+#include "include/sidecar.h"
+
+TEST(LearnedIndexTest, PackKeepsOrder) {
+  using mdict::learned_index;
+  EXPECT_LT(learned_index::pack("a"), learned_index::pack("ab"));
+  EXPECT_LT(learned_index::pack("ab"), learned_index::pack("b"));
+  EXPECT_EQ(learned_index::pack("abcdefgh"), learned_index::pack("abcdefghij"));
+  EXPECT_EQ(learned_index::pack(""), 0u);
+}
+
+TEST(LearnedIndexTest, PredictionsWithinBound) {
+  std::mt19937_64 rng(7);
+  std::vector<uint64_t> keys(50000);
+  for (auto &k : keys) {
+    // clustered numbers with runs of duplicates
+    k = (rng() % 64) << 56 | (rng() % 1000);
+  }
+  std::sort(keys.begin(), keys.end());
+
+  for (uint32_t eps : {4u, 32u}) {
+    mdict::learned_index model;
+    model.build(keys, eps);
+    EXPECT_EQ(model.size(), keys.size());
+    EXPECT_GT(model.segment_count(), 0u);
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (i > 0 && keys[i] == keys[i - 1]) {
+        continue;
+      }
+      size_t p = model.predict(keys[i]);
+      EXPECT_LE(p > i ? p - i : i - p, eps + 1) << i;
+    }
+  }
+}
+
+TEST(LearnedIndexTest, LongSharedPrefixes) {
+  // thousands of keys with the same first 8 bytes between ordinary ones
+  std::vector<std::string> words;
+  char buf[32];
+  for (int i = 0; i < 3000; i++) {
+    snprintf(buf, sizeof(buf), "%05d", i);
+    words.push_back(std::string("pneumonoultramicroscopic") + buf);
+    words.push_back(std::string("pneumonia") + buf);
+    words.push_back(std::string(i % 26 + 1, 'a' + i % 26) + buf);
+  }
+  std::sort(words.begin(), words.end());
+  std::vector<uint64_t> keys;
+  for (const auto &w : words) {
+    keys.push_back(mdict::learned_index::pack(w));
+  }
+
+  mdict::learned_index model;
+  model.build(keys, 8);
+  EXPECT_GE(model.max_ties(), 3000u);
+  for (size_t i = 0; i < words.size(); i++) {
+    size_t lo = 0;
+    size_t hi = 0;
+    model.window(keys[i], lo, hi);
+    EXPECT_LE(lo, i) << words[i];
+    EXPECT_LT(i, hi) << words[i];
+  }
+
+  mdict::section_writer w;
+  model.serialize(w);
+  mdict::learned_index loaded;
+  mdict::section_reader r(w.data);
+  ASSERT_TRUE(loaded.deserialize(r));
+  EXPECT_EQ(loaded.max_ties(), model.max_ties());
+}
+
+TEST(LearnedIndexTest, SerializeRoundTrip) {
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 1000; i++) {
+    keys.push_back(i * i);
+  }
+  mdict::learned_index model;
+  model.build(keys, 8);
+  mdict::section_writer w;
+  model.serialize(w);
+
+  mdict::learned_index loaded;
+  mdict::section_reader r(w.data);
+  ASSERT_TRUE(loaded.deserialize(r));
+  EXPECT_EQ(loaded.segment_count(), model.segment_count());
+  EXPECT_EQ(loaded.epsilon(), 8u);
+  for (uint64_t k = 0; k < 1000 * 1000; k += 997) {
+    EXPECT_EQ(loaded.predict(k), model.predict(k));
+  }
+
+  std::string truncated = w.data.substr(0, w.data.size() - 3);
+  mdict::section_reader bad(truncated);
+  EXPECT_FALSE(loaded.deserialize(bad));
+}
+
+TEST(LearnedIndexTest, DictionaryLookupsMatchSearch) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  std::vector<std::string> words;
+  for (auto *item : dict.keyList()) {
+    words.push_back(item->key_word);
+  }
+  words.push_back("notaword_zzzz");
+  words.push_back("0000");
+
+  std::vector<long> searched;
+  for (const auto &w : words) {
+    searched.push_back(dict.lookup_key_index(w));
+  }
+  std::string cake = dict.lookup("cake");
+
+  ASSERT_EQ(dict.enable_learned_index(16, false), MDICT_OK);
+  ASSERT_NE(dict.learned_key_index(), nullptr);
+  for (size_t i = 0; i < words.size(); i++) {
+    long idx = dict.lookup_key_index(words[i]);
+    ASSERT_EQ(idx >= 0, searched[i] >= 0) << words[i];
+    if (idx >= 0) {
+      // the first of the keys equal after normalization ("arch", "arch-")
+      EXPECT_LE(idx, searched[i]) << words[i];
+      EXPECT_EQ(dict.lookup_key_index(dict.keyList()[searched[i]]->key_word),
+                idx);
+    }
+  }
+  EXPECT_EQ(dict.lookup("cake"), cake);
+  EXPECT_EQ(dict.lookup("notaword_zzzz"), "");
+  EXPECT_EQ(dict.last_error(), MDICT_ERR_NOT_FOUND);
+}
+
+TEST(LearnedIndexTest, PersistedInSidecar) {
+  std::string dir = testing::TempDir() + "mdict_sidecar_test";
+  std::filesystem::create_directories(dir);
+  std::string path = dir + "/testdict.mdx";
+  std::filesystem::copy_file("../testdict/testdict.mdx", path,
+                             std::filesystem::copy_options::overwrite_existing);
+  std::string side_path = mdict::sidecar::path_for(path);
+  std::remove(side_path.c_str());
+
+  size_t segments = 0;
+  uint64_t identity = 0;
+  {
+    mdict::Mdict dict(path);
+    dict.init();
+    ASSERT_EQ(dict.enable_learned_index(), MDICT_OK);
+    segments = dict.learned_key_index()->segment_count();
+    identity = dict.identity();
+  }
+  ASSERT_TRUE(std::filesystem::exists(side_path));
+
+  mdict::sidecar side(identity);
+  ASSERT_TRUE(side.load(side_path));
+  EXPECT_NE(side.section(mdict::learned_index::sidecar_tag), nullptr);
+  EXPECT_EQ(side.section("NONE"), nullptr);
+  // built from another file
+  mdict::sidecar other(identity + 1);
+  EXPECT_FALSE(other.load(side_path));
+
+  {
+    mdict::Mdict dict(path);
+    dict.init();
+    ASSERT_EQ(dict.enable_learned_index(), MDICT_OK);
+    EXPECT_EQ(dict.learned_key_index()->segment_count(), segments);
+    EXPECT_EQ(dict.lookup_key_index("cake") >= 0, true);
+  }
+
+  // a damaged sidecar is ignored
+  {
+    std::fstream f(side_path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(30);
+    f.put('\x7f');
+  }
+  EXPECT_FALSE(side.load(side_path));
+  std::filesystem::remove_all(dir);
+}
+
+TEST(LearnedIndexTest, IdentityFollowsTheFile) {
+  std::string dir = testing::TempDir() + "mdict_identity_test";
+  std::filesystem::create_directories(dir);
+  std::string a = dir + "/a.mdx";
+  std::string b = dir + "/b.mdx";
+  auto opts = std::filesystem::copy_options::overwrite_existing;
+  std::filesystem::copy_file("../testdict/testdict.mdx", a, opts);
+  std::filesystem::copy_file("../testdict/testdict.mdx", b, opts);
+  auto mtime = std::filesystem::last_write_time(a);
+  std::filesystem::last_write_time(b, mtime);
+
+  auto identity_of = [](const std::string &path) {
+    mdict::Mdict dict(path);
+    dict.init();
+    return dict.identity();
+  };
+  // same bytes, size and mtime under another name
+  uint64_t id = identity_of(a);
+  EXPECT_EQ(identity_of(b), id);
+
+  // same size and mtime, different content at the end of the file
+  {
+    std::fstream f(b, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekg(-1, std::ios::end);
+    char c = 0;
+    f.get(c);
+    f.seekp(-1, std::ios::end);
+    f.put(static_cast<char>(c ^ 0x55));
+  }
+  std::filesystem::last_write_time(b, mtime);
+  EXPECT_NE(identity_of(b), id);
+  std::filesystem::remove_all(dir);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "include/adler32.h"
+#include "include/lzo_wrapper.h"
+#include "include/mdict.h"
+#include "miniz/miniz.h"
+
+// version 1.2 numbers are 4 bytes, big endian
+static void put_u32(std::string &out, uint32_t v) {
+  for (int s = 24; s >= 0; s -= 8) {
+    out += static_cast<char>(v >> s);
+  }
+}
+
+static uint32_t adler(const std::string &data) {
+  return adler32checksum(reinterpret_cast<const unsigned char *>(data.data()),
+                         static_cast<uint32_t>(data.size()));
+}
+
+// type | adler32 of the raw data | data, type 0 stored, 1 lzo, 2 zlib
+static std::string block(int type, const std::string &raw) {
+  std::string body;
+  if (type == 0) {
+    body = raw;
+  } else if (type == 1) {
+    std::vector<uint8_t> comp = lzo_mem_compress(raw.data(), raw.size());
+    body.assign(comp.begin(), comp.end());
+  } else {
+    mz_ulong len = mz_compressBound(raw.size());
+    std::vector<unsigned char> comp(len);
+    mz_compress(comp.data(), &len,
+                reinterpret_cast<const unsigned char *>(raw.data()),
+                raw.size());
+    body.assign(reinterpret_cast<const char *>(comp.data()), len);
+  }
+  std::string out(1, static_cast<char>(type));
+  out += std::string(3, '\0');
+  put_u32(out, adler(raw));
+  return out + body;
+}
+
+static const std::vector<std::pair<std::string, std::string>> entries = {
+    {"apple", "<b>apple</b> a round fruit"},
+    {"banana", "<b>banana</b> a long yellow fruit"},
+    {"cherry", "<b>cherry</b> a small red fruit"},
+    {"Date", "<b>date</b> the fruit of a palm"},
+    {"date", "<b>date</b> a day of the calendar"},
+    {"elder", "<b>elder</b> a shrub"},
+    {"fig", "<b>fig</b> a soft sweet fruit"},
+};
+
+/**
+ * write a version 1.2 MDX of entries: two key blocks (lzo, zlib) behind an
+ * uncompressed key block info, two record blocks (lzo, stored)
+ */
+static void write_v1_mdx(const std::string &path) {
+  std::string header_xml =
+      "<Dictionary GeneratedByEngineVersion=\"1.2\" "
+      "RequiredEngineVersion=\"1.2\" Encrypted=\"No\" Encoding=\"UTF-8\" "
+      "Format=\"Html\" KeyCaseSensitive=\"No\" Title=\"legacy\"/>\r\n";
+  std::string header;
+  for (char c : header_xml) {
+    header += c;
+    header += '\0';
+  }
+  header += std::string(2, '\0');
+  std::string out;
+  put_u32(out, static_cast<uint32_t>(header.size()));
+  out += header;
+  uint32_t header_sum = adler(header);
+  for (int i = 0; i < 4; i++) {
+    out += static_cast<char>(header_sum >> (8 * i));
+  }
+
+  std::vector<uint32_t> offsets;
+  std::string records;
+  for (const auto &e : entries) {
+    offsets.push_back(static_cast<uint32_t>(records.size()));
+    records += e.second;
+  }
+
+  // keys 0-4 and 5-6, 1 byte key sizes, no terminator in the info
+  std::string info;
+  std::string key_blocks;
+  const size_t split = 5;
+  for (size_t b = 0; b < 2; b++) {
+    size_t first = b == 0 ? 0 : split;
+    size_t last = b == 0 ? split - 1 : entries.size() - 1;
+    std::string raw;
+    for (size_t i = first; i <= last; i++) {
+      put_u32(raw, offsets[i]);
+      raw += entries[i].first + '\0';
+    }
+    std::string kb = block(b == 0 ? 1 : 2, raw);
+    put_u32(info, static_cast<uint32_t>(last - first + 1));
+    info += static_cast<char>(entries[first].first.size());
+    info += entries[first].first;
+    info += static_cast<char>(entries[last].first.size());
+    info += entries[last].first;
+    put_u32(info, static_cast<uint32_t>(kb.size()));
+    put_u32(info, static_cast<uint32_t>(raw.size()));
+    key_blocks += kb;
+  }
+  put_u32(out, 2);
+  put_u32(out, static_cast<uint32_t>(entries.size()));
+  put_u32(out, static_cast<uint32_t>(info.size()));
+  put_u32(out, static_cast<uint32_t>(key_blocks.size()));
+  out += info + key_blocks;
+
+  // record blocks split between the "date" entries
+  size_t cut = offsets[4];
+  std::string r0 = records.substr(0, cut);
+  std::string r1 = records.substr(cut);
+  std::string rb0 = block(1, r0);
+  std::string rb1 = block(0, r1);
+  put_u32(out, 2);
+  put_u32(out, static_cast<uint32_t>(entries.size()));
+  put_u32(out, 16);
+  put_u32(out, static_cast<uint32_t>(rb0.size() + rb1.size()));
+  put_u32(out, static_cast<uint32_t>(rb0.size()));
+  put_u32(out, static_cast<uint32_t>(r0.size()));
+  put_u32(out, static_cast<uint32_t>(rb1.size()));
+  put_u32(out, static_cast<uint32_t>(r1.size()));
+  out += rb0 + rb1;
+
+  std::ofstream(path, std::ios::binary | std::ios::trunc)
+      .write(out.data(), static_cast<std::streamsize>(out.size()));
+}
+
+class LegacyFormatTest : public testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    path = testing::TempDir() + "mdict_legacy_v12.mdx";
+    write_v1_mdx(path);
+  }
+
+  static void TearDownTestSuite() { std::remove(path.c_str()); }
+
+  static std::string path;
+};
+
+std::string LegacyFormatTest::path;
+
+TEST_F(LegacyFormatTest, ReadsIndex) {
+  mdict::Mdict dict(path);
+  dict.init();
+  auto keys = dict.keyList();
+  ASSERT_EQ(keys.size(), entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    EXPECT_EQ(keys[i]->key_word, entries[i].first);
+  }
+  EXPECT_EQ(dict.entry_count(), entries.size());
+}
+
+TEST_F(LegacyFormatTest, Lookups) {
+  mdict::Mdict dict(path);
+  dict.init();
+  EXPECT_EQ(dict.lookup("apple"), entries[0].second);
+  EXPECT_EQ(dict.lookup("fig"), entries[6].second);
+  EXPECT_EQ(dict.lookup("notaword"), "");
+  EXPECT_EQ(dict.last_error(), MDICT_ERR_NOT_FOUND);
+
+  // one entry in each record block
+  auto dates = dict.lookup_all("date");
+  ASSERT_EQ(dates.size(), 2u);
+  EXPECT_EQ(dates[0].second, entries[3].second);
+  EXPECT_EQ(dates[1].second, entries[4].second);
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    std::string key;
+    std::string def;
+    ASSERT_EQ(dict.entry_at(i, key, def), MDICT_OK);
+    EXPECT_EQ(key, entries[i].first);
+    EXPECT_EQ(def, entries[i].second);
+  }
+
+  auto batch = dict.lookup_batch({"cherry", "banana", "elder"});
+  EXPECT_EQ(batch[0], entries[2].second);
+  EXPECT_EQ(batch[1], entries[1].second);
+  EXPECT_EQ(batch[2], entries[5].second);
+}
+
+TEST_F(LegacyFormatTest, LearnedIndex) {
+  mdict::Mdict dict(path);
+  dict.init();
+  ASSERT_EQ(dict.enable_learned_index(MDICT_LEARNED_INDEX_EPSILON, false),
+            MDICT_OK);
+  for (size_t i = 0; i < entries.size(); i++) {
+    long idx = dict.lookup_key_index(entries[i].first);
+    ASSERT_GE(idx, 0);
+    EXPECT_EQ(mdict::_s(dict.keyList()[idx]->key_word),
+              mdict::_s(entries[i].first));
+  }
+  EXPECT_EQ(dict.lookup("elder"), entries[5].second);
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "include/link_graph.h"
+#include "include/mdict.h"
+#include "include/sidecar.h"
+
+// a fresh copy of the test dictionary without a sidecar
+static std::string fresh_dict(const std::string &name) {
+  std::string dir = testing::TempDir() + name;
+  std::filesystem::create_directories(dir);
+  std::string path = dir + "/testdict.mdx";
+  std::filesystem::copy_file("../testdict/testdict.mdx", path,
+                             std::filesystem::copy_options::overwrite_existing);
+  std::remove(mdict::sidecar::path_for(path).c_str());
+  return path;
+}
+
+// the first entry linking to an entry of another record block
+static long cross_block_entry(mdict::Mdict &dict, std::string &target) {
+  const mdict::link_graph *g = dict.links();
+  for (uint64_t i = 0; i < g->size(); i++) {
+    auto range = g->links(i);
+    for (const uint32_t *t = range.first; t != range.second; ++t) {
+      auto from = dict.resolve_blocks(dict.keyList()[i]->key_word);
+      auto to = dict.resolve_blocks(dict.keyList()[*t]->key_word);
+      if (from.size() == 2 && to.size() == 2 &&
+          from[1].block_id != to[1].block_id) {
+        target = dict.keyList()[*t]->key_word;
+        return static_cast<long>(i);
+      }
+    }
+  }
+  return -1;
+}
+
+TEST(LinkGraphTest, Extract) {
+  std::vector<std::string> words;
+  mdict::link_graph::extract(
+      "see <a href=\"entry://run%20down\">run down</a> and "
+      "<a href='entry://cake#sense2'>cake</a>, "
+      "<a href=\"entry://cake\">again</a>",
+      words);
+  EXPECT_EQ(words, (std::vector<std::string>{"run down", "cake", "cake"}));
+
+  words.clear();
+  mdict::link_graph::extract("@@@LINK=colour \r\n\0", words);
+  EXPECT_EQ(words, (std::vector<std::string>{"colour"}));
+
+  words.clear();
+  mdict::link_graph::extract("no links <b>here</b>", words);
+  EXPECT_TRUE(words.empty());
+}
+
+TEST(LinkGraphTest, BuildAndReload) {
+  std::string path = fresh_dict("mdict_link_graph");
+  mdict::Mdict dict(path);
+  dict.init();
+  std::vector<std::string> keys;
+  EXPECT_EQ(dict.linked_keys("cake", keys), MDICT_ERR_UNSUPPORTED);
+
+  ASSERT_EQ(dict.build_link_graph(), MDICT_OK);
+  const mdict::link_graph *g = dict.links();
+  ASSERT_NE(g, nullptr);
+  EXPECT_EQ(g->size(), dict.entry_count());
+  ASSERT_GT(g->edge_count(), 0u);
+  // the pass is a scan
+  EXPECT_EQ(dict.block_cache_stats().entries, 0u);
+
+  // every target is really linked from its entry
+  std::string target;
+  long from = cross_block_entry(dict, target);
+  ASSERT_GE(from, 0);
+  std::string word = dict.keyList()[from]->key_word;
+  std::vector<std::string> found;
+  mdict::link_graph::extract(dict.lookup(word), found);
+  ASSERT_EQ(dict.linked_keys(word, keys), MDICT_OK);
+  ASSERT_FALSE(keys.empty());
+  for (const auto &k : keys) {
+    bool linked = false;
+    for (const auto &f : found) {
+      linked = linked || mdict::_s(f) == mdict::_s(k);
+    }
+    EXPECT_TRUE(linked) << k;
+  }
+
+  // the second dictionary loads the graph from the sidecar
+  mdict::Mdict again(path);
+  again.init();
+  ASSERT_EQ(again.build_link_graph(), MDICT_OK);
+  EXPECT_EQ(again.links()->edge_count(), g->edge_count());
+  // no pass over the record blocks
+  EXPECT_LT(again.io_stats().bytes, dict.io_stats().bytes);
+  std::vector<std::string> reloaded;
+  ASSERT_EQ(again.linked_keys(word, reloaded), MDICT_OK);
+  EXPECT_EQ(reloaded, keys);
+  EXPECT_EQ(again.linked_keys("notaword_zzzz", reloaded), MDICT_ERR_NOT_FOUND);
+  EXPECT_TRUE(reloaded.empty());
+}
+
+TEST(LinkGraphTest, PrefetchLinkedBlocks) {
+  std::string path = fresh_dict("mdict_link_prefetch");
+  mdict::Mdict dict(path);
+  dict.init();
+  EXPECT_EQ(dict.set_link_prefetch(true), MDICT_ERR_UNSUPPORTED);
+  ASSERT_EQ(dict.build_link_graph(), MDICT_OK);
+  EXPECT_EQ(dict.set_link_prefetch(true), MDICT_ERR_UNSUPPORTED);
+  ASSERT_EQ(dict.enable_prefetch(), MDICT_OK);
+  ASSERT_EQ(dict.set_link_prefetch(true), MDICT_OK);
+  // no key blocks on the lookup path, only record blocks are read
+  ASSERT_EQ(dict.enable_learned_index(MDICT_LEARNED_INDEX_EPSILON, false),
+            MDICT_OK);
+
+  std::string target;
+  long from = cross_block_entry(dict, target);
+  ASSERT_GE(from, 0);
+  ASSERT_TRUE(dict.find(dict.keyList()[from]->key_word).ok());
+  dict.wait_prefetch();
+  EXPECT_GE(dict.prefetch_stats().completed, 1u);
+
+  // following the link reads nothing
+  uint64_t reads = dict.io_stats().reads;
+  ASSERT_TRUE(dict.find(target).ok());
+  EXPECT_EQ(dict.io_stats().reads, reads);
+}
+
+TEST(LinkGraphTest, CApi) {
+  std::string path = fresh_dict("mdict_link_c_api");
+  void *dict = mdict_init(path.c_str());
+  ASSERT_NE(dict, nullptr);
+  char **keys = nullptr;
+  uint64_t count = 0;
+  EXPECT_EQ(mdict_linked_keys(dict, "cake", &keys, &count),
+            MDICT_ERR_UNSUPPORTED);
+  ASSERT_EQ(mdict_build_link_graph(dict), MDICT_OK);
+  auto *self = (mdict::Mdict *)dict;
+  std::string target;
+  long from = cross_block_entry(*self, target);
+  ASSERT_GE(from, 0);
+  std::string word = self->keyList()[from]->key_word;
+  ASSERT_EQ(mdict_linked_keys(dict, word.c_str(), &keys, &count), MDICT_OK);
+  EXPECT_GT(count, 0u);
+  mdict_free_strings(keys, count);
+  EXPECT_EQ(mdict_set_link_prefetch(dict, 1), MDICT_ERR_UNSUPPORTED);
+  mdict_destroy(dict);
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "include/link_rewriter.h"
+#include "include/mdict.h"
+#include "include/overlay.h"
+
+// the first entry whose definition has an entry:// link
+static std::string linking_entry(mdict::Mdict &dict) {
+  std::string key;
+  std::string def;
+  for (uint64_t i = 0; i < dict.entry_count(); i++) {
+    if (dict.entry_at(i, key, def, MDICT_ACCESS_SCAN) == MDICT_OK &&
+        def.find("entry://") != std::string::npos) {
+      return key;
+    }
+  }
+  return "";
+}
+
+TEST(LinkRewriterTest, Rewrite) {
+  mdict::link_rewriter r;
+  EXPECT_TRUE(r.empty());
+  const std::string def =
+      "<a href=\"entry://run%20down\">run down</a> "
+      "<a href=\"sound://uk/hello.mp3\">play</a> "
+      "<img src=\"img/a.png\"><IMG SRC='./b.png'> <img src=/c.png>"
+      "<link href=\"style.css\"> <a href=\"https://example.com/x.png\">web</a>"
+      "<a href=\"#top\">top</a> <img data-src=\"lazy.png\">"
+      "<img src=\"file://d.png\"> reentry://not";
+  EXPECT_EQ(r.rewrite(def), def);
+
+  r.set_prefix(MDICT_LINK_ENTRY, "/app/entry/");
+  r.set_prefix(MDICT_LINK_SOUND, "/app/sound/");
+  r.set_prefix(MDICT_LINK_RESOURCE, "/app/res/");
+  EXPECT_FALSE(r.empty());
+  EXPECT_EQ(r.rewrite(def),
+            "<a href=\"/app/entry/run%20down\">run down</a> "
+            "<a href=\"/app/sound/uk/hello.mp3\">play</a> "
+            "<img src=\"/app/res/img/a.png\"><IMG SRC='/app/res/b.png'> "
+            "<img src=/app/res/c.png>"
+            "<link href=\"/app/res/style.css\"> "
+            "<a href=\"https://example.com/x.png\">web</a>"
+            "<a href=\"#top\">top</a> <img data-src=\"lazy.png\">"
+            "<img src=\"file://d.png\"> reentry://not");
+
+  // an empty prefix drops the scheme
+  r.set_prefix(MDICT_LINK_FILE, "");
+  EXPECT_NE(r.rewrite(def).find("<img src=\"d.png\">"), std::string::npos);
+  r.clear_prefix(MDICT_LINK_RESOURCE);
+  EXPECT_EQ(r.prefix(MDICT_LINK_RESOURCE), nullptr);
+  EXPECT_NE(r.rewrite(def).find("<img src=\"img/a.png\">"), std::string::npos);
+  EXPECT_EQ(r.rewrite("@@@LINK=cake\r\n"), "@@@LINK=cake\r\n");
+}
+
+TEST(LinkRewriterTest, LookupsAreRewritten) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  dict.set_result_cache(1 << 20);
+  std::string word = linking_entry(dict);
+  ASSERT_FALSE(word.empty());
+  std::string stored = dict.lookup(word);
+  ASSERT_NE(stored.find("entry://"), std::string::npos);
+
+  mdict::link_rewriter r;
+  r.set_prefix(MDICT_LINK_ENTRY, "/app/entry/");
+  ASSERT_EQ(dict.set_link_rewriter(r), MDICT_OK);
+  std::string expected = r.rewrite(stored);
+  // the cached definition is not served any more
+  EXPECT_EQ(dict.lookup(word), expected);
+  EXPECT_EQ(dict.lookup(word), expected);
+  EXPECT_EQ(dict.find(word).value(), expected);
+  EXPECT_EQ(dict.lookup_batch({word, "cake"}).at(0), expected);
+  auto all = dict.lookup_all(word);
+  ASSERT_FALSE(all.empty());
+  for (const auto &e : all) {
+    EXPECT_EQ(e.second.find("entry://"), std::string::npos);
+  }
+
+  // an empty rewriter turns it off
+  ASSERT_EQ(dict.set_link_rewriter(mdict::link_rewriter()), MDICT_OK);
+  EXPECT_EQ(dict.link_rewriting(), nullptr);
+  EXPECT_EQ(dict.lookup(word), stored);
+
+  mdict::Mdict mdd("../testdict/testdict.mdd");
+  mdd.init();
+  EXPECT_EQ(mdd.set_link_rewriter(r), MDICT_ERR_UNSUPPORTED);
+}
+
+TEST(LinkRewriterTest, EveryDefinitionPathIsRewritten) {
+  std::string dir = testing::TempDir() + "mdict_rewrite_paths";
+  std::filesystem::create_directories(dir);
+  std::string path = dir + "/testdict.mdx";
+  std::filesystem::copy_file("../testdict/testdict.mdx", path,
+                             std::filesystem::copy_options::overwrite_existing);
+  std::remove(mdict::overlay_store::path_for(path).c_str());
+
+  mdict::Mdict dict(path);
+  dict.init();
+  std::string word = linking_entry(dict);
+  ASSERT_FALSE(word.empty());
+  mdict::link_rewriter r;
+  r.set_prefix(MDICT_LINK_ENTRY, "/app/entry/");
+  ASSERT_EQ(dict.set_link_rewriter(r), MDICT_OK);
+
+  EXPECT_EQ(dict.lookup0(word).find("entry://"), std::string::npos);
+  uint64_t record_start = 0;
+  for (auto *item : dict.keyList()) {
+    if (item->key_word == word) {
+      record_start = item->record_start;
+      break;
+    }
+  }
+  std::string parsed = dict.parse_definition(word, record_start);
+  EXPECT_EQ(parsed.find("entry://"), std::string::npos);
+  EXPECT_NE(parsed.find("/app/entry/"), std::string::npos);
+
+  ASSERT_EQ(dict.attach_overlay(), MDICT_OK);
+  ASSERT_EQ(dict.overlay()->put("cake", "<a href=\"entry://pie\">pie</a>"),
+            MDICT_OK);
+  const std::string edited = "<a href=\"/app/entry/pie\">pie</a>";
+  EXPECT_EQ(dict.lookup("cake"), edited);
+  EXPECT_EQ(dict.lookup0("cake"), edited);
+  EXPECT_EQ(dict.lookup_batch({"cake"}).at(0), edited);
+  EXPECT_EQ(dict.lookup_all("cake").at(0).second, edited);
+  EXPECT_EQ(dict.parse_definition("cake", MDICT_OVERLAY_RECORD_START), edited);
+  dict.detach_overlay();
+  std::remove(mdict::overlay_store::path_for(path).c_str());
+}
+
+TEST(LinkRewriterTest, CApi) {
+  void *dict = mdict_init("../testdict/testdict.mdx");
+  ASSERT_NE(dict, nullptr);
+  std::string word = linking_entry(*(mdict::Mdict *)dict);
+  ASSERT_FALSE(word.empty());
+  EXPECT_EQ(mdict_set_link_prefix(dict, (mdict_link_kind_t)9, "x"),
+            MDICT_ERR_INVALID_ARGUMENT);
+  ASSERT_EQ(mdict_set_link_prefix(dict, MDICT_LINK_ENTRY, "app://"), MDICT_OK);
+  char *def = nullptr;
+  ASSERT_EQ(mdict_lookup_ex(dict, word.c_str(), &def), MDICT_OK);
+  std::string rewritten(def);
+  free(def);
+  EXPECT_EQ(rewritten.find("entry://"), std::string::npos);
+  EXPECT_NE(rewritten.find("app://"), std::string::npos);
+
+  ASSERT_EQ(mdict_set_link_prefix(dict, MDICT_LINK_ENTRY, nullptr), MDICT_OK);
+  ASSERT_EQ(mdict_lookup_ex(dict, word.c_str(), &def), MDICT_OK);
+  EXPECT_NE(std::string(def).find("entry://"), std::string::npos);
+  free(def);
+  mdict_destroy(dict);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "include/mdict.h"
+#include "include/mdict_log.h"
+
+struct captured {
+  std::vector<std::string> messages;
+  std::vector<mdict_log_level_t> levels;
+};
+
+static void capture(mdict_log_level_t level, const char *message,
+                    void *user_data) {
+  auto *c = static_cast<captured *>(user_data);
+  c->messages.emplace_back(message);
+  c->levels.push_back(level);
+}
+
+TEST(LoggerTest, LevelFilter) {
+  captured c;
+  mdict::logger lg(capture, &c, MDICT_LOG_WARN);
+  MDICT_LOG(lg, MDICT_LOG_DEBUG, "dropped " << 1);
+  MDICT_LOG(lg, MDICT_LOG_ERROR, "kept " << 2);
+  ASSERT_EQ(c.messages.size(), 1);
+  EXPECT_EQ(c.messages[0], "kept 2");
+  EXPECT_EQ(c.levels[0], MDICT_LOG_ERROR);
+}
+
+TEST(LoggerTest, DisabledDoesNotEvaluate) {
+  captured c;
+  mdict::logger lg(capture, &c, MDICT_LOG_OFF);
+  int evaluated = 0;
+  auto side_effect = [&]() { return ++evaluated; };
+  MDICT_LOG(lg, MDICT_LOG_ERROR, "value " << side_effect());
+  EXPECT_EQ(evaluated, 0);
+  EXPECT_TRUE(c.messages.empty());
+}
+
+TEST(LoggerTest, RateLimit) {
+  captured c;
+  mdict::logger lg(capture, &c, MDICT_LOG_TRACE);
+  lg.set_rate_limit(3);
+  for (int i = 0; i < 100; i++) {
+    MDICT_LOG(lg, MDICT_LOG_ERROR, "storm " << i);
+  }
+  EXPECT_EQ(c.messages.size(), 3);
+}
+
+TEST(LoggerTest, LookupErrorCode) {
+  captured c;
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.set_logger(std::make_shared<mdict::logger>(capture, &c, MDICT_LOG_TRACE));
+  dict.init();
+
+  EXPECT_FALSE(dict.lookup("cake").empty());
+  EXPECT_EQ(dict.last_error(), MDICT_OK);
+
+  EXPECT_TRUE(dict.lookup("zzzzzzzzzz-not-a-word").empty());
+  EXPECT_EQ(dict.last_error(), MDICT_ERR_NOT_FOUND);
+  EXPECT_STREQ(mdict_strerror(dict.last_error()), "not found");
+}
+
+TEST(LoggerTest, DictionaryHandlerCApi) {
+  captured c;
+  EXPECT_EQ(mdict_dict_set_log_handler(nullptr, capture, &c, MDICT_LOG_TRACE),
+            MDICT_ERR_INVALID_ARGUMENT);
+
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  ASSERT_EQ(mdict_dict_set_log_handler(&dict, capture, &c, MDICT_LOG_WARN),
+            MDICT_OK);
+  EXPECT_NE(&dict.log(), &mdict::logger::global());
+  MDICT_LOG(dict.log(), MDICT_LOG_ERROR, "routed");
+  ASSERT_EQ(c.messages.size(), 1);
+  EXPECT_EQ(c.messages[0], "routed");
+
+  // NULL goes back to the process wide handler
+  ASSERT_EQ(mdict_dict_set_log_handler(&dict, nullptr, nullptr, MDICT_LOG_OFF),
+            MDICT_OK);
+  EXPECT_EQ(&dict.log(), &mdict::logger::global());
+  MDICT_LOG(dict.log(), MDICT_LOG_DEBUG, "not captured");
+  EXPECT_EQ(c.messages.size(), 1);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
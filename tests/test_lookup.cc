@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 
 #include "include/adler32.h"
 #include "include/mdict.h"
@@ -561,6 +564,423 @@ Table_SEASHELLS not found!
 tablet not found!
  */
 
+TEST(mdict, record_block_offset) {
+  auto *mydict = new mdict::Mdict("../testdict/testdict.mdx");
+  mydict->init();
+  // offset 0 is the first block, not an underflow
+  EXPECT_EQ(mydict->reduce_record_block_offset(0), 0);
+
+  // every key lands in the block whose range holds its record start
+  long previous = 0;
+  for (auto *item : mydict->keyList()) {
+    long rid = mydict->reduce_record_block_offset(item->record_start);
+    EXPECT_LE(mydict->record_block_start(rid), item->record_start);
+    EXPECT_LT(item->record_start, mydict->record_block_start(rid + 1));
+    EXPECT_GE(rid, previous);
+    previous = rid;
+  }
+  // offsets past the end clamp to the last block
+  EXPECT_EQ(mydict->reduce_record_block_offset(~0ul), previous);
+  delete mydict;
+}
+
+// the first key of each of the first record blocks, plus a missing word
+static std::vector<std::string> batch_words(mdict::Mdict &dict, size_t blocks) {
+  std::vector<std::string> words;
+  long last = -1;
+  for (auto *item : dict.keyList()) {
+    long rid = dict.reduce_record_block_offset(item->record_start);
+    if (rid != last) {
+      if (words.size() == blocks) {
+        break;
+      }
+      words.push_back(item->key_word);
+      last = rid;
+    }
+  }
+  words.push_back("notaword_zzzz");
+  return words;
+}
+
+TEST(mdict, lookup_batch) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  dict.set_block_cache(0);
+  std::vector<std::string> words = batch_words(dict, 6);
+  ASSERT_EQ(words.size(), 7u);
+
+  std::vector<std::string> expected;
+  for (const auto &w : words) {
+    expected.push_back(dict.lookup(w));
+  }
+  uint64_t reads = dict.io_stats().reads;
+  std::vector<std::string> defs = dict.lookup_batch(words);
+  // six neighbouring record blocks, one coalesced read
+  EXPECT_EQ(dict.io_stats().reads - reads, 1u);
+  EXPECT_EQ(dict.last_error(), MDICT_ERR_NOT_FOUND);
+  ASSERT_EQ(defs.size(), words.size());
+  for (size_t i = 0; i < words.size(); i++) {
+    EXPECT_EQ(defs[i], expected[i]) << words[i];
+  }
+  EXPECT_TRUE(defs.back().empty());
+}
+
+TEST(mdict, lookup_batch_without_coalescing) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  dict.set_block_cache(0);
+  dict.set_read_coalescing(0, 0);
+  std::vector<std::string> words = batch_words(dict, 6);
+  uint64_t reads = dict.io_stats().reads;
+  std::vector<std::string> defs = dict.lookup_batch(words);
+  EXPECT_EQ(dict.io_stats().reads - reads, 6u);
+  EXPECT_EQ(defs[0], dict.lookup(words[0]));
+}
+
+TEST(mdict, entry_at) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  auto keys = dict.keyList();
+  ASSERT_EQ(dict.entry_count(), keys.size());
+
+  for (uint64_t ordinal : {uint64_t(0), uint64_t(keys.size() / 2),
+                           uint64_t(keys.size() - 1)}) {
+    std::string key;
+    std::string def;
+    EXPECT_EQ(dict.key_at(ordinal, key), MDICT_OK);
+    EXPECT_EQ(key, keys[ordinal]->key_word);
+    EXPECT_EQ(dict.entry_at(ordinal, key, def), MDICT_OK);
+    EXPECT_EQ(key, keys[ordinal]->key_word);
+    EXPECT_EQ(def, dict.parse_definition(key, keys[ordinal]->record_start));
+  }
+
+  std::string key;
+  std::string def;
+  EXPECT_EQ(dict.key_at(keys.size(), key), MDICT_ERR_INVALID_ARGUMENT);
+  EXPECT_EQ(dict.entry_at(keys.size(), key, def), MDICT_ERR_INVALID_ARGUMENT);
+}
+
+TEST(mdict, entry_at_c_api) {
+  void *dict = mdict_init("../testdict/testdict.mdx");
+  ASSERT_NE(dict, nullptr);
+  uint64_t count = mdict_entry_count(dict);
+  ASSERT_GT(count, 0u);
+  char *key = nullptr;
+  char *def = nullptr;
+  EXPECT_EQ(mdict_entry_at(dict, count - 1, &key, &def), MDICT_OK);
+  ASSERT_NE(key, nullptr);
+  ASSERT_NE(def, nullptr);
+  char *only_key = nullptr;
+  EXPECT_EQ(mdict_key_at(dict, count - 1, &only_key), MDICT_OK);
+  EXPECT_STREQ(only_key, key);
+  free(key);
+  free(def);
+  free(only_key);
+  EXPECT_EQ(mdict_key_at(dict, count, &key), MDICT_ERR_INVALID_ARGUMENT);
+  EXPECT_EQ(key, nullptr);
+  mdict_destroy(dict);
+}
+
+TEST(mdict, lookup_all) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  // "arch" and "arch-" are one headword once normalized
+  auto entries = dict.lookup_all("arch");
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].first, "arch");
+  EXPECT_EQ(entries[1].first, "arch-");
+  long first = dict.lookup_key_index("arch");
+  for (size_t i = 0; i < entries.size(); i++) {
+    std::string key;
+    std::string def;
+    ASSERT_EQ(dict.entry_at(first + i, key, def), MDICT_OK);
+    EXPECT_EQ(entries[i].first, key);
+    EXPECT_EQ(entries[i].second, def);
+  }
+  EXPECT_NE(entries[0].second, entries[1].second);
+
+  auto single = dict.lookup_all("cake");
+  ASSERT_EQ(single.size(), 1u);
+  EXPECT_EQ(single[0].second, dict.lookup("cake"));
+
+  EXPECT_TRUE(dict.lookup_all("notaword_zzzz").empty());
+  EXPECT_EQ(dict.last_error(), MDICT_ERR_NOT_FOUND);
+}
+
+TEST(mdict, lookup_all_c_api) {
+  void *dict = mdict_init("../testdict/testdict.mdx");
+  ASSERT_NE(dict, nullptr);
+  char **defs = nullptr;
+  uint64_t count = 0;
+  EXPECT_EQ(mdict_lookup_all(dict, "run down", &defs, &count), MDICT_OK);
+  EXPECT_EQ(count, 2u);
+  mdict_free_strings(defs, count);
+  EXPECT_EQ(mdict_lookup_all(dict, "notaword_zzzz", &defs, &count),
+            MDICT_ERR_NOT_FOUND);
+  EXPECT_EQ(defs, nullptr);
+  EXPECT_EQ(count, 0u);
+  mdict_destroy(dict);
+}
+
+TEST(mdict, find) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  for (const char *word : {"cake", "Satan", "zoom", "tableau"}) {
+    auto def = dict.find(word);
+    ASSERT_TRUE(def.ok()) << word;
+    EXPECT_EQ(*def, dict.lookup(word));
+  }
+  auto missing = dict.find("notaword_zzzz");
+  EXPECT_FALSE(missing);
+  EXPECT_EQ(missing.error(), MDICT_ERR_NOT_FOUND);
+  EXPECT_EQ(dict.last_error(), MDICT_ERR_NOT_FOUND);
+  EXPECT_EQ(missing.value_or("none"), "none");
+}
+
+TEST(mdict, open) {
+  auto missing = mdict::Mdict::open("../testdict/no_such_dict.mdx");
+  EXPECT_EQ(missing.error(), MDICT_ERR_IO);
+  EXPECT_EQ(missing.value(), nullptr);
+
+  auto opened = mdict::Mdict::open("../testdict/testdict.mdx");
+  ASSERT_TRUE(opened.ok());
+  EXPECT_FALSE((*opened)->find("cake")->empty());
+}
+
+TEST(mdict, find_truncated_file) {
+  // a copy cut inside the last record block: the index reads, the last
+  // entries can't
+  std::string path = testing::TempDir() + "mdict_truncated.mdx";
+  {
+    std::ifstream in("../testdict/testdict.mdx", std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+    ASSERT_GT(data.size(), 256u);
+    std::ofstream(path, std::ios::binary | std::ios::trunc)
+        .write(data.data(), static_cast<std::streamsize>(data.size() - 256));
+  }
+  auto opened = mdict::Mdict::open(path);
+  ASSERT_TRUE(opened.ok());
+  mdict::Mdict &dict = **opened;
+  std::string last;
+  ASSERT_EQ(dict.key_at(dict.entry_count() - 1, last), MDICT_OK);
+  auto def = dict.find(last);
+  EXPECT_EQ(def.error(), MDICT_ERR_IO);
+  EXPECT_EQ(dict.last_error(), MDICT_ERR_IO);
+  // the first block is intact
+  EXPECT_TRUE(dict.find(dict.keyList()[0]->key_word).ok());
+  std::remove(path.c_str());
+}
+
+TEST(mdict, stream_truncated_file) {
+  std::string path = testing::TempDir() + "mdict_truncated_stream.mdx";
+  {
+    std::ifstream in("../testdict/testdict.mdx", std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+    std::ofstream(path, std::ios::binary | std::ios::trunc)
+        .write(data.data(), static_cast<std::streamsize>(data.size() - 256));
+  }
+  // stream from the file, not from a cache
+  mdict::content_store::global().set_capacity(0);
+  mdict::Mdict dict(path);
+  dict.init();
+  dict.set_block_cache(0);
+  std::string last = dict.keyList().back()->key_word;
+  std::string out;
+  auto sink = [&](const uint8_t *data, size_t len) {
+    out.append(reinterpret_cast<const char *>(data), len);
+    return true;
+  };
+  EXPECT_EQ(dict.locate_stream(last, sink), MDICT_ERR_IO);
+  EXPECT_EQ(dict.locate_range(last, 0, UINT64_MAX, sink), MDICT_ERR_IO);
+  mdict::content_store::global().set_capacity(
+      MDICT_DEFAULT_CONTENT_STORE_BYTES);
+  std::remove(path.c_str());
+}
+
+// a copy with a wrong adler32 in the header of the last record block
+static std::string write_bad_checksum_copy() {
+  std::string path = testing::TempDir() + "mdict_bad_checksum.mdx";
+  std::ifstream in("../testdict/testdict.mdx", std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+  // zlib blocks: type 2, the checksum, then the zlib header
+  size_t pos = std::string::npos;
+  for (size_t i = data.size() - 10; i > 0; i--) {
+    if (data.compare(i, 4, std::string("\x02\0\0\0", 4)) == 0 &&
+        data[i + 8] == '\x78') {
+      pos = i;
+      break;
+    }
+  }
+  if (pos == std::string::npos) {
+    return "";
+  }
+  data[pos + 4] ^= 0x5a;
+  std::ofstream(path, std::ios::binary | std::ios::trunc)
+      .write(data.data(), static_cast<std::streamsize>(data.size()));
+  return path;
+}
+
+TEST(mdict, find_bad_checksum) {
+  std::string path = write_bad_checksum_copy();
+  ASSERT_FALSE(path.empty());
+  auto opened = mdict::Mdict::open(path);
+  ASSERT_TRUE(opened.ok());
+  mdict::Mdict &dict = **opened;
+  std::string last = dict.keyList().back()->key_word;
+  EXPECT_EQ(dict.find(last).error(), MDICT_ERR_CORRUPT);
+  EXPECT_TRUE(dict.find(dict.keyList()[0]->key_word).ok());
+  std::remove(path.c_str());
+}
+
+TEST(mdict, lookup_batch_bad_block) {
+  std::string path = write_bad_checksum_copy();
+  ASSERT_FALSE(path.empty());
+  auto opened = mdict::Mdict::open(path);
+  ASSERT_TRUE(opened.ok());
+  mdict::Mdict &dict = **opened;
+  // one read for all blocks, the bad one must not fail the others
+  dict.set_read_coalescing(UINT64_MAX, UINT64_MAX);
+  std::vector<std::string> words = batch_words(dict, 3);
+  words.push_back(dict.keyList().back()->key_word);
+  std::vector<std::string> defs = dict.lookup_batch(words);
+  ASSERT_EQ(defs.size(), words.size());
+  for (size_t i = 0; i < 3; i++) {
+    EXPECT_FALSE(defs[i].empty()) << words[i];
+  }
+  EXPECT_TRUE(defs.back().empty());
+  EXPECT_EQ(dict.last_error(), MDICT_ERR_NOT_FOUND);
+  words.erase(words.begin() + 3);
+  defs = dict.lookup_batch(words);
+  EXPECT_FALSE(defs[0].empty());
+  EXPECT_TRUE(defs.back().empty());
+  EXPECT_EQ(dict.last_error(), MDICT_ERR_CORRUPT);
+  std::remove(path.c_str());
+}
+
+TEST(mdict, open_bad_key_block_info) {
+  std::string path = testing::TempDir() + "mdict_bad_info.mdx";
+  std::ifstream in("../testdict/testdict.mdx", std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+  // header length, header, adler32, the v2 key section header and its
+  // adler32, then the key block info starting with its compression type
+  ASSERT_GT(data.size(), 4u);
+  size_t header_len = (static_cast<uint8_t>(data[0]) << 24) |
+                      (static_cast<uint8_t>(data[1]) << 16) |
+                      (static_cast<uint8_t>(data[2]) << 8) |
+                      static_cast<uint8_t>(data[3]);
+  size_t pos = 4 + header_len + 4 + 40 + 4;
+  ASSERT_LT(pos + 8, data.size());
+  ASSERT_EQ(data.compare(pos, 4, std::string("\x02\0\0\0", 4)), 0);
+  data[pos + 2] = '\x01';
+  std::ofstream(path, std::ios::binary | std::ios::trunc)
+      .write(data.data(), static_cast<std::streamsize>(data.size()));
+  auto opened = mdict::Mdict::open(path);
+  EXPECT_EQ(opened.error(), MDICT_ERR_CORRUPT);
+  std::remove(path.c_str());
+}
+
+TEST(mdict, find_c_api) {
+  void *dict = nullptr;
+  EXPECT_EQ(mdict_init_ex("../testdict/no_such_dict.mdx", &dict), MDICT_ERR_IO);
+  EXPECT_EQ(dict, nullptr);
+  EXPECT_EQ(mdict_init("../testdict/no_such_dict.mdx"), nullptr);
+
+  ASSERT_EQ(mdict_init_ex("../testdict/testdict.mdx", &dict), MDICT_OK);
+  char *def = nullptr;
+  EXPECT_EQ(mdict_lookup_ex(dict, "cake", &def), MDICT_OK);
+  ASSERT_NE(def, nullptr);
+  EXPECT_STREQ(def, test_lookup("cake").c_str());
+  free(def);
+  EXPECT_EQ(mdict_lookup_ex(dict, "notaword_zzzz", &def), MDICT_ERR_NOT_FOUND);
+  EXPECT_EQ(def, nullptr);
+  EXPECT_EQ(mdict_locate_ex(dict, "notaword_zzzz", &def, MDICT_ENCODING_BASE64),
+            MDICT_ERR_NOT_FOUND);
+  EXPECT_EQ(def, nullptr);
+  mdict_destroy(dict);
+}
+
+TEST(mdict, index_window) {
+  mdict::Mdict whole("../testdict/testdict.mdx");
+  whole.set_index_window(UINT64_MAX);
+  whole.init();
+  uint64_t whole_reads = whole.io_stats().reads;
+
+  // one key block per read
+  mdict::Mdict windowed("../testdict/testdict.mdx");
+  windowed.set_index_window(0);
+  windowed.init();
+  uint64_t windowed_reads = windowed.io_stats().reads;
+  EXPECT_GT(windowed_reads, whole_reads);
+
+  ASSERT_EQ(windowed.entry_count(), whole.entry_count());
+  auto a = whole.keyList();
+  auto b = windowed.keyList();
+  for (size_t i = 0; i < a.size(); i++) {
+    ASSERT_EQ(a[i]->key_word, b[i]->key_word);
+    ASSERT_EQ(a[i]->record_start, b[i]->record_start);
+  }
+  EXPECT_EQ(windowed.lookup("cake"), whole.lookup("cake"));
+
+  // the same through the open options
+  mdict_open_options_t options;
+  mdict_open_options_init(&options);
+  EXPECT_EQ(options.index_window_bytes, MDICT_INDEX_WINDOW_BYTES);
+  options.index_window_bytes = 0;
+  auto opened = mdict::Mdict::open("../testdict/testdict.mdx", options);
+  ASSERT_TRUE(opened.ok());
+  EXPECT_EQ((*opened)->io_stats().reads, windowed_reads);
+
+  void *dict = nullptr;
+  EXPECT_EQ(mdict_init_with_options("../testdict/testdict.mdx", &options,
+                                    nullptr),
+            MDICT_ERR_INVALID_ARGUMENT);
+  ASSERT_EQ(mdict_init_with_options("../testdict/testdict.mdx", &options,
+                                    &dict),
+            MDICT_OK);
+  mdict_io_stats_t io;
+  mdict_io_stats(dict, &io);
+  EXPECT_EQ(io.reads, windowed_reads);
+  mdict_destroy(dict);
+  ASSERT_EQ(mdict_init_with_options("../testdict/testdict.mdx", nullptr,
+                                    &dict),
+            MDICT_OK);
+  mdict_io_stats(dict, &io);
+  EXPECT_LT(io.reads, windowed_reads);
+  mdict_destroy(dict);
+}
+
+TEST(mdict, reinit) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  size_t keys = dict.entry_count();
+  std::string cake = dict.lookup("cake");
+  ASSERT_FALSE(cake.empty());
+  ASSERT_EQ(dict.enable_prefetch(true), MDICT_OK);
+  ASSERT_EQ(dict.load_hot_set({"cake"}), MDICT_OK);
+  ASSERT_EQ(dict.build_link_graph(false), MDICT_OK);
+  ASSERT_EQ(dict.enable_learned_index(16, false), MDICT_OK);
+
+  // a second pass rebuilds the index instead of appending to it
+  ASSERT_NO_THROW(dict.init());
+  EXPECT_EQ(dict.entry_count(), keys);
+  EXPECT_EQ(dict.keyList().size(), keys);
+  EXPECT_EQ(dict.lookup("cake"), cake);
+  EXPECT_EQ(dict.lookup(dict.keyList().back()->key_word).empty(), false);
+  // tables built on the old index are gone, the prefetcher runs again
+  EXPECT_EQ(dict.hot_set_stats().entries, 0u);
+  EXPECT_EQ(dict.links(), nullptr);
+  EXPECT_EQ(dict.learned_key_index(), nullptr);
+  std::vector<std::string> words = batch_words(dict, 3);
+  for (size_t i = 0; i < 3; i++) {
+    EXPECT_FALSE(dict.lookup(words[i]).empty());
+  }
+  EXPECT_GT(dict.prefetch_stats().issued, 0u);
+}
+
 int main(int argc, char **argv) {
   getpwd();
 
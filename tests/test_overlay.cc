@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "include/mdict.h"
+#include "include/overlay.h"
+
+// a fresh copy of the test dictionary without an overlay
+static std::string fresh_dict(const std::string &name) {
+  std::string dir = testing::TempDir() + name;
+  std::filesystem::create_directories(dir);
+  std::string path = dir + "/testdict.mdx";
+  std::filesystem::copy_file("../testdict/testdict.mdx", path,
+                             std::filesystem::copy_options::overwrite_existing);
+  std::remove(mdict::overlay_store::path_for(path).c_str());
+  return path;
+}
+
+static bool contains(const std::vector<std::string> &words,
+                     const std::string &word) {
+  return std::find(words.begin(), words.end(), word) != words.end();
+}
+
+TEST(OverlayTest, PutOverridesAndAdds) {
+  mdict::Mdict dict(fresh_dict("mdict_overlay_put"));
+  dict.init();
+  std::string original = dict.lookup("cake");
+  ASSERT_FALSE(original.empty());
+  ASSERT_EQ(dict.attach_overlay(), MDICT_OK);
+
+  ASSERT_EQ(dict.overlay()->put("cake", "<b>edited</b>"), MDICT_OK);
+  EXPECT_EQ(dict.lookup("cake"), "<b>edited</b>");
+  EXPECT_EQ(dict.lookup("Cake"), "<b>edited</b>");
+  EXPECT_EQ(dict.lookup0("cake"), "<b>edited</b>");
+  auto all = dict.lookup_all("cake");
+  ASSERT_EQ(all.size(), 1u);
+  EXPECT_EQ(all[0].second, "<b>edited</b>");
+
+  ASSERT_EQ(dict.overlay()->put("cakewalkzz", "new entry"), MDICT_OK);
+  EXPECT_EQ(dict.lookup("cakewalkzz"), "new entry");
+  EXPECT_EQ(dict.last_error(), MDICT_OK);
+  auto suggested = dict.suggest("cake");
+  EXPECT_TRUE(contains(suggested, "cakewalkzz"));
+  EXPECT_EQ(std::count(suggested.begin(), suggested.end(), "cake"), 1);
+
+  auto merged = dict.merged_key_list();
+  EXPECT_EQ(merged.size(), dict.keyList().size() + 1);
+  auto added = std::find_if(merged.begin(), merged.end(), [](const auto &k) {
+    return k.key_word == "cakewalkzz";
+  });
+  ASSERT_NE(added, merged.end());
+  EXPECT_EQ(added->record_start, MDICT_OVERLAY_RECORD_START);
+  for (size_t i = 1; i < merged.size(); i++) {
+    EXPECT_LE(mdict::_s(merged[i - 1].key_word), mdict::_s(merged[i].key_word));
+  }
+
+  auto batch = dict.lookup_batch({"cake", "cakewalkzz"});
+  EXPECT_EQ(batch[0], "<b>edited</b>");
+  EXPECT_EQ(batch[1], "new entry");
+
+  dict.detach_overlay();
+  EXPECT_EQ(dict.lookup("cake"), original);
+}
+
+TEST(OverlayTest, RemoveHidesEntry) {
+  mdict::Mdict dict(fresh_dict("mdict_overlay_remove"));
+  dict.init();
+  ASSERT_EQ(dict.attach_overlay(), MDICT_OK);
+  ASSERT_TRUE(contains(dict.suggest("arch"), "arch"));
+
+  ASSERT_EQ(dict.overlay()->remove("arch"), MDICT_OK);
+  EXPECT_EQ(dict.lookup("arch"), "");
+  EXPECT_EQ(dict.last_error(), MDICT_ERR_NOT_FOUND);
+  EXPECT_TRUE(dict.lookup_all("arch").empty());
+  auto suggested = dict.suggest("arch");
+  EXPECT_FALSE(contains(suggested, "arch"));
+  EXPECT_FALSE(contains(suggested, "arch-"));
+  EXPECT_EQ(dict.overlay()->deleted_count(), 1u);
+
+  // a later put brings the key back
+  ASSERT_EQ(dict.overlay()->put("arch", "restored"), MDICT_OK);
+  EXPECT_EQ(dict.lookup("arch"), "restored");
+  EXPECT_EQ(dict.overlay()->deleted_count(), 0u);
+}
+
+TEST(OverlayTest, ReplayedOnReopen) {
+  std::string path = fresh_dict("mdict_overlay_replay");
+  {
+    mdict::Mdict dict(path);
+    dict.init();
+    ASSERT_EQ(dict.attach_overlay(), MDICT_OK);
+    dict.overlay()->put("cake", "first");
+    dict.overlay()->put("cake", "second");
+    dict.overlay()->remove("run down");
+  }
+  std::string log_path = mdict::overlay_store::path_for(path);
+  auto good_size = std::filesystem::file_size(log_path);
+  {
+    // torn record: a header promising more bytes than were written
+    std::ofstream out(log_path, std::ios::binary | std::ios::app);
+    out.write("\x01\x00\x00\x00\x05\x00\x00", 7);
+  }
+
+  mdict::Mdict dict(path);
+  dict.init();
+  ASSERT_EQ(dict.attach_overlay(), MDICT_OK);
+  EXPECT_EQ(std::filesystem::file_size(log_path), good_size);
+  EXPECT_EQ(dict.lookup("cake"), "second");
+  EXPECT_EQ(dict.lookup("run down"), "");
+  EXPECT_EQ(dict.overlay()->live_count(), 1u);
+  EXPECT_EQ(dict.overlay()->deleted_count(), 1u);
+}
+
+TEST(OverlayTest, RejectsForeignFile) {
+  std::string path = fresh_dict("mdict_overlay_foreign");
+  std::ofstream(mdict::overlay_store::path_for(path)) << "not an overlay";
+  mdict::Mdict dict(path);
+  dict.init();
+  EXPECT_EQ(dict.attach_overlay(), MDICT_ERR_CORRUPT);
+  EXPECT_EQ(dict.overlay(), nullptr);
+}
+
+TEST(OverlayTest, CApi) {
+  std::string path = fresh_dict("mdict_overlay_c_api");
+  void *dict = mdict_init(path.c_str());
+  ASSERT_NE(dict, nullptr);
+  EXPECT_EQ(mdict_overlay_put(dict, "cake", "x"), MDICT_ERR_UNSUPPORTED);
+  ASSERT_EQ(mdict_overlay_attach(dict, nullptr), MDICT_OK);
+  EXPECT_EQ(mdict_overlay_put(dict, "cakewalkzz", "x"), MDICT_OK);
+  EXPECT_EQ(mdict_overlay_remove(dict, "cake"), MDICT_OK);
+
+  char *words[4];
+  mdict_suggest(dict, const_cast<char *>("cake"), words, 4);
+  bool added = false;
+  for (char *w : words) {
+    if (w) {
+      EXPECT_STRNE(w, "cake");
+      added = added || std::string(w) == "cakewalkzz";
+      free(w);
+    }
+  }
+  EXPECT_TRUE(added);
+
+  uint64_t len = 0;
+  simple_key_item **items = mdict_keylist(dict, &len);
+  EXPECT_EQ(len, 15773u);  // one added, one deleted
+  free_simple_key_list(items, len);
+  delete[] items;
+  mdict_destroy(dict);
+}
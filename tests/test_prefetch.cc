@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "include/mdict.h"
+#include "include/prefetcher.h"
+
+// entries walked in dictionary order, spanning several record blocks
+static const uint64_t walk = 3000;
+
+static std::vector<std::string> walk_entries(mdict::Mdict &dict, bool forward) {
+  std::vector<std::string> defs;
+  for (uint64_t i = 0; i < walk; i++) {
+    uint64_t ordinal = forward ? i : walk - 1 - i;
+    std::string key;
+    std::string def;
+    EXPECT_EQ(dict.entry_at(ordinal, key, def), MDICT_OK);
+    defs.push_back(def);
+    // let the worker finish, the walk is as slow as a reader
+    dict.wait_prefetch();
+  }
+  return defs;
+}
+
+TEST(PrefetchTest, DetectsDirection) {
+  mdict::prefetcher p("../testdict/testdict.mdx",
+                      [](std::ifstream &, const mdict::block_key &,
+                         mdict::block_ptr &) { return MDICT_ERR_IO; });
+  ASSERT_TRUE(p.ok());
+  EXPECT_EQ(p.observe(mdict::RECORD_BLOCK, 10), 0);
+  EXPECT_EQ(p.observe(mdict::RECORD_BLOCK, 11), 0);
+  EXPECT_EQ(p.observe(mdict::RECORD_BLOCK, 11), 0);
+  EXPECT_EQ(p.observe(mdict::RECORD_BLOCK, 12), 1);
+  EXPECT_EQ(p.observe(mdict::RECORD_BLOCK, 12), 1);
+  // key blocks are tracked apart
+  EXPECT_EQ(p.observe(mdict::KEY_BLOCK, 3), 0);
+  EXPECT_EQ(p.observe(mdict::RECORD_BLOCK, 13), 1);
+  // a jump ends the run
+  EXPECT_EQ(p.observe(mdict::RECORD_BLOCK, 40), 0);
+  EXPECT_EQ(p.observe(mdict::RECORD_BLOCK, 39), 0);
+  EXPECT_EQ(p.observe(mdict::RECORD_BLOCK, 38), -1);
+}
+
+TEST(PrefetchTest, SequentialWalkHitsTheCache) {
+  mdict::Mdict plain("../testdict/testdict.mdx");
+  plain.set_block_cache(24 << 20);
+  plain.init();
+  std::vector<std::string> expected = walk_entries(plain, true);
+  uint64_t blocks = plain.block_cache_stats().misses;
+  ASSERT_GE(blocks, 4u);
+
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.set_block_cache(24 << 20);
+  dict.init();
+  ASSERT_EQ(dict.enable_prefetch(), MDICT_OK);
+  EXPECT_EQ(walk_entries(dict, true), expected);
+
+  // the first blocks establish the run, the others were prefetched
+  mdict_prefetch_stats_t st = dict.prefetch_stats();
+  EXPECT_EQ(dict.block_cache_stats().misses, MDICT_PREFETCH_MIN_RUN + 1u);
+  EXPECT_EQ(st.completed, blocks - MDICT_PREFETCH_MIN_RUN);
+  EXPECT_EQ(st.failed, 0u);
+  EXPECT_GT(st.bytes, 0u);
+}
+
+TEST(PrefetchTest, BackwardWalk) {
+  mdict::Mdict plain("../testdict/testdict.mdx");
+  plain.set_block_cache(24 << 20);
+  plain.init();
+  std::vector<std::string> expected = walk_entries(plain, false);
+
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.set_block_cache(24 << 20);
+  dict.init();
+  ASSERT_EQ(dict.enable_prefetch(), MDICT_OK);
+  EXPECT_EQ(walk_entries(dict, false), expected);
+  EXPECT_LT(dict.block_cache_stats().misses, plain.block_cache_stats().misses);
+}
+
+TEST(PrefetchTest, RandomAccessAndScansDontPrefetch) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  ASSERT_EQ(dict.enable_prefetch(), MDICT_OK);
+  uint64_t count = dict.entry_count();
+  std::string key;
+  std::string def;
+  for (uint64_t i = 0; i < 20; i++) {
+    ASSERT_EQ(dict.entry_at((i * 7919) % count, key, def), MDICT_OK);
+  }
+  for (uint64_t i = 0; i < walk; i++) {
+    ASSERT_EQ(dict.entry_at(i, key, def, MDICT_ACCESS_SCAN), MDICT_OK);
+  }
+  dict.wait_prefetch();
+  EXPECT_EQ(dict.prefetch_stats().issued, 0u);
+}
+
+TEST(PrefetchTest, NeedsTheBlockCache) {
+  void *dict = mdict_init("../testdict/testdict.mdx");
+  ASSERT_NE(dict, nullptr);
+  mdict_set_block_cache(dict, 0, MDICT_CACHE_LRU, 0);
+  EXPECT_EQ(mdict_set_prefetch(dict, 1), MDICT_ERR_UNSUPPORTED);
+  mdict_set_block_cache(dict, 8 << 20, MDICT_CACHE_LRU, 0);
+  EXPECT_EQ(mdict_set_prefetch(dict, 1), MDICT_OK);
+  mdict_prefetch_stats_t st;
+  mdict_prefetch_stats(dict, &st);
+  EXPECT_EQ(st.issued, 0u);
+  EXPECT_EQ(mdict_set_prefetch(dict, 0), MDICT_OK);
+  mdict_destroy(dict);
+}
@@ -0,0 +1,497 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "include/mdict.h"
+#include "include/resource_set.h"
+
+static std::string without_trailing_nulls(std::string s) {
+  while (!s.empty() && s.back() == '\0') {
+    s.pop_back();
+  }
+  return s;
+}
+
+static mdict_error_t stream_to_string(mdict::Mdict &dict,
+                                      const std::string &name,
+                                      std::string &out, size_t chunk,
+                                      size_t *max_piece = nullptr) {
+  out.clear();
+  return dict.locate_stream(
+      name,
+      [&](const uint8_t *data, size_t len) {
+        if (max_piece) {
+          *max_piece = std::max(*max_piece, len);
+        }
+        out.append(reinterpret_cast<const char *>(data), len);
+        return true;
+      },
+      chunk);
+}
+
+TEST(ResourceTest, StreamMatchesLookup) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  dict.set_block_cache(0);  // force the incremental inflate path
+  std::string expected = dict.lookup0("cake");
+  ASSERT_FALSE(expected.empty());
+
+  for (size_t chunk : {size_t(100), size_t(4096), size_t(1 << 20)}) {
+    std::string out;
+    size_t max_piece = 0;
+    EXPECT_EQ(stream_to_string(dict, "cake", out, chunk, &max_piece), MDICT_OK);
+    EXPECT_EQ(without_trailing_nulls(out), expected);
+    EXPECT_LE(max_piece, chunk);
+  }
+  // last key of the dictionary, its record ends with the last block
+  std::string last = dict.keyList().back()->key_word;
+  std::string out;
+  EXPECT_EQ(stream_to_string(dict, last, out, 512), MDICT_OK);
+  EXPECT_EQ(without_trailing_nulls(out), dict.lookup0(last));
+}
+
+TEST(ResourceTest, StreamFromCachedBlock) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  std::string expected = dict.lookup0("zoom");  // caches the record block
+  std::string out;
+  EXPECT_EQ(stream_to_string(dict, "zoom", out, 64), MDICT_OK);
+  EXPECT_EQ(without_trailing_nulls(out), expected);
+}
+
+TEST(ResourceTest, StreamToFd) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  FILE *tmp = tmpfile();
+  ASSERT_NE(tmp, nullptr);
+  EXPECT_EQ(dict.locate_to("cake", fileno(tmp)), MDICT_OK);
+
+  std::string written;
+  rewind(tmp);
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), tmp)) > 0) {
+    written.append(buf, n);
+  }
+  fclose(tmp);
+  EXPECT_EQ(without_trailing_nulls(written), dict.lookup0("cake"));
+}
+
+TEST(ResourceTest, StreamErrors) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  std::string out;
+  EXPECT_EQ(stream_to_string(dict, "no such resource", out, 4096),
+            MDICT_ERR_NOT_FOUND);
+  EXPECT_EQ(dict.locate_stream(
+                "cake", [](const uint8_t *, size_t) { return false; }),
+            MDICT_ERR_IO);
+  EXPECT_EQ(dict.last_error(), MDICT_ERR_IO);
+  EXPECT_EQ(dict.locate_to("cake", -1), MDICT_ERR_INVALID_ARGUMENT);
+}
+
+static mdict_error_t range_to_string(mdict::Mdict &dict, const std::string &name,
+                                     uint64_t offset, uint64_t length,
+                                     std::string &out,
+                                     uint64_t *size = nullptr) {
+  out.clear();
+  return dict.locate_range(
+      name, offset, length,
+      [&](const uint8_t *data, size_t len) {
+        out.append(reinterpret_cast<const char *>(data), len);
+        return true;
+      },
+      size);
+}
+
+TEST(ResourceTest, RangeMatchesStream) {
+  for (uint64_t cache : {uint64_t(0), uint64_t(8 << 20)}) {
+    mdict::Mdict dict("../testdict/testdict.mdx");
+    dict.init();
+    dict.set_block_cache(cache);
+    std::string whole;
+    ASSERT_EQ(stream_to_string(dict, "cake", whole, 4096), MDICT_OK);
+    ASSERT_GT(whole.size(), 20u);
+
+    std::string out;
+    uint64_t size = 0;
+    EXPECT_EQ(range_to_string(dict, "cake", 0, 10, out, &size), MDICT_OK);
+    EXPECT_EQ(size, whole.size());
+    EXPECT_EQ(out, whole.substr(0, 10));
+    EXPECT_EQ(range_to_string(dict, "cake", 5, 12, out), MDICT_OK);
+    EXPECT_EQ(out, whole.substr(5, 12));
+    // clipped to the end
+    EXPECT_EQ(range_to_string(dict, "cake", size - 3, UINT64_MAX, out),
+              MDICT_OK);
+    EXPECT_EQ(out, whole.substr(size - 3));
+    EXPECT_EQ(range_to_string(dict, "cake", size, 10, out), MDICT_OK);
+    EXPECT_TRUE(out.empty());
+    EXPECT_EQ(range_to_string(dict, "cake", size + 1, 10, out),
+              MDICT_ERR_INVALID_ARGUMENT);
+    EXPECT_EQ(range_to_string(dict, "no such resource", 0, 10, out),
+              MDICT_ERR_NOT_FOUND);
+  }
+}
+
+TEST(ResourceTest, RangeFillsBlockCache) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  std::string out;
+  ASSERT_EQ(range_to_string(dict, "zoom", 0, 8, out), MDICT_OK);
+  uint64_t entries = dict.block_cache_stats().entries;
+  EXPECT_GE(entries, 1u);
+  // the resource itself went to the content store, no block is decoded
+  uint64_t hits = mdict::content_store::global().stats().hits;
+  ASSERT_EQ(range_to_string(dict, "zoom", 4, 8, out), MDICT_OK);
+  EXPECT_EQ(mdict::content_store::global().stats().hits, hits + 1);
+  EXPECT_EQ(dict.block_cache_stats().entries, entries);
+}
+
+TEST(ResourceTest, InflateRangeResumesFromCheckpoints) {
+  // 4MB of poorly compressible data, one "record block"
+  std::vector<uint8_t> raw(4 << 20);
+  uint32_t x = 12345;
+  for (auto &b : raw) {
+    x = x * 1103515245 + 12345;
+    b = static_cast<uint8_t>((x >> 16) & 0x3f);
+  }
+  mz_ulong comp_len = mz_compressBound(raw.size());
+  std::vector<uint8_t> comp(comp_len);
+  ASSERT_EQ(mz_compress(comp.data(), &comp_len, raw.data(), raw.size()), MZ_OK);
+
+  uint64_t bytes_read = 0;
+  mdict::stream_reader read = [&](uint64_t off, uint64_t len, uint8_t *buf) {
+    memcpy(buf, comp.data() + off, len);
+    bytes_read += len;
+  };
+  std::string out;
+  mdict::stream_sink sink = [&](const uint8_t *data, size_t len) {
+    out.append(reinterpret_cast<const char *>(data), len);
+    return true;
+  };
+  mdict::inflate_checkpoints store(256 << 10, 64 << 20);
+
+  // first read decodes everything in front of the range
+  uint64_t start = 3 << 20;
+  mdict::inflate_range(read, comp_len, start, start + 1000, sink, 4096, &store,
+                       7);
+  EXPECT_EQ(out, std::string(raw.begin() + start, raw.begin() + start + 1000));
+  EXPECT_GE(store.size(), 11u);
+  EXPECT_GT(bytes_read, comp_len / 2);
+
+  // a seek close to it resumes from a checkpoint
+  out.clear();
+  bytes_read = 0;
+  uint64_t seek = start + 100000;
+  mdict::inflate_range(read, comp_len, seek, seek + 5000, sink, 4096, &store,
+                       7);
+  EXPECT_EQ(out, std::string(raw.begin() + seek, raw.begin() + seek + 5000));
+  EXPECT_LT(bytes_read, comp_len / 8);
+
+  // up to the end of the stream, then past it
+  out.clear();
+  mdict::inflate_range(read, comp_len, raw.size() - 10, raw.size(), sink, 4096,
+                       &store, 7);
+  EXPECT_EQ(out, std::string(raw.end() - 10, raw.end()));
+  EXPECT_THROW(mdict::inflate_range(read, comp_len, 0, raw.size() + 1, sink,
+                                    4096, nullptr, 0),
+               mdict::mdict_error);
+}
+
+static std::string set_stream(mdict::resource_set &set, const std::string &name,
+                              mdict_error_t *err = nullptr) {
+  std::string out;
+  mdict_error_t e = set.locate_stream(name, [&](const uint8_t *data, size_t len) {
+    out.append(reinterpret_cast<const char *>(data), len);
+    return true;
+  });
+  if (err) {
+    *err = e;
+  }
+  return out;
+}
+
+TEST(ResourceSetTest, OpensVolumesLazily) {
+  mdict::resource_set set("../testdict/testdict.mdx");
+  ASSERT_EQ(set.volume_count(), 2u);
+  EXPECT_EQ(set.volume_path(1), "../testdict/testdict.1.mdd");
+  EXPECT_EQ(set.opened_count(), 0u);
+
+  EXPECT_EQ(set_stream(set, "\\css\\style.css"), "body { color: #333; }\n");
+  EXPECT_EQ(set.opened_count(), 1u);
+
+  std::string mp3 = set_stream(set, "\\sound\\hello.mp3");
+  EXPECT_EQ(set.opened_count(), 2u);
+  EXPECT_EQ(mp3.size(), 100003u);
+  EXPECT_EQ(mp3.substr(0, 3), "ID3");
+
+  // the first volume wins
+  EXPECT_EQ(set_stream(set, "\\shared.txt"), "from volume 0\n");
+
+  mdict_error_t err = MDICT_OK;
+  EXPECT_TRUE(set_stream(set, "\\missing.png", &err).empty());
+  EXPECT_EQ(err, MDICT_ERR_NOT_FOUND);
+  EXPECT_EQ(set.last_error(), MDICT_ERR_NOT_FOUND);
+  EXPECT_FALSE(set.contains("\\missing.png"));
+  EXPECT_TRUE(set.contains("\\img\\b.png"));
+}
+
+TEST(ResourceSetTest, MatchesVolumes) {
+  mdict::resource_set set("../testdict/testdict.mdd");
+  ASSERT_EQ(set.volume_count(), 2u);
+  mdict::Mdict volume("../testdict/testdict.1.mdd");
+  volume.init();
+  EXPECT_EQ(set.locate("\\img\\b.png"), volume.locate("\\img\\b.png"));
+  EXPECT_EQ(set.last_error(), MDICT_OK);
+
+  std::string whole = set_stream(set, "\\sound\\hello.mp3");
+  std::string out;
+  uint64_t size = 0;
+  EXPECT_EQ(set.locate_range(
+                "\\sound\\hello.mp3", 70000, 1234,
+                [&](const uint8_t *data, size_t len) {
+                  out.append(reinterpret_cast<const char *>(data), len);
+                  return true;
+                },
+                &size),
+            MDICT_OK);
+  EXPECT_EQ(size, whole.size());
+  EXPECT_EQ(out, whole.substr(70000, 1234));
+  // the volumes share one block cache
+  EXPECT_GE(set.block_cache_stats().entries, 1u);
+}
+
+TEST(ResourceSetTest, CApi) {
+  EXPECT_EQ(mdict_resource_set_open("../testdict/nothing.mdx"), nullptr);
+  void *set = mdict_resource_set_open("../testdict/testdict.mdx");
+  ASSERT_NE(set, nullptr);
+  int volumes = 0;
+  EXPECT_EQ(mdict_resource_set_volumes(set, &volumes), MDICT_OK);
+  EXPECT_EQ(volumes, 2);
+  EXPECT_EQ(mdict_resource_set_volumes(nullptr, &volumes),
+            MDICT_ERR_INVALID_ARGUMENT);
+  EXPECT_EQ(mdict_resource_set_volumes(set, nullptr),
+            MDICT_ERR_INVALID_ARGUMENT);
+  char *result = nullptr;
+  EXPECT_EQ(mdict_resource_set_locate(nullptr, "\\css\\style.css", &result,
+                                      MDICT_ENCODING_BASE64),
+            MDICT_ERR_INVALID_ARGUMENT);
+  EXPECT_EQ(result, nullptr);
+  EXPECT_EQ(mdict_resource_set_locate(set, nullptr, &result,
+                                      MDICT_ENCODING_BASE64),
+            MDICT_ERR_INVALID_ARGUMENT);
+  EXPECT_EQ(mdict_resource_set_locate(set, "\\css\\style.css", nullptr,
+                                      MDICT_ENCODING_BASE64),
+            MDICT_ERR_INVALID_ARGUMENT);
+  EXPECT_EQ(mdict_resource_set_locate(set, "\\css\\style.css", &result,
+                                      MDICT_ENCODING_BASE64),
+            MDICT_OK);
+  ASSERT_NE(result, nullptr);
+  EXPECT_GT(strlen(result), 0u);
+  free(result);
+  EXPECT_EQ(mdict_resource_set_last_error(set), MDICT_OK);
+  mdict_resource_set_close(set);
+}
+
+TEST(ResourceTest, ResourceNames) {
+  std::vector<std::string> names = mdict::Mdict::resource_names(
+      "<link rel=\"stylesheet\" href=\"style.css\">"
+      "<img src=\"img/a.png\"> <IMG SRC='./img/b.png?v=2'>"
+      "<a href=\"sound://hello.mp3\">play</a>"
+      "<a href=\"entry://cake\">cake</a> <a href=\"https://example.com\">web</a>"
+      "<img data-src=\"lazy.png\"> <img src=\"/img/a.png\"> <img src=x.gif>");
+  EXPECT_EQ(names, (std::vector<std::string>{"\\style.css", "\\img\\a.png",
+                                             "\\img\\b.png", "\\hello.mp3",
+                                             "\\x.gif"}));
+  EXPECT_TRUE(mdict::Mdict::resource_names("no resources").empty());
+}
+
+TEST(ResourceTest, BatchMatchesStream) {
+  mdict::Mdict dict("../testdict/testdict.1.mdd");
+  dict.init();
+  std::vector<std::string> names = {"\\img\\b.png", "\\sound\\hello.mp3",
+                                    "\\missing.png", "\\shared.txt"};
+  std::vector<mdict::resource_payload> out;
+  uint64_t reads = dict.io_stats().reads;
+  EXPECT_EQ(dict.locate_batch(names, out), MDICT_ERR_NOT_FOUND);
+  EXPECT_EQ(dict.last_error(), MDICT_ERR_NOT_FOUND);
+  uint64_t batch_reads = dict.io_stats().reads - reads;
+  ASSERT_EQ(out.size(), names.size());
+  EXPECT_EQ(out[2].name, "\\missing.png");
+  EXPECT_EQ(out[2].err, MDICT_ERR_NOT_FOUND);
+  EXPECT_TRUE(out[2].data.empty());
+  for (size_t i : {size_t(0), size_t(1), size_t(3)}) {
+    EXPECT_EQ(out[i].name, names[i]);
+    EXPECT_EQ(out[i].err, MDICT_OK);
+    std::string streamed;
+    ASSERT_EQ(stream_to_string(dict, names[i], streamed, 4096), MDICT_OK);
+    EXPECT_EQ(out[i].data, streamed);
+  }
+
+  // every block is read once, neighbours with one read
+  mdict::Mdict single("../testdict/testdict.1.mdd");
+  single.init();
+  single.set_block_cache(0);
+  reads = single.io_stats().reads;
+  for (size_t i : {size_t(0), size_t(1), size_t(3)}) {
+    single.locate(names[i]);
+  }
+  EXPECT_LE(batch_reads, single.io_stats().reads - reads);
+}
+
+TEST(ResourceTest, KeyIndexFromThreads) {
+  mdict::Mdict dict("../testdict/testdict.1.mdd");
+  EXPECT_EQ(dict.find_key_index("\\img\\b.png"), -1);
+  dict.init();
+  const auto &keys = dict.keyList();
+  // the first lookups race to build the hash
+  std::vector<std::thread> workers;
+  std::vector<int> wrong(4, 0);
+  for (size_t t = 0; t < wrong.size(); t++) {
+    workers.emplace_back([&, t]() {
+      for (size_t i = 0; i < keys.size(); i++) {
+        long idx = dict.find_key_index(keys[i]->key_word);
+        if (idx < 0 || keys[idx]->key_word != keys[i]->key_word) {
+          wrong[t]++;
+        }
+      }
+    });
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+  for (int n : wrong) {
+    EXPECT_EQ(n, 0);
+  }
+  EXPECT_EQ(dict.find_key_index("\\missing.png"), -1);
+}
+
+TEST(ResourceSetTest, Batch) {
+  mdict::resource_set set("../testdict/testdict.mdx");
+  std::vector<std::string> names = {"\\sound\\hello.mp3", "\\css\\style.css",
+                                    "\\shared.txt"};
+  std::vector<mdict::resource_payload> out;
+  ASSERT_EQ(set.locate_batch(names, out), MDICT_OK);
+  EXPECT_EQ(set.opened_count(), 2u);
+  ASSERT_EQ(out.size(), names.size());
+  EXPECT_EQ(out[0].data, set_stream(set, names[0]));
+  EXPECT_EQ(out[1].data, "body { color: #333; }\n");
+  // the first volume wins
+  EXPECT_EQ(out[2].data, "from volume 0\n");
+
+  char **refs = nullptr;
+  uint64_t count = 0;
+  ASSERT_EQ(mdict_resource_names(
+                "<img src=\"img/b.png\"><link href=\"css/style.css\">"
+                "<img src=\"img/none.png\">",
+                &refs, &count),
+            MDICT_OK);
+  ASSERT_EQ(count, 3u);
+  void *handle = mdict_resource_set_open("../testdict/testdict.mdx");
+  ASSERT_NE(handle, nullptr);
+  mdict_resource_t *resources = nullptr;
+  EXPECT_EQ(mdict_resource_set_locate_batch(handle, (const char **)refs, count,
+                                            &resources),
+            MDICT_ERR_NOT_FOUND);
+  ASSERT_NE(resources, nullptr);
+  EXPECT_STREQ(resources[0].name, "\\img\\b.png");
+  EXPECT_EQ(resources[0].error, MDICT_OK);
+  EXPECT_EQ(std::string((const char *)resources[0].data, resources[0].size),
+            set_stream(set, "\\img\\b.png"));
+  EXPECT_EQ(std::string((const char *)resources[1].data, resources[1].size),
+            "body { color: #333; }\n");
+  EXPECT_EQ(resources[2].error, MDICT_ERR_NOT_FOUND);
+  EXPECT_EQ(resources[2].data, nullptr);
+  mdict_free_resources(resources, count);
+  mdict_free_strings(refs, count);
+  mdict_resource_set_close(handle);
+}
+
+static std::string ripemd128_hex(const std::string &s, size_t step) {
+  mdict::content_hasher hasher;
+  for (size_t pos = 0; pos < s.size(); pos += step) {
+    size_t n = std::min(step, s.size() - pos);
+    hasher.update(reinterpret_cast<const uint8_t *>(s.data()) + pos, n);
+  }
+  return mdict::content_hash_hex(hasher.finish());
+}
+
+TEST(ContentHashTest, KnownVectors) {
+  EXPECT_EQ(ripemd128_hex("", 1), "cdf26213a150dc3ecb610f18f6b38b46");
+  EXPECT_EQ(ripemd128_hex("abc", 1), "c14a12199c66e4ba84636b0f69144c77");
+  for (size_t step : {size_t(1), size_t(7), size_t(64), size_t(1000)}) {
+    EXPECT_EQ(ripemd128_hex("message digest", step),
+              "9e327b3d6e523062afc1132d7df9d1b8");
+    EXPECT_EQ(ripemd128_hex(std::string(1000000, 'a'), step * 997),
+              "4a7f5723f954eba1216c9d8f6320431f");
+  }
+}
+
+TEST(ContentHashTest, SharedResourcesAreStoredOnce) {
+  mdict::content_store::global().set_capacity(0);  // drop earlier entries
+  mdict::content_store::global().set_capacity(MDICT_DEFAULT_CONTENT_STORE_BYTES);
+
+  mdict::Mdict first("../testdict/testdict.mdd");
+  first.init();
+  mdict::Mdict second("../testdict/testdict.1.mdd");
+  second.init();
+
+  std::string h1;
+  std::string h2;
+  ASSERT_EQ(first.resource_hash("\\font\\common.woff", h1), MDICT_OK);
+  ASSERT_EQ(second.resource_hash("\\font\\common.woff", h2), MDICT_OK);
+  EXPECT_EQ(h1.size(), 32u);
+  EXPECT_EQ(h1, h2);
+  std::string other;
+  ASSERT_EQ(second.resource_hash("\\shared.txt", other), MDICT_OK);
+  EXPECT_NE(other, h1);
+  EXPECT_EQ(first.resource_hash("\\missing", other), MDICT_ERR_NOT_FOUND);
+
+  std::string a;
+  std::string b;
+  ASSERT_EQ(stream_to_string(first, "\\font\\common.woff", a, 4096), MDICT_OK);
+  EXPECT_EQ(mdict::content_store::global().stats().entries, 1u);
+  uint64_t hits = mdict::content_store::global().stats().hits;
+  // same content from another file: served from the store, stored once
+  ASSERT_EQ(stream_to_string(second, "\\font\\common.woff", b, 4096),
+            MDICT_OK);
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(mdict::content_store::global().stats().entries, 1u);
+  EXPECT_EQ(mdict::content_store::global().stats().hits, hits + 1);
+
+  // ranges are sliced from the stored copy as well
+  std::string part;
+  ASSERT_EQ(range_to_string(second, "\\font\\common.woff", 10, 100, part),
+            MDICT_OK);
+  EXPECT_EQ(part, a.substr(10, 100));
+}
+
+TEST(ContentHashTest, StreamingHashesLargeResources) {
+  mdict::Mdict dict("../testdict/testdict.1.mdd");
+  dict.init();
+  EXPECT_EQ(dict.index_resource_hashes(), MDICT_OK);
+  std::string indexed;
+  ASSERT_EQ(dict.resource_hash("\\sound\\hello.mp3", indexed), MDICT_OK);
+
+  mdict::Mdict fresh("../testdict/testdict.1.mdd");
+  fresh.init();
+  std::string mp3;
+  ASSERT_EQ(stream_to_string(fresh, "\\sound\\hello.mp3", mp3, 4096), MDICT_OK);
+  std::string streamed;
+  ASSERT_EQ(fresh.resource_hash("\\sound\\hello.mp3", streamed), MDICT_OK);
+  EXPECT_EQ(streamed, indexed);
+  EXPECT_EQ(streamed, ripemd128_hex(mp3, 4096));
+
+  char hex[33];
+  EXPECT_EQ(mdict_resource_hash(&fresh, "\\sound\\hello.mp3", hex), MDICT_OK);
+  EXPECT_EQ(std::string(hex), indexed);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
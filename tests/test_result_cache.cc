@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "include/mdict.h"
+#include "include/result_cache.h"
+
+using mdict::result_cache;
+
+static std::string key(const std::string &q) {
+  return result_cache::make_key(result_cache::LOOKUP, q);
+}
+
+TEST(ResultCacheTest, HitAndMiss) {
+  result_cache c(1 << 20, MDICT_CACHE_LRU);
+  std::string out;
+  EXPECT_FALSE(c.get(key("cake"), out));
+  c.put(key("cake"), "definition");
+  EXPECT_TRUE(c.get(key("cake"), out));
+  EXPECT_EQ(out, "definition");
+  // kinds do not collide
+  EXPECT_FALSE(
+      c.get(result_cache::make_key(result_cache::LOOKUP_EXACT, "cake"), out));
+
+  mdict_cache_stats_t st = c.stats();
+  EXPECT_EQ(st.hits, 1);
+  EXPECT_EQ(st.misses, 2);
+  EXPECT_EQ(st.entries, 1);
+}
+
+TEST(ResultCacheTest, LruEvictsLeastRecent) {
+  // room for two entries of ~200 bytes each
+  result_cache c(600, MDICT_CACHE_LRU);
+  std::string value(200, 'x');
+  std::string out;
+  c.put(key("a"), value);
+  c.put(key("b"), value);
+  EXPECT_TRUE(c.get(key("a"), out));  // a is now the most recent
+  c.put(key("c"), value);
+  EXPECT_TRUE(c.get(key("a"), out));
+  EXPECT_FALSE(c.get(key("b"), out));
+  EXPECT_TRUE(c.get(key("c"), out));
+  EXPECT_LE(c.stats().bytes, 600);
+}
+
+TEST(ResultCacheTest, ClockGivesSecondChance) {
+  result_cache c(600, MDICT_CACHE_CLOCK);
+  std::string value(200, 'x');
+  std::string out;
+  c.put(key("a"), value);
+  c.put(key("b"), value);
+  EXPECT_TRUE(c.get(key("a"), out));  // a is referenced
+  c.put(key("c"), value);
+  EXPECT_TRUE(c.get(key("a"), out));
+  EXPECT_FALSE(c.get(key("b"), out));
+}
+
+TEST(ResultCacheTest, RebindDropsEntries) {
+  result_cache c(1 << 20, MDICT_CACHE_LRU);
+  std::string out;
+  c.bind(1);
+  c.put(key("a"), "1");
+  c.bind(1);
+  EXPECT_TRUE(c.get(key("a"), out));
+  c.bind(2);
+  EXPECT_FALSE(c.get(key("a"), out));
+}
+
+TEST(ResultCacheTest, DictionaryLookup) {
+  mdict::Mdict dict("../testdict/testdict.mdx");
+  dict.init();
+  std::string expected = dict.lookup("cake");
+  ASSERT_FALSE(expected.empty());
+
+  dict.set_result_cache(1 << 20, MDICT_CACHE_CLOCK);
+  EXPECT_EQ(dict.lookup("cake"), expected);
+  // same normalized query, answered from the cache
+  EXPECT_EQ(dict.lookup("Cake"), expected);
+  EXPECT_EQ(dict.last_error(), MDICT_OK);
+
+  mdict_cache_stats_t st = dict.result_cache_stats();
+  EXPECT_EQ(st.hits, 1);
+  EXPECT_EQ(st.misses, 1);
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}